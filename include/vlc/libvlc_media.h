@@ -139,6 +139,23 @@ typedef struct libvlc_media_stats_t
     float       f_send_bitrate;
 } libvlc_media_stats_t;
 
+#define LIBVLC_MEDIA_LATENCY_BUCKETS 12
+
+/**
+ * Latency histograms: bucket 0 counts the occurrences below 1 ms, bucket i
+ * those from 2^(i-1) to 2^i ms, and the last bucket all the longer ones.
+ */
+typedef struct libvlc_media_latency_t
+{
+    /** time each block waits in the decoder queue, measured as the stream
+     * duration queued in front of it */
+    int64_t     i_queue[LIBVLC_MEDIA_LATENCY_BUCKETS];
+    /** time spent decoding each block of audio or video */
+    int64_t     i_decode[LIBVLC_MEDIA_LATENCY_BUCKETS];
+    /** time between the decoding and the display date of each picture */
+    int64_t     i_display[LIBVLC_MEDIA_LATENCY_BUCKETS];
+} libvlc_media_latency_t;
+
 typedef struct libvlc_media_track_info_t
 {
     /* Codec fourcc */
@@ -629,6 +646,19 @@ LIBVLC_API libvlc_state_t libvlc_media_get_state(
 LIBVLC_API int libvlc_media_get_stats( libvlc_media_t *p_md,
                                            libvlc_media_stats_t *p_stats );
 
+/**
+ * Get the latency histograms of the media, since it was last played
+ * \param p_md: media descriptor object
+ * \param p_latency: structure filled with the histograms
+ *                   (this structure must be allocated by the caller)
+ * \return true if the statistics are available, false otherwise
+ *
+ * \version LibVLC 3.0.0 and later.
+ * \libvlc_return_bool
+ */
+LIBVLC_API int libvlc_media_get_latency( libvlc_media_t *p_md,
+                                         libvlc_media_latency_t *p_latency );
+
 /* The following method uses libvlc_media_list_t, however, media_list usage is optionnal
  * and this is here for convenience */
 #define VLC_FORWARD_DECLARE_OBJECT(a) struct a
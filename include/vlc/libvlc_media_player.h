@@ -444,6 +444,37 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
                                         libvlc_video_format_cb setup,
                                         libvlc_video_cleanup_cb cleanup );
 
+/**
+ * Render the decoded video directly into a pool of application buffers,
+ * instead of copying each picture into a locked buffer. This only works in
+ * combination with libvlc_video_set_callbacks().
+ *
+ * The lock callback is invoked whenever a picture of the pool is used, and
+ * the decoders, filters and converters then write into the locked buffer.
+ * The unlock callback is invoked once that picture is no longer used. Up to
+ * count buffers can thus be locked at the same time. The display callback
+ * gets the buffer of the picture to show, which stays locked until the next
+ * picture is shown or the video output stops.
+ *
+ * \warning In this mode, the lock and unlock callbacks are no longer invoked
+ * only from the video output thread: they are also invoked from the decoder
+ * and filter threads, possibly several at the same time. They must therefore
+ * be thread-safe and reentrant.
+ *
+ * Every plane must be aligned on 32 bytes, and the pitches must be multiple
+ * of 32. Otherwise, LibVLC falls back to copying the pictures (if the
+ * buffers checked when the video output starts do not fit) or drops the
+ * picture.
+ *
+ * \param mp the media player
+ * \param count number of buffers, or 0 to copy the pictures (with
+ *              libvlc_video_set_format_callbacks(), the number of buffers is
+ *              the one returned by the format callback instead)
+ * \version LibVLC 3.0.0 or later
+ */
+LIBVLC_API
+void libvlc_video_set_buffer_pool( libvlc_media_player_t *mp, unsigned count );
+
 /**
  * Set the NSView handler where the media player should render its video output.
  *
@@ -464,6 +464,22 @@ VLC_API video_transform_t video_format_GetTransform(video_orientation_t src, vid
  */
 VLC_API bool video_format_IsSimilar( const video_format_t *, const video_format_t * );
 
+/**
+ * This function will check if pictures allocated for the first video format
+ * can be reused for the second one, that is if the formats are similar and
+ * share the same colorimetry and projection.
+ */
+static inline bool video_format_IsSamePool( const video_format_t *a,
+                                            const video_format_t *b )
+{
+    return video_format_IsSimilar( a, b )
+        && a->primaries == b->primaries && a->transfer == b->transfer
+        && a->space == b->space
+        && a->b_color_range_full == b->b_color_range_full
+        && a->chroma_location == b->chroma_location
+        && a->projection_mode == b->projection_mode;
+}
+
 /**
  * It prints details about the given video_format_t
  */
@@ -398,6 +398,8 @@ VLC_API void libvlc_MetadataCancel( libvlc_int_t *, void * );
 /******************
  * Input stats
  ******************/
+#define INPUT_STATS_LATENCY_BUCKETS 12
+
 struct input_stats_t
 {
     vlc_mutex_t         lock;
@@ -432,6 +434,19 @@ struct input_stats_t
     /* Aout */
     int64_t i_played_abuffers;
     int64_t i_lost_abuffers;
+
+    /* Threads reserved by the decoders and encoders of the instance,
+     * see vlc_ReserveCPUs() */
+    int64_t i_reserved_threads;
+    int64_t i_threads_budget;
+
+    /* Latencies: bucket 0 counts those below 1 ms, bucket i those from
+     * 2^(i-1) to 2^i ms, and the last one all the longer ones */
+    int64_t i_queue_latency[INPUT_STATS_LATENCY_BUCKETS]; /**< in the
+        decoder fifo */
+    int64_t i_decode_latency[INPUT_STATS_LATENCY_BUCKETS]; /**< decoding */
+    int64_t i_display_latency[INPUT_STATS_LATENCY_BUCKETS]; /**< from the
+        decoder output to the display date */
 };
 
 #endif
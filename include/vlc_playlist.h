@@ -94,7 +94,8 @@ struct intf_thread_t;
  * existing input items to be placed under any node with
  * playlist_NodeAddInput().
  *
- * To delete an item, use playlist_NodeDelete( p_item ).
+ * To delete an item, use playlist_NodeDelete( p_item ), or
+ * playlist_NodesDelete() to delete many items at once.
  *
  * The playlist defines the following event variables:
  *
@@ -383,6 +384,7 @@ VLC_API int playlist_LiveSearchUpdate(playlist_t *, playlist_item_t *, const cha
 VLC_API playlist_item_t * playlist_NodeCreate( playlist_t *, const char *, playlist_item_t * p_parent, int i_pos, int i_flags );
 VLC_API playlist_item_t * playlist_ChildSearchName(playlist_item_t*, const char* ) VLC_USED;
 VLC_API void playlist_NodeDelete( playlist_t *, playlist_item_t *, bool );
+VLC_API void playlist_NodesDelete( playlist_t *, playlist_item_t *const *, size_t, bool );
 
 /**************************
  * Audio output management
@@ -946,6 +946,27 @@ VLC_API unsigned vlc_timer_getoverrun(vlc_timer_t) VLC_USED;
  */
 VLC_API unsigned vlc_GetCPUCount(void);
 
+/**
+ * Reserves worker threads from the CPU budget of the instance.
+ *
+ * Decoders and encoders running in parallel share that budget instead of
+ * each one using all the CPUs. The share depends on how many threads are
+ * already reserved when the caller starts: it never exceeds what is left
+ * of the budget, except for the one thread every caller gets.
+ *
+ * \param wanted number of threads the caller would use on its own
+ * \return number of threads to use (at least 1, at most wanted),
+ * to be given back with vlc_ReleaseCPUs()
+ */
+VLC_API unsigned vlc_ReserveCPUs(vlc_object_t *, unsigned wanted) VLC_USED;
+#define vlc_ReserveCPUs(o, n) vlc_ReserveCPUs(VLC_OBJECT(o), n)
+
+/**
+ * Gives back threads reserved with vlc_ReserveCPUs().
+ */
+VLC_API void vlc_ReleaseCPUs(vlc_object_t *, unsigned count);
+#define vlc_ReleaseCPUs(o, n) vlc_ReleaseCPUs(VLC_OBJECT(o), n)
+
 enum
 {
     VLC_CLEANUP_PUSH,
@@ -0,0 +1,88 @@
+/*****************************************************************************
+ * vlc_thumbnail.h: thumbnail extraction
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_THUMBNAIL_H
+#define VLC_THUMBNAIL_H 1
+
+#include <vlc_es.h>
+#include <vlc_block.h>
+
+/**
+ * \file
+ * This file defines functions to extract encoded thumbnails from media
+ * without a player nor a video output
+ */
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/**
+ * Thumbnails to extract from one media
+ */
+typedef struct vlc_thumbnail_job_t
+{
+    const char    *psz_url;     /**< MRL of the media */
+    const mtime_t *pi_times;    /**< times of the thumbnails, in any order */
+    size_t         i_times;     /**< number of times */
+
+    /** i_times encoded images, in the order of pi_times, or NULL for
+     * the times at which no picture could be extracted (allocated by the
+     * extraction: the images are released with block_Release, then the
+     * array with free) */
+    block_t      **pp_images;
+    size_t         i_images;    /**< number of images extracted */
+} vlc_thumbnail_job_t;
+
+/**
+ * Extracts thumbnails from one media.
+ *
+ * For each time, the media is seeked to the closest keyframe before it
+ * and only that picture is decoded, then scaled and encoded.
+ *
+ * \param p_fmt i_chroma is the image codec (VLC_CODEC_PNG, VLC_CODEC_JPEG),
+ * i_width and i_height the size of the images: if only one is set, the
+ * other follows the aspect ratio of the video, if none is, the video size
+ * is kept
+ * \return VLC_SUCCESS if the media could be opened, an error otherwise
+ */
+VLC_API int vlc_thumbnail_Extract( vlc_object_t *, vlc_thumbnail_job_t *,
+                                   const video_format_t *p_fmt );
+#define vlc_thumbnail_Extract(a, b, c) \
+    vlc_thumbnail_Extract(VLC_OBJECT(a), b, c)
+
+/**
+ * Extracts thumbnails from several media, with i_workers threads each
+ * handling one media at a time (0 for one thread per CPU).
+ *
+ * Each job is completed as with vlc_thumbnail_Extract().
+ */
+VLC_API void vlc_thumbnail_ExtractMany( vlc_object_t *,
+                                        vlc_thumbnail_job_t *, size_t i_jobs,
+                                        const video_format_t *p_fmt,
+                                        unsigned i_workers );
+#define vlc_thumbnail_ExtractMany(a, b, c, d, e) \
+    vlc_thumbnail_ExtractMany(VLC_OBJECT(a), b, c, d, e)
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif /* VLC_THUMBNAIL_H */
@@ -723,6 +723,27 @@ int libvlc_media_get_stats( libvlc_media_t *p_md,
     return true;
 }
 
+int libvlc_media_get_latency( libvlc_media_t *p_md,
+                              libvlc_media_latency_t *p_latency )
+{
+    static_assert( LIBVLC_MEDIA_LATENCY_BUCKETS == INPUT_STATS_LATENCY_BUCKETS,
+                   "Mismatched latency histograms" );
+
+    if( !p_md->p_input_item )
+        return false;
+
+    input_stats_t *p_itm_stats = p_md->p_input_item->p_stats;
+    vlc_mutex_lock( &p_itm_stats->lock );
+    for( int i = 0; i < LIBVLC_MEDIA_LATENCY_BUCKETS; i++ )
+    {
+        p_latency->i_queue[i] = p_itm_stats->i_queue_latency[i];
+        p_latency->i_decode[i] = p_itm_stats->i_decode_latency[i];
+        p_latency->i_display[i] = p_itm_stats->i_display_latency[i];
+    }
+    vlc_mutex_unlock( &p_itm_stats->lock );
+    return true;
+}
+
 /**************************************************************************
  * event_manager
  **************************************************************************/
@@ -619,6 +619,7 @@ libvlc_media_player_new( libvlc_instance_t *instance )
     var_Create (mp, "vmem-width", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-height", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "vmem-pitch", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
+    var_Create (mp, "vmem-pool", VLC_VAR_INTEGER | VLC_VAR_DOINHERIT);
     var_Create (mp, "avcodec-hw", VLC_VAR_STRING);
     var_Create (mp, "drawable-xid", VLC_VAR_INTEGER);
 #if defined (_WIN32) || defined (__OS2__)
@@ -1099,6 +1100,11 @@ void libvlc_video_set_format_callbacks( libvlc_media_player_t *mp,
     var_SetAddress( mp, "vmem-cleanup", cleanup );
 }
 
+void libvlc_video_set_buffer_pool( libvlc_media_player_t *mp, unsigned count )
+{
+    var_SetInteger( mp, "vmem-pool", count );
+}
+
 void libvlc_video_set_format( libvlc_media_player_t *mp, const char *chroma,
                               unsigned width, unsigned height, unsigned pitch )
 {
@@ -0,0 +1,119 @@
+/*****************************************************************************
+ * channel_groups.c: Parallel processing of independent audio channels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+
+#include "channel_groups.h"
+#include "../video_chroma/slices.h"
+
+/* Fewer channels are processed by a single thread */
+#define GROUPS_MIN_CHANNELS 6
+/* Minimum number of channels of a group */
+#define GROUP_MIN_CHANNELS  2
+
+struct channel_groups_t
+{
+    slice_pool_t *pool;       /* one slice per group */
+    unsigned      i_channels;
+};
+
+channel_groups_t *ChannelGroupsNew(vlc_object_t *obj, unsigned i_channels)
+{
+    int i_threads = var_InheritInteger(obj, "audio-filter-threads");
+    unsigned i_reserved = 0;
+
+    if (i_threads <= 0)
+    {
+        /* Automatic: only for multichannel audio, within the CPU budget */
+        if (i_channels < GROUPS_MIN_CHANNELS)
+            return NULL;
+
+        unsigned i_wanted = __MIN(vlc_GetCPUCount(),
+                                  i_channels / GROUP_MIN_CHANNELS);
+        if (i_wanted <= 1)
+            return NULL;
+        i_threads = i_reserved = vlc_ReserveCPUs(obj, i_wanted);
+    }
+    if ((unsigned)i_threads > i_channels)
+        i_threads = i_channels;
+
+    channel_groups_t *groups = malloc(sizeof (*groups));
+    if (unlikely(groups == NULL))
+    {
+        if (i_reserved > 0)
+            vlc_ReleaseCPUs(obj, i_reserved);
+        return NULL;
+    }
+
+    groups->i_channels = i_channels;
+    groups->pool = SlicePoolStart(obj, i_threads,
+                                  i_reserved, VLC_THREAD_PRIORITY_AUDIO);
+    if (groups->pool == NULL)
+    {
+        free(groups);
+        return NULL;
+    }
+
+    msg_Dbg(obj, "processing %u channels in %u groups",
+            i_channels, SlicePoolCount(groups->pool));
+    return groups;
+}
+
+void ChannelGroupsDelete(channel_groups_t *groups)
+{
+    SlicePoolDelete(groups->pool);
+    free(groups);
+}
+
+struct channel_groups_job
+{
+    unsigned i_channels;
+    unsigned i_groups;
+    channel_groups_cb_t cb;
+    void *opaque;
+};
+
+static void RunGroup(void *data, unsigned i_group)
+{
+    const struct channel_groups_job *job = data;
+    const unsigned i_first = i_group * job->i_channels / job->i_groups;
+    const unsigned i_end = (i_group + 1) * job->i_channels / job->i_groups;
+
+    job->cb(job->opaque, i_first, i_end - i_first);
+}
+
+void ChannelGroupsRun(channel_groups_t *groups,
+                      channel_groups_cb_t cb, void *opaque)
+{
+    struct channel_groups_job job = {
+        .i_channels = groups->i_channels,
+        .i_groups = SlicePoolCount(groups->pool),
+        .cb = cb,
+        .opaque = opaque,
+    };
+
+    /* The calling thread processes groups too */
+    SlicePoolRunJob(groups->pool, RunGroup, &job);
+}
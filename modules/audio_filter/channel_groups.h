@@ -0,0 +1,47 @@
+/*****************************************************************************
+ * channel_groups.h: Parallel processing of independent audio channels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIOFILTER_CHANNEL_GROUPS_H_
+#define VLC_AUDIOFILTER_CHANNEL_GROUPS_H_
+
+/* Only for filters whose output channels each depend on the same input
+ * channel alone (the equalizer). The compressor shares one gain between all
+ * channels, the spatializer mixes left and right, and the headphone and
+ * channel mixers sum several input channels into each output channel, so
+ * they cannot be split this way. */
+
+typedef struct channel_groups_t channel_groups_t;
+
+/* Processes the channels [i_first, i_first + i_count) */
+typedef void (*channel_groups_cb_t)(void *opaque,
+                                    unsigned i_first, unsigned i_count);
+
+/* Creates the threads processing i_channels channels, according to the
+ * "audio-filter-threads" option. Returns NULL if a single thread is to be
+ * used. */
+channel_groups_t *ChannelGroupsNew(vlc_object_t *obj, unsigned i_channels);
+void ChannelGroupsDelete(channel_groups_t *groups);
+
+/* Splits the channels in groups and processes them in parallel, returning
+ * once all of them are done */
+void ChannelGroupsRun(channel_groups_t *groups,
+                      channel_groups_cb_t cb, void *opaque);
+
+#endif
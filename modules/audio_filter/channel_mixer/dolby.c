@@ -35,6 +35,8 @@
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 
+#include "mix.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -60,12 +62,7 @@ vlc_module_end ()
  *****************************************************************************/
 struct filter_sys_t
 {
-    int i_left;
-    int i_center;
-    int i_right;
-    int i_rear_left;
-    int i_rear_center;
-    int i_rear_right;
+    mix_t mix; /* the decoding is linear in the left and right inputs */
 };
 
 /*****************************************************************************
@@ -77,6 +74,8 @@ static int Create( vlc_object_t *p_this )
     int i_offset = 0;
     filter_t * p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys;
+    int i_left = -1, i_center = -1, i_right = -1;
+    int i_rear_left = -1, i_rear_center = -1, i_rear_right = -1;
 
     /* Validate audio filter format */
     if ( p_filter->fmt_in.audio.i_physical_channels != (AOUT_CHAN_LEFT|AOUT_CHAN_RIGHT)
@@ -103,12 +102,6 @@ static int Create( vlc_object_t *p_this )
     p_sys = p_filter->p_sys = malloc( sizeof(*p_sys) );
     if( p_sys == NULL )
         return VLC_ENOMEM;
-    p_sys->i_left = -1;
-    p_sys->i_center = -1;
-    p_sys->i_right = -1;
-    p_sys->i_rear_left = -1;
-    p_sys->i_rear_center = -1;
-    p_sys->i_rear_right = -1;
 
     while ( pi_vlc_chan_order_wg4[i] )
     {
@@ -117,22 +110,22 @@ static int Create( vlc_object_t *p_this )
             switch ( pi_vlc_chan_order_wg4[i] )
             {
                 case AOUT_CHAN_LEFT:
-                    p_sys->i_left = i_offset;
+                    i_left = i_offset;
                     break;
                 case AOUT_CHAN_CENTER:
-                    p_sys->i_center = i_offset;
+                    i_center = i_offset;
                     break;
                 case AOUT_CHAN_RIGHT:
-                    p_sys->i_right = i_offset;
+                    i_right = i_offset;
                     break;
                 case AOUT_CHAN_REARLEFT:
-                    p_sys->i_rear_left = i_offset;
+                    i_rear_left = i_offset;
                     break;
                 case AOUT_CHAN_REARCENTER:
-                    p_sys->i_rear_center = i_offset;
+                    i_rear_center = i_offset;
                     break;
                 case AOUT_CHAN_REARRIGHT:
-                    p_sys->i_rear_right = i_offset;
+                    i_rear_right = i_offset;
                     break;
             }
             ++i_offset;
@@ -140,6 +133,38 @@ static int Create( vlc_object_t *p_this )
         ++i;
     }
 
+    /* Rows of the left and right input weights, by output channel */
+    float coefs[AOUT_CHAN_MAX * 2] = { 0.f };
+    float f_front = i_center >= 0 ? .5f : 1.f;
+    int i_nb_rear = ( i_rear_left >= 0 ) + ( i_rear_center >= 0 )
+                  + ( i_rear_right >= 0 );
+
+    if( i_center >= 0 )
+    {
+        coefs[i_center * 2] = 1.f;
+        coefs[i_center * 2 + 1] = 1.f;
+    }
+    if( i_left >= 0 )
+    {
+        coefs[i_left * 2] = f_front;
+        coefs[i_left * 2 + 1] = f_front - 1.f;
+    }
+    if( i_right >= 0 )
+    {
+        coefs[i_right * 2] = f_front - 1.f;
+        coefs[i_right * 2 + 1] = f_front;
+    }
+
+    const int pi_rear[3] = { i_rear_left, i_rear_center, i_rear_right };
+    for( int j = 0; j < 3; j++ )
+        if( pi_rear[j] >= 0 )
+        {
+            coefs[pi_rear[j] * 2] = 1.f / i_nb_rear;
+            coefs[pi_rear[j] * 2 + 1] = -1.f / i_nb_rear;
+        }
+
+    MixInit( &p_sys->mix, coefs, 2, i_offset );
+
     p_filter->pf_audio_filter = DoWork;
 
     return VLC_SUCCESS;
@@ -160,73 +185,20 @@ static void Destroy( vlc_object_t *p_this )
 static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
 {
     filter_sys_t * p_sys = p_filter->p_sys;
-    float * p_in = (float*) p_in_buf->p_buffer;
     size_t i_nb_samples = p_in_buf->i_nb_samples;
     size_t i_nb_channels = aout_FormatNbChannels( &p_filter->fmt_out.audio );
-    size_t i_nb_rear = 0;
-    size_t i;
     block_t *p_out_buf = block_Alloc(
                                 sizeof(float) * i_nb_samples * i_nb_channels );
     if( !p_out_buf )
         goto out;
 
-    float * p_out = (float*) p_out_buf->p_buffer;
     p_out_buf->i_nb_samples = i_nb_samples;
     p_out_buf->i_dts        = p_in_buf->i_dts;
     p_out_buf->i_pts        = p_in_buf->i_pts;
     p_out_buf->i_length     = p_in_buf->i_length;
 
-    memset( p_out, 0, p_out_buf->i_buffer );
-
-    if( p_sys->i_rear_left >= 0 )
-    {
-        ++i_nb_rear;
-    }
-    if( p_sys->i_rear_center >= 0 )
-    {
-        ++i_nb_rear;
-    }
-    if( p_sys->i_rear_right >= 0 )
-    {
-        ++i_nb_rear;
-    }
-
-    for( i = 0; i < i_nb_samples; ++i )
-    {
-        float f_left = p_in[ i * 2 ];
-        float f_right = p_in[ i * 2 + 1 ];
-        float f_rear = ( f_left - f_right ) / i_nb_rear;
-
-        if( p_sys->i_center >= 0 )
-        {
-            float f_center = f_left + f_right;
-            f_left -= f_center / 2;
-            f_right -= f_center / 2;
-
-            p_out[ i * i_nb_channels + p_sys->i_center ] = f_center;
-        }
-
-        if( p_sys->i_left >= 0 )
-        {
-            p_out[ i * i_nb_channels + p_sys->i_left ] = f_left;
-        }
-        if( p_sys->i_right >= 0 )
-        {
-            p_out[ i * i_nb_channels + p_sys->i_right ] = f_right;
-        }
-        if( p_sys->i_rear_left >= 0 )
-        {
-            p_out[ i * i_nb_channels + p_sys->i_rear_left ] = f_rear;
-        }
-        if( p_sys->i_rear_center >= 0 )
-        {
-            p_out[ i * i_nb_channels + p_sys->i_rear_center ] = f_rear;
-        }
-        if( p_sys->i_rear_right >= 0 )
-        {
-            p_out[ i * i_nb_channels + p_sys->i_rear_right ] = f_rear;
-        }
-    }
+    Mix( &p_sys->mix, (const float *)p_in_buf->p_buffer,
+         (float *)p_out_buf->p_buffer, i_nb_samples );
 out:
     block_Release( p_in_buf );
     return p_out_buf;
@@ -0,0 +1,221 @@
+/*****************************************************************************
+ * mix.c : matrix mixing of audio channels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Every output frame is the sum of the columns of the matrix weighted by the
+ * samples of the input frame. The vector versions compute 4 or 8 output
+ * channels at once, or 2, respectively 4, stereo frames at once. All of them
+ * read the whole input frames before writing the output ones, so that they
+ * can downmix in place.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+
+#include "mix.h"
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <immintrin.h>
+# define CAN_COMPILE_SSE_MIX 1
+# if defined(__clang__) || VLC_GCC_VERSION(4, 9)
+#  define CAN_COMPILE_AVX2_MIX 1
+# endif
+#endif
+
+static void MixC( const mix_t *p_mix, const float *p_src, float *p_dst,
+                  size_t i_frames )
+{
+    const unsigned i_in = p_mix->i_in, i_out = p_mix->i_out;
+    float frame[AOUT_CHAN_MAX];
+
+    while( i_frames-- > 0 )
+    {
+        const float *p_coefs = p_mix->p_coefs;
+
+        for( unsigned o = 0; o < i_out; o++ )
+        {
+            float f_sum = 0.f;
+            for( unsigned i = 0; i < i_in; i++ )
+                f_sum += p_src[i] * *p_coefs++;
+            frame[o] = f_sum;
+        }
+        memcpy( p_dst, frame, i_out * sizeof (float) );
+
+        p_src += i_in;
+        p_dst += i_out;
+    }
+}
+
+#ifdef CAN_COMPILE_SSE_MIX
+VLC_SSE
+static void MixSSE( const mix_t *p_mix, const float *p_src, float *p_dst,
+                    size_t i_frames )
+{
+    const unsigned i_in = p_mix->i_in, i_out = p_mix->i_out;
+
+    if( i_out == 2 )
+    {
+        /* Two frames at once: (L0 R0 L1 R1) */
+        __m128 cols[AOUT_CHAN_MAX];
+        for( unsigned i = 0; i < i_in; i++ )
+        {
+            __m128 c = _mm_loadl_pi( _mm_setzero_ps(),
+                                     (const __m64 *)p_mix->p_columns[i] );
+            cols[i] = _mm_movelh_ps( c, c );
+        }
+
+        for( ; i_frames >= 2; i_frames -= 2 )
+        {
+            __m128 sum = _mm_setzero_ps();
+            for( unsigned i = 0; i < i_in; i++ )
+            {
+                __m128 s = _mm_shuffle_ps( _mm_load1_ps( p_src + i ),
+                                           _mm_load1_ps( p_src + i_in + i ),
+                                           _MM_SHUFFLE(0, 0, 0, 0) );
+                sum = _mm_add_ps( sum, _mm_mul_ps( s, cols[i] ) );
+            }
+            _mm_storeu_ps( p_dst, sum );
+
+            p_src += 2 * i_in;
+            p_dst += 4;
+        }
+    }
+
+    while( i_frames-- > 0 )
+    {
+        float frame[MIX_PAD_CHANNELS];
+        __m128 s[AOUT_CHAN_MAX];
+
+        for( unsigned i = 0; i < i_in; i++ )
+            s[i] = _mm_load1_ps( p_src + i );
+
+        for( unsigned o = 0; o < i_out; o += 4 )
+        {
+            __m128 sum = _mm_setzero_ps();
+            for( unsigned i = 0; i < i_in; i++ )
+                sum = _mm_add_ps( sum, _mm_mul_ps( s[i],
+                                      _mm_loadu_ps( p_mix->p_columns[i] + o ) ) );
+            _mm_storeu_ps( frame + o, sum );
+        }
+        memcpy( p_dst, frame, i_out * sizeof (float) );
+
+        p_src += i_in;
+        p_dst += i_out;
+    }
+}
+#endif
+
+#ifdef CAN_COMPILE_AVX2_MIX
+VLC_AVX2
+static void MixAVX2( const mix_t *p_mix, const float *p_src, float *p_dst,
+                     size_t i_frames )
+{
+    const unsigned i_in = p_mix->i_in, i_out = p_mix->i_out;
+
+    if( i_out == 2 )
+    {
+        /* Four frames at once: (L0 R0 L1 R1 | L2 R2 L3 R3) */
+        __m256 cols[AOUT_CHAN_MAX];
+        for( unsigned i = 0; i < i_in; i++ )
+        {
+            __m128 c = _mm_loadl_pi( _mm_setzero_ps(),
+                                     (const __m64 *)p_mix->p_columns[i] );
+            c = _mm_movelh_ps( c, c );
+            cols[i] = _mm256_insertf128_ps( _mm256_castps128_ps256( c ), c, 1 );
+        }
+
+        for( ; i_frames >= 4; i_frames -= 4 )
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for( unsigned i = 0; i < i_in; i++ )
+            {
+                const float *p = p_src + i;
+                __m128 lo = _mm_shuffle_ps( _mm_load1_ps( p ),
+                                            _mm_load1_ps( p + i_in ),
+                                            _MM_SHUFFLE(0, 0, 0, 0) );
+                __m128 hi = _mm_shuffle_ps( _mm_load1_ps( p + 2 * i_in ),
+                                            _mm_load1_ps( p + 3 * i_in ),
+                                            _MM_SHUFFLE(0, 0, 0, 0) );
+                __m256 s = _mm256_insertf128_ps( _mm256_castps128_ps256( lo ),
+                                                 hi, 1 );
+                sum = _mm256_add_ps( sum, _mm256_mul_ps( s, cols[i] ) );
+            }
+            _mm256_storeu_ps( p_dst, sum );
+
+            p_src += 4 * i_in;
+            p_dst += 8;
+        }
+    }
+
+    while( i_frames-- > 0 )
+    {
+        float frame[MIX_PAD_CHANNELS];
+        __m256 s[AOUT_CHAN_MAX];
+
+        for( unsigned i = 0; i < i_in; i++ )
+            s[i] = _mm256_broadcast_ss( p_src + i );
+
+        for( unsigned o = 0; o < i_out; o += 8 )
+        {
+            __m256 sum = _mm256_setzero_ps();
+            for( unsigned i = 0; i < i_in; i++ )
+                sum = _mm256_add_ps( sum, _mm256_mul_ps( s[i],
+                                   _mm256_loadu_ps( p_mix->p_columns[i] + o ) ) );
+            _mm256_storeu_ps( frame + o, sum );
+        }
+        memcpy( p_dst, frame, i_out * sizeof (float) );
+
+        p_src += i_in;
+        p_dst += i_out;
+    }
+}
+#endif
+
+void MixInit( mix_t *p_mix, const float *p_coefs,
+              unsigned i_in, unsigned i_out )
+{
+    assert( i_in > 0 && i_in <= AOUT_CHAN_MAX );
+    assert( i_out > 0 && i_out <= AOUT_CHAN_MAX );
+
+    p_mix->i_in = i_in;
+    p_mix->i_out = i_out;
+    memcpy( p_mix->p_coefs, p_coefs, i_in * i_out * sizeof (float) );
+    memset( p_mix->p_columns, 0, sizeof (p_mix->p_columns) );
+    for( unsigned o = 0; o < i_out; o++ )
+        for( unsigned i = 0; i < i_in; i++ )
+            p_mix->p_columns[i][o] = p_coefs[o * i_in + i];
+
+    p_mix->pf_mix = MixC;
+#ifdef CAN_COMPILE_SSE_MIX
+    if( vlc_CPU_SSE() )
+        p_mix->pf_mix = MixSSE;
+#endif
+#ifdef CAN_COMPILE_AVX2_MIX
+    if( vlc_CPU_AVX2() )
+        p_mix->pf_mix = MixAVX2;
+#endif
+}
@@ -0,0 +1,54 @@
+/*****************************************************************************
+ * mix.h : matrix mixing of audio channels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_CHANNEL_MIXER_MIX_H_
+#define VLC_CHANNEL_MIXER_MIX_H_
+
+/* Output channels of a column, padded to the width of the largest vector */
+#define MIX_PAD_CHANNELS 16
+
+typedef struct mix_t mix_t;
+typedef void (*mix_fn_t)( const mix_t *, const float *, float *, size_t );
+
+struct mix_t
+{
+    unsigned i_in;
+    unsigned i_out;
+    /* Weight of input channel i in output channel o: p_coefs[o * i_in + i] */
+    float    p_coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX];
+    /* The same weights by input channel: p_columns[i][o] */
+    float    p_columns[AOUT_CHAN_MAX][MIX_PAD_CHANNELS];
+    mix_fn_t pf_mix;
+};
+
+/* Sets the matrix up from the i_out rows of i_in coefficients, and picks the
+ * fastest implementation for the CPU */
+void MixInit( mix_t *p_mix, const float *p_coefs,
+              unsigned i_in, unsigned i_out );
+
+/* Mixes i_frames interleaved FL32 frames. The destination may be the source
+ * if the output frames are not larger than the input ones. */
+static inline void Mix( const mix_t *p_mix, const float *p_src, float *p_dst,
+                        size_t i_frames )
+{
+    p_mix->pf_mix( p_mix, p_src, p_dst, i_frames );
+}
+
+#endif
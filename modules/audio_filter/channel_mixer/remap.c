@@ -34,6 +34,8 @@
 #include <vlc_block.h>
 #include <assert.h>
 
+#include "mix.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -110,6 +112,7 @@ struct filter_sys_t
     int nb_in_ch[AOUT_CHAN_MAX];
     uint8_t map_ch[AOUT_CHAN_MAX];
     bool b_normalize;
+    mix_t mix; /* matrix of the mapping, for FL32 */
 };
 
 static const uint32_t valid_channels[] = {
@@ -216,11 +219,35 @@ static void RemapAdd##name( filter_t *p_filter, \
 DEFINE_REMAP( U8,   uint8_t  )
 DEFINE_REMAP( S16N, int16_t  )
 DEFINE_REMAP( S32N, int32_t  )
-DEFINE_REMAP( FL32, float    )
 DEFINE_REMAP( FL64, double   )
 
 #undef DEFINE_REMAP
 
+static void RemapMixFL32( filter_t *p_filter,
+                          const void *p_src, void *p_dest, int i_nb_samples,
+                          unsigned i_nb_in_channels, unsigned i_nb_out_channels )
+{
+    filter_sys_t *p_sys = ( filter_sys_t * )p_filter->p_sys;
+
+    VLC_UNUSED( i_nb_in_channels );
+    VLC_UNUSED( i_nb_out_channels );
+    Mix( &p_sys->mix, p_src, p_dest, i_nb_samples );
+}
+
+static void InitMix( filter_sys_t *p_sys, unsigned i_nb_in_channels,
+                     unsigned i_nb_out_channels )
+{
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX] = { 0.f };
+
+    for( unsigned in_ch = 0; in_ch < i_nb_in_channels; in_ch++ )
+    {
+        unsigned out_ch = p_sys->map_ch[ in_ch ];
+        coefs[out_ch * i_nb_in_channels + in_ch] = p_sys->b_normalize
+            ? 1.f / p_sys->nb_in_ch[ out_ch ] : 1.f;
+    }
+    MixInit( &p_sys->mix, coefs, i_nb_in_channels, i_nb_out_channels );
+}
+
 static inline remap_fun_t GetRemapFun( audio_format_t *p_format, bool b_add )
 {
     if( b_add )
@@ -234,7 +261,7 @@ static inline remap_fun_t GetRemapFun( audio_format_t *p_format, bool b_add )
             case VLC_CODEC_S32N:
                 return RemapAddS32N;
             case VLC_CODEC_FL32:
-                return RemapAddFL32;
+                return RemapMixFL32;
             case VLC_CODEC_FL64:
                 return RemapAddFL64;
         }
@@ -250,7 +277,7 @@ static inline remap_fun_t GetRemapFun( audio_format_t *p_format, bool b_add )
             case VLC_CODEC_S32N:
                 return RemapCopyS32N;
             case VLC_CODEC_FL32:
-                return RemapCopyFL32;
+                return RemapMixFL32;
             case VLC_CODEC_FL64:
                 return RemapCopyFL64;
         }
@@ -337,6 +364,8 @@ static int OpenFilter( vlc_object_t *p_this )
              aout_FormatPrintChannels( audio_in ),
              aout_FormatPrintChannels( audio_out ) );
 
+    if( audio_in->i_format == VLC_CODEC_FL32 )
+        InitMix( p_sys, audio_in->i_channels, audio_out->i_channels );
     p_sys->pf_remap = GetRemapFun( audio_in, b_multiple );
     if( !p_sys->pf_remap )
     {
@@ -28,27 +28,40 @@
 # include "config.h"
 #endif
 
+#include <assert.h>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "mix.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio converter", 10 )
-    set_callbacks( OpenFilter, NULL );
+    set_callbacks( OpenFilter, CloseFilter );
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
 
+typedef void (*work_fn_t)( filter_t *, block_t *, block_t * );
+
+struct filter_sys_t
+{
+    work_fn_t pf_work;
+    mix_t     mix;
+};
+
 static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
     float *p_dest = (float *)p_out_buf->p_buffer;
     const float *p_src = (const float *)p_in_buf->p_buffer;
@@ -263,6 +276,34 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
 #define GET_WORK(in, out) GET_WORK_##in##_to_##out##_neon()
 #else
 #define GET_WORK(in, out) DoWork_##in##_to_##out
+/* The C functions being linear, their matrix is taken from their output for
+ * each input channel alone, and run by the vector mixing code, in place. */
+#define WORK_AS_MATRIX
+#endif
+
+#ifdef WORK_AS_MATRIX
+static void GetMatrix( filter_t *p_filter, work_fn_t work, float *p_coefs )
+{
+    const unsigned i_in = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    const unsigned i_out = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+    float in[AOUT_CHAN_MAX], out[AOUT_CHAN_MAX];
+    block_t in_buf, out_buf;
+
+    block_Init( &in_buf, in, sizeof (in) );
+    block_Init( &out_buf, out, sizeof (out) );
+    in_buf.i_nb_samples = 1;
+
+    for( unsigned i = 0; i < i_in; i++ )
+    {
+        memset( in, 0, sizeof (in) );
+        memset( out, 0, sizeof (out) );
+        in[i] = 1.f;
+        work( p_filter, &in_buf, &out_buf );
+
+        for( unsigned o = 0; o < i_out; o++ )
+            p_coefs[o * i_in + i] = out[o];
+    }
+}
 #endif
 
 /*****************************************************************************
@@ -271,7 +312,7 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
 static int OpenFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    void (*do_work)(filter_t *, block_t *, block_t *) = NULL;
+    work_fn_t do_work = NULL;
 
     if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
         p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format ||
@@ -348,17 +389,37 @@ static int OpenFilter( vlc_object_t *p_this )
     if( do_work == NULL )
         return VLC_EGENERIC;
 
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+    p_sys->pf_work = do_work;
+#ifdef WORK_AS_MATRIX
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX];
+
+    GetMatrix( p_filter, do_work, coefs );
+    MixInit( &p_sys->mix, coefs,
+             aout_FormatNbChannels( &p_filter->fmt_in.audio ),
+             aout_FormatNbChannels( &p_filter->fmt_out.audio ) );
+#endif
+
     p_filter->pf_audio_filter = Filter;
-    p_filter->p_sys = (void *)do_work;
+    p_filter->p_sys = p_sys;
     return VLC_SUCCESS;
 }
 
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
-    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_block || !p_block->i_nb_samples )
     {
@@ -367,6 +428,16 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
         return NULL;
     }
 
+    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
+
+#ifdef WORK_AS_MATRIX
+    assert( i_output_nb < i_input_nb );
+    Mix( &p_sys->mix, (const float *)p_block->p_buffer,
+         (float *)p_block->p_buffer, p_block->i_nb_samples );
+    p_block->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
+    return p_block;
+#else
     size_t i_out_size = p_block->i_nb_samples *
       p_filter->fmt_out.audio.i_bitspersample *
         p_filter->fmt_out.audio.i_channels / 8;
@@ -384,15 +455,14 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
     p_out->i_nb_samples = p_block->i_nb_samples;
     p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
 
-    work( p_filter, p_block, p_out );
+    p_sys->pf_work( p_filter, p_block, p_out );
 
     block_Release( p_block );
 
     return p_out;
+#endif
 }
 
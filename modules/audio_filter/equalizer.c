@@ -39,6 +39,7 @@
 #include <vlc_filter.h>
 
 #include "equalizer_presets.h"
+#include "channel_groups.h"
 
 /* TODO:
  *  - optimize a bit (you can hardly do slower ;)
@@ -122,6 +123,9 @@ struct filter_sys_t
     float x2[32][2];
     float y2[32][128][2];
 
+    /* Threads filtering groups of channels, or NULL */
+    channel_groups_t *p_groups;
+
     vlc_mutex_t lock;
 };
 
@@ -167,6 +171,9 @@ static int Open( vlc_object_t *p_this )
     p_filter->fmt_out.audio = p_filter->fmt_in.audio;
     p_filter->pf_audio_filter = DoWork;
 
+    p_sys->p_groups = ChannelGroupsNew( p_this,
+                        aout_FormatNbChannels( &p_filter->fmt_in.audio ) );
+
     return VLC_SUCCESS;
 }
 
@@ -178,6 +185,8 @@ static void Close( vlc_object_t *p_this )
     filter_t     *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    if( p_sys->p_groups != NULL )
+        ChannelGroupsDelete( p_sys->p_groups );
     EqzClean( p_filter );
     vlc_mutex_destroy( &p_sys->lock );
     free( p_sys );
@@ -385,66 +394,112 @@ error:
     return i_ret;
 }
 
-static void EqzFilter( filter_t *p_filter, float *out, float *in,
-                       int i_samples, int i_channels )
+/* Filters one channel: the state is kept in local variables while going
+ * through the samples, so that the groups of channels processed by different
+ * threads do not write to the same cache lines. */
+static void EqzFilterChannel( filter_sys_t *p_sys, float *out,
+                              const float *in, int i_samples,
+                              int i_channels, int ch )
 {
-    filter_sys_t *p_sys = p_filter->p_sys;
-    int i, ch, j;
+    const int i_band = p_sys->i_band;
+    float x[2], y[EQZ_BANDS_MAX][2];
+    float x2[2], y2[EQZ_BANDS_MAX][2];
+    int i, j;
+
+    memcpy( x, p_sys->x[ch], sizeof (x) );
+    memcpy( x2, p_sys->x2[ch], sizeof (x2) );
+    memcpy( y, p_sys->y[ch], i_band * sizeof (y[0]) );
+    memcpy( y2, p_sys->y2[ch], i_band * sizeof (y2[0]) );
 
-    vlc_mutex_lock( &p_sys->lock );
     for( i = 0; i < i_samples; i++ )
     {
-        for( ch = 0; ch < i_channels; ch++ )
+        const float xi = in[ch];
+        float o = 0.0f;
+
+        for( j = 0; j < i_band; j++ )
         {
-            const float x = in[ch];
-            float o = 0.0f;
+            float yj = p_sys->f_alpha[j] * ( xi - x[1] ) +
+                       p_sys->f_gamma[j] * y[j][0] -
+                       p_sys->f_beta[j]  * y[j][1];
+
+            y[j][1] = y[j][0];
+            y[j][0] = yj;
 
-            for( j = 0; j < p_sys->i_band; j++ )
+            o += yj * p_sys->f_amp[j];
+        }
+        x[1] = x[0];
+        x[0] = xi;
+
+        /* Second filter */
+        if( p_sys->b_2eqz )
+        {
+            const float xi2 = EQZ_IN_FACTOR * xi + o;
+            o = 0.0f;
+            for( j = 0; j < i_band; j++ )
             {
-                float y = p_sys->f_alpha[j] * ( x - p_sys->x[ch][1] ) +
-                          p_sys->f_gamma[j] * p_sys->y[ch][j][0] -
-                          p_sys->f_beta[j]  * p_sys->y[ch][j][1];
+                float yj = p_sys->f_alpha[j] * ( xi2 - x2[1] ) +
+                           p_sys->f_gamma[j] * y2[j][0] -
+                           p_sys->f_beta[j]  * y2[j][1];
 
-                p_sys->y[ch][j][1] = p_sys->y[ch][j][0];
-                p_sys->y[ch][j][0] = y;
+                y2[j][1] = y2[j][0];
+                y2[j][0] = yj;
 
-                o += y * p_sys->f_amp[j];
+                o += yj * p_sys->f_amp[j];
             }
-            p_sys->x[ch][1] = p_sys->x[ch][0];
-            p_sys->x[ch][0] = x;
+            x2[1] = x2[0];
+            x2[0] = xi2;
 
-            /* Second filter */
-            if( p_sys->b_2eqz )
-            {
-                const float x2 = EQZ_IN_FACTOR * x + o;
-                o = 0.0f;
-                for( j = 0; j < p_sys->i_band; j++ )
-                {
-                    float y = p_sys->f_alpha[j] * ( x2 - p_sys->x2[ch][1] ) +
-                              p_sys->f_gamma[j] * p_sys->y2[ch][j][0] -
-                              p_sys->f_beta[j]  * p_sys->y2[ch][j][1];
-
-                    p_sys->y2[ch][j][1] = p_sys->y2[ch][j][0];
-                    p_sys->y2[ch][j][0] = y;
-
-                    o += y * p_sys->f_amp[j];
-                }
-                p_sys->x2[ch][1] = p_sys->x2[ch][0];
-                p_sys->x2[ch][0] = x2;
-
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * x2 + o );
-            }
-            else
-            {
-                /* We add source PCM + filtered PCM */
-                out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * x + o );
-            }
+            /* We add source PCM + filtered PCM */
+            out[ch] = p_sys->f_gamp * p_sys->f_gamp *( EQZ_IN_FACTOR * xi2 + o );
+        }
+        else
+        {
+            /* We add source PCM + filtered PCM */
+            out[ch] = p_sys->f_gamp *( EQZ_IN_FACTOR * xi + o );
         }
 
         in  += i_channels;
         out += i_channels;
     }
+
+    memcpy( p_sys->x[ch], x, sizeof (x) );
+    memcpy( p_sys->x2[ch], x2, sizeof (x2) );
+    memcpy( p_sys->y[ch], y, i_band * sizeof (y[0]) );
+    memcpy( p_sys->y2[ch], y2, i_band * sizeof (y2[0]) );
+}
+
+typedef struct
+{
+    filter_sys_t *p_sys;
+    float        *out;
+    const float  *in;
+    int           i_samples;
+    int           i_channels;
+} eqz_work_t;
+
+static void EqzFilterGroup( void *opaque, unsigned i_first, unsigned i_count )
+{
+    const eqz_work_t *work = opaque;
+
+    for( unsigned ch = i_first; ch < i_first + i_count; ch++ )
+        EqzFilterChannel( work->p_sys, work->out, work->in,
+                          work->i_samples, work->i_channels, ch );
+}
+
+static void EqzFilter( filter_t *p_filter, float *out, float *in,
+                       int i_samples, int i_channels )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    eqz_work_t work = {
+        .p_sys = p_sys, .out = out, .in = in,
+        .i_samples = i_samples, .i_channels = i_channels,
+    };
+
+    vlc_mutex_lock( &p_sys->lock );
+    if( p_sys->p_groups != NULL )
+        ChannelGroupsRun( p_sys->p_groups, EqzFilterGroup, &work );
+    else
+        EqzFilterGroup( &work, 0, i_channels );
     vlc_mutex_unlock( &p_sys->lock );
 }
 
@@ -0,0 +1,589 @@
+/*****************************************************************************
+ * polyphase.c : polyphase windowed-sinc audio resampler
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * The filter is a Kaiser-windowed sinc function of POLY_TAPS input samples,
+ * sampled at POLY_PHASES fractional positions between two input samples.
+ * Each output sample is the linear interpolation of the inner products of
+ * the input with the two phases surrounding its position.
+ *
+ * The tables only depend on the cutoff frequency: they are computed once and
+ * shared by all the resamplers with the same ratio. The position in the input
+ * is a 32.32 fixed point number, so that changing the input rate (as the
+ * audio output does to correct the clock drift) only changes the step and
+ * does not touch the tables.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_block.h>
+#include <vlc_cpu.h>
+
+#ifdef HAVE_SSE2_INTRINSICS
+# include <xmmintrin.h>
+#endif
+
+#define POLY_TAPS        32                /* multiple of 4 */
+#define POLY_HALF        (POLY_TAPS / 2)
+#define POLY_PHASE_BITS  8
+#define POLY_PHASES      (1 << POLY_PHASE_BITS)
+#define POLY_KAISER_BETA 7.5
+/* Passband edge, relative to the lowest of the two Nyquist frequencies */
+#define POLY_BANDWIDTH   0.92
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open( vlc_object_t * );
+static int  OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Polyphase") )
+    set_description( N_("Polyphase audio resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    set_capability( "audio converter", 30 )
+    set_callbacks( Open, Close )
+
+    add_submodule()
+    set_capability( "audio resampler", 30 )
+    set_callbacks( OpenResampler, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Coefficient tables
+ *****************************************************************************/
+typedef struct poly_table_t poly_table_t;
+struct poly_table_t
+{
+    poly_table_t *p_next;
+    unsigned      i_key;     /* cutoff, in thousandths of the Nyquist rate */
+    unsigned      i_refs;
+    float         coefs[];   /* (POLY_PHASES + 1) rows of POLY_TAPS */
+};
+
+static vlc_mutex_t tables_lock = VLC_STATIC_MUTEX;
+static poly_table_t *tables = NULL;
+
+static unsigned CutoffKey( unsigned i_in_rate, unsigned i_out_rate )
+{
+    double d_cutoff = POLY_BANDWIDTH;
+
+    if( i_out_rate < i_in_rate )
+        d_cutoff = d_cutoff * i_out_rate / i_in_rate;
+    return lround( d_cutoff * 1000. );
+}
+
+/* Zeroth order modified Bessel function of the first kind */
+static double BesselI0( double x )
+{
+    double d_sum = 1., d_term = 1.;
+
+    for( unsigned k = 1; d_term > d_sum * 1e-12; k++ )
+    {
+        d_term *= (x / (2 * k)) * (x / (2 * k));
+        d_sum += d_term;
+    }
+    return d_sum;
+}
+
+static void ComputeTable( float *p_coefs, double d_cutoff )
+{
+    const double d_norm = BesselI0( POLY_KAISER_BETA );
+
+    for( unsigned p = 0; p <= POLY_PHASES; p++ )
+    {
+        float *p_row = p_coefs + p * POLY_TAPS;
+        double d_sum = 0.;
+
+        /* Tap k weights the input sample at k - (POLY_HALF - 1) - p/PHASES
+         * from the output position */
+        for( unsigned k = 0; k < POLY_TAPS; k++ )
+        {
+            double x = (double)k - (POLY_HALF - 1)
+                     - (double)p / POLY_PHASES;
+            double r = x / POLY_HALF;
+            double h = 0.;
+
+            if( fabs( r ) < 1. )
+            {
+                double d_sinc = x == 0. ? 1.
+                              : sin( M_PI * d_cutoff * x ) / (M_PI * d_cutoff * x);
+                h = d_sinc * BesselI0( POLY_KAISER_BETA * sqrt( 1. - r * r ) )
+                  / d_norm;
+            }
+            p_row[k] = h;
+            d_sum += h;
+        }
+
+        /* Unity gain at DC for every phase */
+        for( unsigned k = 0; k < POLY_TAPS; k++ )
+            p_row[k] /= d_sum;
+    }
+}
+
+static poly_table_t *TableGet( unsigned i_key )
+{
+    poly_table_t *p_table;
+
+    vlc_mutex_lock( &tables_lock );
+    for( p_table = tables; p_table != NULL; p_table = p_table->p_next )
+        if( p_table->i_key == i_key )
+        {
+            p_table->i_refs++;
+            goto out;
+        }
+
+    p_table = malloc( sizeof (*p_table)
+                      + (POLY_PHASES + 1) * POLY_TAPS * sizeof (float) );
+    if( unlikely(p_table == NULL) )
+        goto out;
+
+    ComputeTable( p_table->coefs, i_key / 1000. );
+    p_table->i_key = i_key;
+    p_table->i_refs = 1;
+    p_table->p_next = tables;
+    tables = p_table;
+out:
+    vlc_mutex_unlock( &tables_lock );
+    return p_table;
+}
+
+static void TableRelease( poly_table_t *p_table )
+{
+    vlc_mutex_lock( &tables_lock );
+    assert( p_table->i_refs > 0 );
+    if( --p_table->i_refs == 0 )
+    {
+        poly_table_t **pp = &tables;
+
+        while( *pp != p_table )
+            pp = &(*pp)->p_next;
+        *pp = p_table->p_next;
+        free( p_table );
+    }
+    vlc_mutex_unlock( &tables_lock );
+}
+
+/*****************************************************************************
+ * Inner products
+ *****************************************************************************
+ * Computes the inner products of the POLY_TAPS input samples with two
+ * consecutive rows, and interpolates them.
+ *****************************************************************************/
+typedef float (*poly_dot_t)( const float *, const float *, float );
+
+static float DotC( const float *p_in, const float *p_row, float f_frac )
+{
+    const float *p_next = p_row + POLY_TAPS;
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+    float b0 = 0.f, b1 = 0.f, b2 = 0.f, b3 = 0.f;
+
+    for( unsigned k = 0; k < POLY_TAPS; k += 4 )
+    {
+        a0 += p_in[k] * p_row[k];      b0 += p_in[k] * p_next[k];
+        a1 += p_in[k+1] * p_row[k+1];  b1 += p_in[k+1] * p_next[k+1];
+        a2 += p_in[k+2] * p_row[k+2];  b2 += p_in[k+2] * p_next[k+2];
+        a3 += p_in[k+3] * p_row[k+3];  b3 += p_in[k+3] * p_next[k+3];
+    }
+
+    float a = (a0 + a1) + (a2 + a3);
+    float b = (b0 + b1) + (b2 + b3);
+    return a + f_frac * (b - a);
+}
+
+#ifdef HAVE_SSE2_INTRINSICS
+VLC_SSE
+static float DotSSE( const float *p_in, const float *p_row, float f_frac )
+{
+    const float *p_next = p_row + POLY_TAPS;
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+
+    for( unsigned k = 0; k < POLY_TAPS; k += 4 )
+    {
+        __m128 x = _mm_loadu_ps( p_in + k );
+        a = _mm_add_ps( a, _mm_mul_ps( x, _mm_loadu_ps( p_row + k ) ) );
+        b = _mm_add_ps( b, _mm_mul_ps( x, _mm_loadu_ps( p_next + k ) ) );
+    }
+
+    /* a + frac * (b - a), then the horizontal sum */
+    a = _mm_add_ps( a, _mm_mul_ps( _mm_set1_ps( f_frac ), _mm_sub_ps( b, a ) ) );
+    a = _mm_add_ps( a, _mm_movehl_ps( a, a ) );
+    a = _mm_add_ss( a, _mm_shuffle_ps( a, a, 1 ) );
+    return _mm_cvtss_f32( a );
+}
+#endif
+
+/*****************************************************************************
+ * Local structures
+ *****************************************************************************/
+struct filter_sys_t
+{
+    poly_table_t *p_table;
+    poly_dot_t    pf_dot;
+    unsigned      i_channels;
+    bool          b_s16;       /* S16N instead of FL32 samples */
+
+    /* Planar input: POLY_HALF - 1 samples of history, then the samples not
+     * consumed yet, for each channel */
+    float   *p_buf;
+    size_t   i_buf_size;  /* allocated samples per channel */
+    size_t   i_buf;       /* buffered samples per channel */
+
+    /* Position of the next output sample in the buffer (32.32) */
+    uint64_t i_pos;
+    bool     b_first;
+
+    date_t   end_date;
+};
+
+static void Reset( filter_sys_t *p_sys )
+{
+    memset( p_sys->p_buf, 0,
+            p_sys->i_channels * p_sys->i_buf_size * sizeof (float) );
+    p_sys->i_buf = POLY_HALF - 1;
+    p_sys->i_pos = (uint64_t)(POLY_HALF - 1) << 32;
+    p_sys->b_first = true;
+}
+
+/* Makes room for i_count more samples per channel */
+static int Reserve( filter_sys_t *p_sys, size_t i_count )
+{
+    size_t i_size = p_sys->i_buf + i_count;
+
+    if( i_size <= p_sys->i_buf_size )
+        return VLC_SUCCESS;
+
+    float *p_buf = malloc( p_sys->i_channels * i_size * sizeof (float) );
+    if( unlikely(p_buf == NULL) )
+        return VLC_ENOMEM;
+
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+        memcpy( p_buf + c * i_size, p_sys->p_buf + c * p_sys->i_buf_size,
+                p_sys->i_buf * sizeof (float) );
+    free( p_sys->p_buf );
+    p_sys->p_buf = p_buf;
+    p_sys->i_buf_size = i_size;
+    return VLC_SUCCESS;
+}
+
+/* Appends interleaved samples (or silence if p_in is NULL) */
+static void Append( filter_sys_t *p_sys, const void *p_in, size_t i_count )
+{
+    const unsigned i_channels = p_sys->i_channels;
+
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        float *p_dst = p_sys->p_buf + c * p_sys->i_buf_size + p_sys->i_buf;
+
+        if( p_in == NULL )
+            memset( p_dst, 0, i_count * sizeof (float) );
+        else if( p_sys->b_s16 )
+        {
+            const int16_t *p_src = (const int16_t *)p_in + c;
+            for( size_t i = 0; i < i_count; i++ )
+                p_dst[i] = p_src[i * i_channels] * (1.f / 32768.f);
+        }
+        else
+        {
+            const float *p_src = (const float *)p_in + c;
+            for( size_t i = 0; i < i_count; i++ )
+                p_dst[i] = p_src[i * i_channels];
+        }
+    }
+    p_sys->i_buf += i_count;
+}
+
+static inline void Store( const filter_sys_t *p_sys, uint8_t *p_out,
+                          size_t i_index, float f_sample )
+{
+    if( p_sys->b_s16 )
+    {
+        f_sample *= 32768.f;
+        if( f_sample >= 32767.f )
+            f_sample = 32767.f;
+        else if( f_sample < -32768.f )
+            f_sample = -32768.f;
+        ((int16_t *)p_out)[i_index] = lrintf( f_sample );
+    }
+    else
+        ((float *)p_out)[i_index] = f_sample;
+}
+
+/* Drops the samples that no further output sample depends on */
+static void Consume( filter_sys_t *p_sys )
+{
+    size_t i_drop = (p_sys->i_pos >> 32) - (POLY_HALF - 1);
+
+    if( i_drop == 0 )
+        return;
+    if( i_drop > p_sys->i_buf )
+        i_drop = p_sys->i_buf;
+
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+    {
+        float *p_chan = p_sys->p_buf + c * p_sys->i_buf_size;
+        memmove( p_chan, p_chan + i_drop,
+                 (p_sys->i_buf - i_drop) * sizeof (float) );
+    }
+    p_sys->i_buf -= i_drop;
+    p_sys->i_pos -= (uint64_t)i_drop << 32;
+}
+
+/* Computes the output samples whose inputs are all buffered */
+static block_t *Process( filter_t *p_filter, unsigned i_in_rate )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned i_channels = p_sys->i_channels;
+    const uint64_t i_step = ((uint64_t)i_in_rate << 32) / i_out_rate;
+
+    /* Same rate, on an input sample: the output is the input */
+    const bool b_copy = i_step == ((uint64_t)1 << 32)
+                     && (uint32_t)p_sys->i_pos == 0;
+    if( !b_copy && p_sys->i_buf < POLY_HALF )
+        return NULL;
+
+    const size_t i_last = b_copy ? p_sys->i_buf
+                                 : p_sys->i_buf - POLY_HALF;
+    if( (p_sys->i_pos >> 32) >= i_last )
+        return NULL;
+
+    size_t i_out = ((((uint64_t)i_last << 32) - p_sys->i_pos) + i_step - 1)
+                 / i_step;
+    block_t *p_out = block_Alloc( i_out
+                                  * p_filter->fmt_out.audio.i_bytes_per_frame );
+    if( unlikely(p_out == NULL) )
+        return NULL;
+
+    uint8_t *p_dst = p_out->p_buffer;
+    uint64_t i_pos = p_sys->i_pos;
+
+    if( b_copy )
+    {
+        const size_t i_first = i_pos >> 32;
+
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            const float *p_src = p_sys->p_buf + c * p_sys->i_buf_size + i_first;
+            for( size_t i = 0; i < i_out; i++ )
+                Store( p_sys, p_dst, i * i_channels + c, p_src[i] );
+        }
+        i_pos += (uint64_t)i_out << 32;
+    }
+    else
+    {
+        const float *p_coefs = p_sys->p_table->coefs;
+
+        for( size_t i = 0, j = 0; i < i_out; i++ )
+        {
+            const size_t i_first = (i_pos >> 32) - (POLY_HALF - 1);
+            const uint32_t i_frac = i_pos;
+            const float *p_row = p_coefs
+                + (i_frac >> (32 - POLY_PHASE_BITS)) * POLY_TAPS;
+            const float f_frac = (i_frac & ((1u << (32 - POLY_PHASE_BITS)) - 1))
+                               * (1.f / (1u << (32 - POLY_PHASE_BITS)));
+
+            for( unsigned c = 0; c < i_channels; c++ )
+                Store( p_sys, p_dst, j++,
+                       p_sys->pf_dot( p_sys->p_buf + c * p_sys->i_buf_size
+                                      + i_first, p_row, f_frac ) );
+            i_pos += i_step;
+        }
+    }
+    p_sys->i_pos = i_pos;
+    Consume( p_sys );
+
+    p_out->i_nb_samples = i_out;
+    p_out->i_pts = date_Get( &p_sys->end_date );
+    p_out->i_length = date_Increment( &p_sys->end_date, i_out )
+                    - p_out->i_pts;
+    return p_out;
+}
+
+/* Picks the table for the current ratio, if it drifted too far */
+static void UpdateTable( filter_t *p_filter, unsigned i_in_rate )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    unsigned i_key = CutoffKey( i_in_rate, p_filter->fmt_out.audio.i_rate );
+
+    if( abs( (int)i_key - (int)p_sys->p_table->i_key ) * 100
+         <= (int)p_sys->p_table->i_key )
+        return;
+
+    poly_table_t *p_table = TableGet( i_key );
+    if( p_table != NULL )
+    {
+        TableRelease( p_sys->p_table );
+        p_sys->p_table = p_table;
+    }
+}
+
+/*****************************************************************************
+ * Resample: convert a buffer
+ *****************************************************************************/
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+
+    if( p_in->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        Reset( p_sys );
+
+    const bool b_first = p_sys->b_first;
+    if( b_first )
+    {
+        date_Init( &p_sys->end_date, i_out_rate, 1 );
+        date_Set( &p_sys->end_date, p_in->i_pts );
+        p_sys->b_first = false;
+    }
+
+    /* Nothing pending and nothing to resample: pass the block through, only
+     * keeping the history */
+    if( i_in_rate == i_out_rate && (uint32_t)p_sys->i_pos == 0
+     && (p_sys->i_pos >> 32) == p_sys->i_buf
+     && p_in->i_nb_samples >= POLY_HALF - 1 )
+    {
+        p_sys->i_buf = 0;
+        p_sys->i_pos = 0;
+        Append( p_sys, p_in->p_buffer + (p_in->i_nb_samples - (POLY_HALF - 1))
+                       * p_filter->fmt_in.audio.i_bytes_per_frame,
+                POLY_HALF - 1 );
+        p_sys->i_pos = (uint64_t)p_sys->i_buf << 32;
+        date_Set( &p_sys->end_date, p_in->i_pts );
+        date_Increment( &p_sys->end_date, p_in->i_nb_samples );
+        return p_in;
+    }
+
+    if( Reserve( p_sys, p_in->i_nb_samples ) )
+    {
+        block_Release( p_in );
+        return NULL;
+    }
+    Append( p_sys, p_in->p_buffer, p_in->i_nb_samples );
+    UpdateTable( p_filter, i_in_rate );
+
+    block_t *p_out = Process( p_filter, i_in_rate );
+    if( p_out != NULL && b_first )
+        p_out->i_flags |= BLOCK_FLAG_DISCONTINUITY;
+    block_Release( p_in );
+    return p_out;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    Reset( p_filter->p_sys );
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_first || Reserve( p_sys, POLY_HALF ) )
+        return NULL;
+
+    /* Complete the last samples with silence */
+    Append( p_sys, NULL, POLY_HALF );
+    block_t *p_out = Process( p_filter, p_filter->fmt_in.audio.i_rate );
+    Reset( p_sys );
+    return p_out;
+}
+
+/*****************************************************************************
+ * Open: allocate the resampler
+ *****************************************************************************/
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( (p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32
+      && p_filter->fmt_in.audio.i_format != VLC_CODEC_S16N)
+     || p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format
+     || p_filter->fmt_in.audio.i_physical_channels
+                                 != p_filter->fmt_out.audio.i_physical_channels
+     || p_filter->fmt_in.audio.i_original_channels
+                                 != p_filter->fmt_out.audio.i_original_channels
+     || p_filter->fmt_in.audio.i_rate == 0
+     || p_filter->fmt_out.audio.i_rate == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->p_table = TableGet( CutoffKey( p_filter->fmt_in.audio.i_rate,
+                                          p_filter->fmt_out.audio.i_rate ) );
+    p_sys->i_channels = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    p_sys->b_s16 = p_filter->fmt_in.audio.i_format == VLC_CODEC_S16N;
+    p_sys->i_buf_size = POLY_TAPS;
+    p_sys->p_buf = malloc( p_sys->i_channels * p_sys->i_buf_size
+                           * sizeof (float) );
+    if( unlikely(p_sys->p_table == NULL || p_sys->p_buf == NULL) )
+    {
+        if( p_sys->p_table != NULL )
+            TableRelease( p_sys->p_table );
+        free( p_sys->p_buf );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    p_sys->pf_dot = DotC;
+#ifdef HAVE_SSE2_INTRINSICS
+    if( vlc_CPU_SSE() )
+        p_sys->pf_dot = DotSSE;
+#endif
+    Reset( p_sys );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_flush = Flush;
+    p_filter->pf_audio_drain = Drain;
+    return VLC_SUCCESS;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    TableRelease( p_sys->p_table );
+    free( p_sys->p_buf );
+    free( p_sys );
+}
@@ -6,6 +6,9 @@
 
 #include "allpass.hpp"
 #include <stddef.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 allpass::allpass()
 {
@@ -19,6 +22,55 @@ void allpass::setbuffer(float *buf, int size)
     bufsize = size;
 }
 
+// Filters numsamples samples in place, a run of the buffer at once, as
+// comb::processblock()
+void allpass::processblock(float *samples, int numsamples)
+{
+    while (numsamples > 0)
+    {
+        float *buf = buffer + bufidx;
+        int n = bufsize - bufidx;
+        if (n > numsamples)
+            n = numsamples;
+
+        int i = 0;
+#ifdef __SSE__
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 min = _mm_set1_ps(FLT_MIN);
+        const __m128 negmin = _mm_set1_ps(-FLT_MIN);
+        const __m128 vfeedback = _mm_set1_ps(feedback);
+        const __m128 sign = _mm_set1_ps(-0.f);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 bufout = _mm_loadu_ps(buf + i);
+            bufout = _mm_andnot_ps(_mm_and_ps(
+                        _mm_and_ps(_mm_cmplt_ps(bufout, min),
+                                   _mm_cmpgt_ps(bufout, negmin)),
+                        _mm_cmpneq_ps(bufout, zero)), bufout);
+            __m128 input = _mm_loadu_ps(samples + i);
+            _mm_storeu_ps(samples + i, _mm_add_ps(_mm_xor_ps(input, sign),
+                                                  bufout));
+            _mm_storeu_ps(buf + i, _mm_add_ps(input,
+                                              _mm_mul_ps(bufout, vfeedback)));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            float bufout = undenormalise(buf[i]);
+            float input = samples[i];
+            samples[i] = -input + bufout;
+            buf[i] = input + (bufout*feedback);
+        }
+
+        bufidx += n;
+        if (bufidx >= bufsize)
+            bufidx = 0;
+        samples += n;
+        numsamples -= n;
+    }
+}
+
 void allpass::mute()
 {
     for (int i=0; i<bufsize; i++)
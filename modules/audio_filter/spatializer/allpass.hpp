@@ -14,6 +14,7 @@ public:
         allpass();
     void    setbuffer(float *buf, int size);
     inline  float    process(float inp);
+    void    processblock(float *samples, int numsamples);
     void    mute();
     void    setfeedback(float val);
     float    getfeedback();
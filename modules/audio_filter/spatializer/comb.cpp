@@ -6,6 +6,9 @@
 
 #include "comb.hpp"
 #include <stddef.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 
 comb::comb()
 {
@@ -20,6 +23,61 @@ void comb::setbuffer(float *buf, int size)
     bufsize = size;
 }
 
+// Adds the outputs for numsamples inputs to output[]. A sample only depends
+// on the one written bufsize samples earlier, so that the samples of a run
+// of the buffer are computed in parallel, with the same operations as
+// process().
+void comb::processblock(const float *input, float *output, int numsamples)
+{
+    while (numsamples > 0)
+    {
+        float *buf = buffer + bufidx;
+        int n = bufsize - bufidx;
+        if (n > numsamples)
+            n = numsamples;
+
+        int i = 0;
+#ifdef __SSE__
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 min = _mm_set1_ps(FLT_MIN);
+        const __m128 negmin = _mm_set1_ps(-FLT_MIN);
+        const __m128 vdamp2 = _mm_set1_ps(damp2);
+        const __m128 vfeedback = _mm_set1_ps(feedback);
+// undenormalise() on 4 samples
+#define UNDENORMALISE(x) _mm_andnot_ps(_mm_and_ps( \
+            _mm_and_ps(_mm_cmplt_ps(x, min), _mm_cmpgt_ps(x, negmin)), \
+            _mm_cmpneq_ps(x, zero)), x)
+
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128 out = _mm_loadu_ps(buf + i);
+            out = UNDENORMALISE(out);
+            __m128 store = _mm_mul_ps(out, vdamp2);
+            store = UNDENORMALISE(store);
+            _mm_storeu_ps(buf + i, _mm_add_ps(_mm_loadu_ps(input + i),
+                                              _mm_mul_ps(store, vfeedback)));
+            _mm_storeu_ps(output + i, _mm_add_ps(_mm_loadu_ps(output + i),
+                                                 out));
+        }
+#undef UNDENORMALISE
+#endif
+        for (; i < n; i++)
+        {
+            float out = undenormalise(buf[i]);
+            float store = undenormalise(out*damp2);
+            buf[i] = input[i] + store*feedback;
+            output[i] += out;
+        }
+
+        bufidx += n;
+        if (bufidx >= bufsize)
+            bufidx = 0;
+        input += n;
+        output += n;
+        numsamples -= n;
+    }
+}
+
 void comb::mute()
 {
     for (int i=0; i<bufsize; i++)
@@ -19,6 +19,7 @@ public:
     comb();
     void    setbuffer(float *buf, int size);
     inline  float    process(float inp);
+    void    processblock(const float *input, float *output, int numsamples);
     void    mute();
     void    setdamp(float val);
     float    getdamp();
@@ -8,11 +8,17 @@
 #ifndef _denormals_
 #define _denormals_
 
+#include <float.h>
+#include <math.h>
 
-#ifdef __cplusplus
-extern "C"
-#endif
-float undenormalise( float );
+// Flushes subnormal numbers to zero. Inlined, as it is called for every
+// sample of every comb and allpass.
+static inline float undenormalise( float f )
+{
+    if( f != 0.f && fabsf( f ) < FLT_MIN )
+        return 0.f;
+    return f;
+}
 
 #endif//_denormals_
 
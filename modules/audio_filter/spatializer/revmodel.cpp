@@ -89,70 +89,80 @@ void revmodel::mute()
  * /param long numsamples  number of samples to be processed
  * /param int skip             number of channels in the audio stream
  *****************************************************************************/
-void revmodel::processreplace(float *inputL, float *outputL, long /* numsamples */, int skip)
+void revmodel::processreplace(float *inputL, float *outputL, long numsamples, int skip)
 {
-    float outL,outR,input;
-    float inputR;
-    int i;
-
-    outL = outR = 0;
-        /* TODO this module supports only 2 audio channels, let's improve this */
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
-
-        // Accumulate comb filters in parallel
-        for(i=0; i<numcombs; i++)
-        {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
-        }
-
-        // Feed through allpasses in series
-        for(i=0; i<numallpasses; i++)
-        {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
-        }
+    process(inputL, outputL, numsamples, skip, false);
+}
 
-        // Calculate output REPLACING anything already there
-        outputL[0] = (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] = (outR*wet1 + outL*wet2 + inputR*dry);
+void revmodel::processmix(float *inputL, float *outputL, long numsamples, int skip)
+{
+    process(inputL, outputL, numsamples, skip, true);
 }
 
-void revmodel::processmix(float *inputL, float *outputL, long /* numsamples */, int skip)
+/* The samples go through the filters by blocks: each comb and allpass
+ * filters a whole block before the next one, which gives the same output as
+ * running them all sample by sample, since a filter only depends on its own
+ * input and state. The output can be the input buffer. */
+void revmodel::process(float *inputL, float *outputL, long numsamples,
+                       int skip, bool mix)
 {
-    float outL,outR,input;
-    float inputR;
+    float input[blocksize], inputR[blocksize];
+    float outL[blocksize], outR[blocksize];
+
+    while (numsamples > 0)
+    {
+        int n = numsamples < blocksize ? numsamples : blocksize;
+        int i;
 
-    outL = outR = 0;
-        if (skip > 1)
-           inputR = inputL[1];
-        else
-           inputR = inputL[0];
-        input = (inputL[0] + inputR) * gain;
+        /* TODO this module supports only 2 audio channels, let's improve this */
+        for (i = 0; i < n; i++)
+        {
+            const float *in = inputL + i * skip;
+
+            inputR[i] = (skip > 1) ? in[1] : in[0];
+            input[i] = (in[0] + inputR[i]) * gain;
+            outL[i] = outR[i] = 0;
+        }
 
         // Accumulate comb filters in parallel
-        for(int i=0; i<numcombs; i++)
+        for (i = 0; i < numcombs; i++)
         {
-            outL += combL[i].process(input);
-            outR += combR[i].process(input);
+            combL[i].processblock(input, outL, n);
+            combR[i].processblock(input, outR, n);
         }
 
         // Feed through allpasses in series
-        for(int i=0; i<numallpasses; i++)
+        for (i = 0; i < numallpasses; i++)
         {
-            outL = allpassL[i].process(outL);
-            outR = allpassR[i].process(outR);
+            allpassL[i].processblock(outL, n);
+            allpassR[i].processblock(outR, n);
         }
 
-        // Calculate output REPLACING anything already there
-        outputL[0] += (outL*wet1 + outR*wet2 + inputR*dry);
-           if (skip > 1)
-        outputL[1] += (outR*wet1 + outL*wet2 + inputR*dry);
+        // Calculate output REPLACING or MIXING with anything already there
+        for (i = 0; i < n; i++)
+        {
+            float *out = outputL + i * skip;
+            float left = outL[i]*wet1 + outR[i]*wet2 + inputR[i]*dry;
+            float right = outR[i]*wet1 + outL[i]*wet2 + inputR[i]*dry;
+
+            if (mix)
+            {
+                out[0] += left;
+                if (skip > 1)
+                    out[1] += right;
+            }
+            else
+            {
+                out[0] = left;
+                if (skip > 1)
+                    out[1] = right;
+            }
+        }
+
+        inputL += n * skip;
+        outputL += n * skip;
+        numsamples -= n;
+    }
 }
 
 void revmodel::update()
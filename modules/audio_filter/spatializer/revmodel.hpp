@@ -15,6 +15,9 @@
 #include "allpass.hpp"
 #include "tuning.h"
 
+// Samples filtered at once by each comb and allpass
+const int blocksize = 256;
+
 class revmodel
 {
 public:
@@ -35,6 +38,8 @@ public:
     void    setmode(float value);
 private:
     void    update();
+    void    process(float *inputL, float *outputL, long numsamples,
+                    int skip, bool mix);
 private:
     float    gain;
     float    roomsize,roomsize1;
@@ -150,6 +150,9 @@ struct encoder_sys_t
     int        i_aac_profile; /* AAC profile to use.*/
 
     AVFrame    *frame;
+
+    /* threads reserved from the instance budget */
+    unsigned   i_reserved_threads;
 };
 
 
@@ -909,7 +912,11 @@ int OpenEncoder( vlc_object_t *p_this )
     if( p_enc->i_threads >= 1)
         p_context->thread_count = p_enc->i_threads;
     else
-        p_context->thread_count = vlc_GetCPUCount();
+    {
+        /* Share the CPUs with the other decoders and encoders */
+        p_sys->i_reserved_threads = vlc_ReserveCPUs( p_enc, vlc_GetCPUCount() );
+        p_context->thread_count = p_sys->i_reserved_threads;
+    }
 
     int ret;
     char *psz_opts = var_InheritString(p_enc, ENC_CFG_PREFIX "options");
@@ -1089,6 +1096,8 @@ errmsg:
 
     return VLC_SUCCESS;
 error:
+    if( p_sys->i_reserved_threads > 0 )
+        vlc_ReleaseCPUs( p_enc, p_sys->i_reserved_threads );
     free( p_enc->fmt_out.p_extra );
     av_free( p_sys->p_buffer );
     av_free( p_sys->p_interleave_buf );
@@ -1499,5 +1508,8 @@ void CloseEncoder( vlc_object_t *p_this )
     av_free( p_sys->p_interleave_buf );
     av_free( p_sys->p_buffer );
 
+    if( p_sys->i_reserved_threads > 0 )
+        vlc_ReleaseCPUs( p_enc, p_sys->i_reserved_threads );
+
     free( p_sys );
 }
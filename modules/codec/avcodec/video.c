@@ -79,6 +79,9 @@ struct decoder_sys_t
     int level;
 
     vlc_sem_t sem_mt;
+
+    /* threads reserved from the instance budget */
+    unsigned i_reserved_threads;
 };
 
 static inline void wait_mt(decoder_sys_t *sys)
@@ -495,6 +498,15 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
 
         //FIXME: take in count the decoding time
         i_thread_count = __MIN( i_thread_count, p_codec->id == AV_CODEC_ID_HEVC ? 6 : 4 );
+
+        /* Standard definition does not need as many threads */
+        unsigned i_pixels = p_dec->fmt_in.video.i_width * p_dec->fmt_in.video.i_height;
+        if( i_pixels > 0 && i_pixels <= 720 * 576 )
+            i_thread_count = __MIN( i_thread_count, 2 );
+
+        /* Share the CPUs with the other decoders and encoders */
+        i_thread_count = vlc_ReserveCPUs( p_dec, i_thread_count );
+        p_sys->i_reserved_threads = i_thread_count;
     }
     i_thread_count = __MIN( i_thread_count, 16 );
     msg_Dbg( p_dec, "allowing %d thread(s) for decoding", i_thread_count );
@@ -554,6 +566,8 @@ int InitVideoDec( decoder_t *p_dec, AVCodecContext *p_context,
     /* ***** Open the codec ***** */
     if( OpenVideoCodec( p_dec ) < 0 )
     {
+        if( p_sys->i_reserved_threads > 0 )
+            vlc_ReleaseCPUs( p_dec, p_sys->i_reserved_threads );
         vlc_sem_destroy( &p_sys->sem_mt );
         free( p_sys );
         return VLC_EGENERIC;
@@ -1062,6 +1076,9 @@ void EndVideoDec( decoder_t *p_dec )
     if( p_sys->p_va )
         vlc_va_Delete( p_sys->p_va, p_sys->p_context );
 
+    if( p_sys->i_reserved_threads > 0 )
+        vlc_ReleaseCPUs( p_dec, p_sys->i_reserved_threads );
+
     vlc_sem_destroy( &p_sys->sem_mt );
 }
 
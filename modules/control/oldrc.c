@@ -1752,6 +1752,13 @@ static int updateStatistics( intf_thread_t *p_intf, input_item_t *p_item )
     msg_rc(_("| buffers lost     :    %5"PRIi64),
             p_item->p_stats->i_lost_abuffers );
     msg_rc("|");
+    /* Threads */
+    msg_rc("%s", _("+-[Decoding Threads]"));
+    msg_rc(_("| threads reserved :    %5"PRIi64),
+            p_item->p_stats->i_reserved_threads );
+    msg_rc(_("| threads budget   :    %5"PRIi64),
+            p_item->p_stats->i_threads_budget );
+    msg_rc("|");
     /* Sout */
     msg_rc("%s", _("+-[Streaming]"));
     msg_rc(_("| packets sent     :    %5"PRIi64),
@@ -38,6 +38,8 @@
 #include <vlc_input.h>
 
 #include <vlc_dialog.h>
+#include <vlc_atomic.h>
+#include <vlc_fs.h>
 
 #include <vlc_meta.h>
 #include <vlc_codecs.h>
@@ -46,6 +48,7 @@
 
 #include "libavi.h"
 #include "../rawdv.h"
+#include "../index_cache.h"
 
 /*****************************************************************************
  * Module descriptor
@@ -58,6 +61,11 @@
     "Recreate a index for the AVI file. Use this if your AVI file is damaged "\
     "or incomplete (not seekable)." )
 
+#define INDEX_CACHE_TEXT N_("Cache created index")
+#define INDEX_CACHE_LONGTEXT N_( \
+    "Store the index created for a damaged AVI file in the user cache " \
+    "directory, and reuse it when the same file is opened again." )
+
 #define BI_RAWRGB 0x00
 #define BI_RGBBITFIELDS 0x03
 
@@ -83,6 +91,8 @@ vlc_module_begin ()
     add_integer( "avi-index", 0,
               INDEX_TEXT, INDEX_LONGTEXT, false )
         change_integer_list( pi_index, ppsz_indexes )
+    add_bool( "avi-index-cache", false,
+              INDEX_CACHE_TEXT, INDEX_CACHE_LONGTEXT, true )
 
     set_callbacks( Open, Close )
 vlc_module_end ()
@@ -141,6 +151,25 @@ static void avi_index_Init( avi_index_t * );
 static void avi_index_Clean( avi_index_t * );
 static void avi_index_Append( avi_index_t *, off_t *, avi_entry_t * );
 
+typedef struct
+{
+    vlc_thread_t    thread;
+    vlc_mutex_t     lock;
+    atomic_bool     b_abort;
+    stream_t        *s;             /* private stream */
+
+    off_t           i_movi_start;
+    off_t           i_movi_end;
+    off_t           i_riff1_start;  /* OpenDML second RIFF, -1 if none */
+
+    /* protected by lock */
+    avi_index_t     *p_index;       /* one per track */
+    unsigned int    *pi_merged;     /* entries already merged per track */
+    off_t           i_last_pos;
+    bool            b_done;
+    bool            b_complete;
+} avi_indexer_t;
+
 typedef struct
 {
     bool            b_activated;
@@ -191,6 +220,8 @@ struct demux_sys_t
     off_t   i_movi_begin;
     off_t   i_movi_lastchunk_pos;   /* XXX position of last valid chunk */
 
+    avi_indexer_t *p_indexer; /* background index creation, if running */
+
     /* number of streams and information */
     unsigned int i_track;
     avi_track_t  **track;
@@ -222,18 +253,24 @@ static int AVI_StreamBytesSet ( demux_t *,
 vlc_fourcc_t AVI_FourccGetCodec( unsigned int i_cat, vlc_fourcc_t );
 static int   AVI_GetKeyFlag    ( vlc_fourcc_t , uint8_t * );
 
-static int AVI_PacketGetHeader( demux_t *, avi_packet_t *p_pk );
-static int AVI_PacketNext     ( demux_t * );
-static int AVI_PacketSearch   ( demux_t * );
+static int AVI_PacketGetHeader( stream_t *, avi_packet_t *p_pk );
+static int AVI_PacketNext     ( stream_t * );
+static int AVI_PacketSearch   ( demux_t *, stream_t * );
 
 static void AVI_IndexLoad    ( demux_t * );
 static void AVI_IndexCreate  ( demux_t * );
+static void AVI_IndexerMerge ( demux_t * );
+static void AVI_IndexerDelete( demux_t * );
+static void AVI_IndexFixBeOS ( demux_t * );
+static int  AVI_IndexCacheLoad ( demux_t * );
+static void AVI_IndexCacheStore( demux_t * );
 
 static void AVI_ExtractSubtitle( demux_t *, unsigned int i_stream, avi_chunk_list_t *, avi_chunk_STRING_t * );
 
 static void AVI_DvHandleAudio( demux_t *, avi_track_t *, block_t * );
 
 static mtime_t  AVI_MovieGetLength( demux_t * );
+static mtime_t  AVI_IndexGetLength( demux_t * );
 
 static void AVI_MetaLoad( demux_t *, avi_chunk_list_t *p_riff, avi_chunk_avih_t *p_avih );
 
@@ -765,6 +802,13 @@ aviindex:
     {
         msg_Warn( p_demux, "broken or missing index, 'seek' will be "
                            "approximative or will exhibit strange behavior" );
+        if( (i_do_index == 0 || i_do_index == 3) && !b_index &&
+            p_sys->b_fastseekable && AVI_IndexCacheLoad( p_demux ) == VLC_SUCCESS )
+        {
+            b_index = true;
+            p_sys->b_indexloaded = true;
+            p_sys->i_length = AVI_MovieGetLength( p_demux );
+        }
         if( (i_do_index == 0 || i_do_index == 3) && !b_index )
         {
             if( !p_sys->b_fastseekable ) {
@@ -807,44 +851,7 @@ aviindex:
     }
 
     /* fix some BeOS MediaKit generated file */
-    for( i = 0 ; i < p_sys->i_track; i++ )
-    {
-        avi_track_t         *tk = p_sys->track[i];
-        avi_chunk_list_t    *p_strl;
-        avi_chunk_strf_auds_t    *p_auds;
-
-        if( tk->i_cat != AUDIO_ES )
-        {
-            continue;
-        }
-        if( tk->idx.i_size < 1 ||
-            tk->i_scale != 1 ||
-            tk->i_samplesize != 0 )
-        {
-            continue;
-        }
-        p_strl = AVI_ChunkFind( p_hdrl, AVIFOURCC_strl, i );
-        p_auds = AVI_ChunkFind( p_strl, AVIFOURCC_strf, 0 );
-
-        if( p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
-            tk->i_rate == p_auds->p_wf->nSamplesPerSec )
-        {
-            int64_t i_track_length =
-                tk->idx.p_entry[tk->idx.i_size-1].i_length +
-                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
-            mtime_t i_length = (mtime_t)p_avih->i_totalframes *
-                               (mtime_t)p_avih->i_microsecperframe;
-
-            if( i_length == 0 )
-            {
-                msg_Warn( p_demux, "track[%u] cannot be fixed (BeOS MediaKit generated)", i );
-                continue;
-            }
-            tk->i_samplesize = 1;
-            tk->i_rate       = i_track_length  * CLOCK_FREQ / i_length;
-            msg_Warn( p_demux, "track[%u] fixed with rate=%u scale=%u (BeOS MediaKit generated)", i, tk->i_rate, tk->i_scale );
-        }
-    }
+    AVI_IndexFixBeOS( p_demux );
 
     if( p_sys->b_seekable )
     {
@@ -878,6 +885,9 @@ static void Close ( vlc_object_t * p_this )
     demux_t *    p_demux = (demux_t *)p_this;
     demux_sys_t *p_sys = p_demux->p_sys  ;
 
+    if( p_sys->p_indexer )
+        AVI_IndexerDelete( p_demux );
+
     for( unsigned int i = 0; i < p_sys->i_track; i++ )
     {
         if( p_sys->track[i] )
@@ -1001,6 +1011,7 @@ static int Demux_Seekable( demux_t *p_demux )
     /* cannot be more than 100 stream (dcXX or wbXX) */
     avi_track_toread_t toread[100];
 
+    AVI_IndexerMerge( p_demux );
 
     /* detect new selected/unselected streams */
     for( i_track = 0; i_track < p_sys->i_track; i_track++ )
@@ -1138,7 +1149,7 @@ static int Demux_Seekable( demux_t *p_demux )
             if( p_sys->b_seekable && p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
             {
                 vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return( AVI_TrackStopFinishedStreams( p_demux ) ? 0 : 1 );
                 }
@@ -1152,7 +1163,7 @@ static int Demux_Seekable( demux_t *p_demux )
             {
                 avi_packet_t avi_pk;
 
-                if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+                if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
                 {
                     msg_Warn( p_demux,
                              "cannot get packet header, track disabled" );
@@ -1161,7 +1172,7 @@ static int Demux_Seekable( demux_t *p_demux )
                 if( avi_pk.i_stream >= p_sys->i_track ||
                     ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
                 {
-                    if( AVI_PacketNext( p_demux ) )
+                    if( AVI_PacketNext( p_demux->s ) )
                     {
                         msg_Warn( p_demux,
                                   "cannot skip packet, track disabled" );
@@ -1202,7 +1213,7 @@ static int Demux_Seekable( demux_t *p_demux )
                     }
                     else
                     {
-                        if( AVI_PacketNext( p_demux ) )
+                        if( AVI_PacketNext( p_demux->s ) )
                         {
                             msg_Warn( p_demux,
                                       "cannot skip packet, track disabled" );
@@ -1402,7 +1413,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
 
         avi_packet_t    avi_pk;
 
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1419,18 +1430,18 @@ static int Demux_UnSeekable( demux_t *p_demux )
                 case AVIFOURCC_JUNK:
                 case AVIFOURCC_LIST:
                 case AVIFOURCC_RIFF:
-                    return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                    return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                 case AVIFOURCC_idx1:
                     if( p_sys->b_odml )
                     {
-                        return( !AVI_PacketNext( p_demux ) ? 1 : 0 );
+                        return( !AVI_PacketNext( p_demux->s ) ? 1 : 0 );
                     }
                     return VLC_DEMUXER_EOF;
                 default:
                     msg_Warn( p_demux,
                               "seems to have lost position @%"PRIu64", resync",
                               vlc_stream_Tell(p_demux->s) );
-                    if( AVI_PacketSearch( p_demux ) )
+                    if( AVI_PacketSearch( p_demux, p_demux->s ) )
                     {
                         msg_Err( p_demux, "resync failed" );
                         return VLC_DEMUXER_EGENERIC;
@@ -1466,7 +1477,7 @@ static int Demux_UnSeekable( demux_t *p_demux )
             }
             else
             {
-                if( AVI_PacketNext( p_demux ) )
+                if( AVI_PacketNext( p_demux->s ) )
                 {
                     return VLC_DEMUXER_EOF;
                 }
@@ -1506,6 +1517,8 @@ static int Seek( demux_t *p_demux, mtime_t i_date, int i_percent )
     {
         int64_t i_pos_backup = vlc_stream_Tell( p_demux->s );
 
+        AVI_IndexerMerge( p_demux );
+
         /* Check and lazy load indexes if it was not done (not fastseekable) */
         if ( !p_sys->b_indexloaded && ( p_sys->i_avih_flags & AVIF_HASINDEX ) )
         {
@@ -1837,7 +1850,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
     if( p_sys->i_movi_lastchunk_pos >= p_sys->i_movi_begin + 12 )
     {
         vlc_stream_Seek( p_demux->s, p_sys->i_movi_lastchunk_pos );
-        if( AVI_PacketNext( p_demux ) )
+        if( AVI_PacketNext( p_demux->s ) )
         {
             return VLC_EGENERIC;
         }
@@ -1849,7 +1862,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
 
     for( ;; )
     {
-        if( AVI_PacketGetHeader( p_demux, &avi_pk ) )
+        if( AVI_PacketGetHeader( p_demux->s, &avi_pk ) )
         {
             msg_Warn( p_demux, "cannot get packet header" );
             return VLC_EGENERIC;
@@ -1857,7 +1870,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
         if( avi_pk.i_stream >= p_sys->i_track ||
             ( avi_pk.i_cat != AUDIO_ES && avi_pk.i_cat != VIDEO_ES ) )
         {
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -1891,7 +1904,7 @@ static int AVI_StreamChunkFind( demux_t *p_demux, unsigned int i_stream )
                 return VLC_SUCCESS;
             }
 
-            if( AVI_PacketNext( p_demux ) )
+            if( AVI_PacketNext( p_demux->s ) )
             {
                 return VLC_EGENERIC;
             }
@@ -2189,17 +2202,17 @@ static void AVI_ParseStreamHeader( vlc_fourcc_t i_id,
 /****************************************************************************
  *
  ****************************************************************************/
-static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
+static int AVI_PacketGetHeader( stream_t *s, avi_packet_t *p_pk )
 {
     const uint8_t *p_peek;
 
-    if( vlc_stream_Peek( p_demux->s, &p_peek, 16 ) < 16 )
+    if( vlc_stream_Peek( s, &p_peek, 16 ) < 16 )
     {
         return VLC_EGENERIC;
     }
     p_pk->i_fourcc  = VLC_FOURCC( p_peek[0], p_peek[1], p_peek[2], p_peek[3] );
     p_pk->i_size    = GetDWLE( p_peek + 4 );
-    p_pk->i_pos     = vlc_stream_Tell( p_demux->s );
+    p_pk->i_pos     = vlc_stream_Tell( s );
     if( p_pk->i_fourcc == AVIFOURCC_LIST || p_pk->i_fourcc == AVIFOURCC_RIFF )
     {
         p_pk->i_type = VLC_FOURCC( p_peek[8],  p_peek[9],
@@ -2216,12 +2229,12 @@ static int AVI_PacketGetHeader( demux_t *p_demux, avi_packet_t *p_pk )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketNext( demux_t *p_demux )
+static int AVI_PacketNext( stream_t *s )
 {
     avi_packet_t    avi_ck;
     size_t          i_skip = 0;
 
-    if( AVI_PacketGetHeader( p_demux, &avi_ck ) )
+    if( AVI_PacketGetHeader( s, &avi_ck ) )
     {
         return VLC_EGENERIC;
     }
@@ -2246,7 +2259,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     if( i_skip > SSIZE_MAX )
         return VLC_EGENERIC;
 
-    ssize_t i_ret = vlc_stream_Read( p_demux->s, NULL, i_skip );
+    ssize_t i_ret = vlc_stream_Read( s, NULL, i_skip );
     if( i_ret < 0 || (size_t) i_ret != i_skip )
     {
         return VLC_EGENERIC;
@@ -2254,7 +2267,7 @@ static int AVI_PacketNext( demux_t *p_demux )
     return VLC_SUCCESS;
 }
 
-static int AVI_PacketSearch( demux_t *p_demux )
+static int AVI_PacketSearch( demux_t *p_demux, stream_t *s )
 {
     demux_sys_t     *p_sys = p_demux->p_sys;
     avi_packet_t    avi_pk;
@@ -2262,11 +2275,11 @@ static int AVI_PacketSearch( demux_t *p_demux )
 
     for( ;; )
     {
-        if( vlc_stream_Read( p_demux->s, NULL, 1 ) != 1 )
+        if( vlc_stream_Read( s, NULL, 1 ) != 1 )
         {
             return VLC_EGENERIC;
         }
-        AVI_PacketGetHeader( p_demux, &avi_pk );
+        AVI_PacketGetHeader( s, &avi_pk );
         if( avi_pk.i_stream < p_sys->i_track &&
             ( avi_pk.i_cat == AUDIO_ES || avi_pk.i_cat == VIDEO_ES ) )
         {
@@ -2615,41 +2628,88 @@ static void AVI_IndexLoad( demux_t *p_demux )
     }
 }
 
-static void AVI_IndexCreate( demux_t *p_demux )
+/* Fix the rate of the audio tracks of BeOS MediaKit generated files, it must
+ * run once the index is known */
+static void AVI_IndexFixBeOS( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
-    avi_chunk_list_t *p_riff;
-    avi_chunk_list_t *p_movi;
+    avi_chunk_list_t *p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0 );
+    avi_chunk_list_t *p_hdrl = AVI_ChunkFind( p_riff, AVIFOURCC_hdrl, 0 );
+    avi_chunk_avih_t *p_avih = AVI_ChunkFind( p_hdrl, AVIFOURCC_avih, 0 );
+    if( !p_avih )
+        return;
 
-    unsigned int i_stream;
-    off_t i_movi_end;
+    for( unsigned i = 0 ; i < p_sys->i_track; i++ )
+    {
+        avi_track_t         *tk = p_sys->track[i];
+        avi_chunk_list_t    *p_strl;
+        avi_chunk_strf_auds_t    *p_auds;
 
-    mtime_t i_dialog_update;
-    vlc_dialog_id *p_dialog_id = NULL;
+        if( tk->i_cat != AUDIO_ES )
+        {
+            continue;
+        }
+        if( tk->idx.i_size < 1 ||
+            tk->i_scale != 1 ||
+            tk->i_samplesize != 0 )
+        {
+            continue;
+        }
+        p_strl = AVI_ChunkFind( p_hdrl, AVIFOURCC_strl, i );
+        p_auds = AVI_ChunkFind( p_strl, AVIFOURCC_strf, 0 );
 
-    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
-    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
+        if( p_auds->p_wf->wFormatTag != WAVE_FORMAT_PCM &&
+            tk->i_rate == p_auds->p_wf->nSamplesPerSec )
+        {
+            int64_t i_track_length =
+                tk->idx.p_entry[tk->idx.i_size-1].i_length +
+                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal;
+            mtime_t i_length = (mtime_t)p_avih->i_totalframes *
+                               (mtime_t)p_avih->i_microsecperframe;
 
-    if( !p_movi )
-    {
-        msg_Err( p_demux, "cannot find p_movi" );
-        return;
+            if( i_length == 0 )
+            {
+                msg_Warn( p_demux, "track[%u] cannot be fixed (BeOS MediaKit generated)", i );
+                continue;
+            }
+            tk->i_samplesize = 1;
+            tk->i_rate       = i_track_length  * CLOCK_FREQ / i_length;
+            msg_Warn( p_demux, "track[%u] fixed with rate=%u scale=%u (BeOS MediaKit generated)", i, tk->i_rate, tk->i_scale );
+        }
     }
+}
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
-        avi_index_Init( &p_sys->track[i_stream]->idx );
+/*****************************************************************************
+ * Background index creation
+ *****************************************************************************
+ * The LIST-movi is walked on a private stream by a low priority thread, so
+ * that playback can start at once. Its entries are merged into the tracks
+ * index by the demux thread (AVI_IndexerMerge), extending the seekable
+ * range as the walk goes on.
+ *****************************************************************************/
+static void *AVI_IndexerThread( void *data )
+{
+    demux_t *p_demux = data;
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_idxr = p_sys->p_indexer;
+    stream_t *s = p_idxr->s;
 
-    i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
-                        stream_Size( p_demux->s ) );
+    mtime_t i_dialog_update;
+    vlc_dialog_id *p_dialog_id = NULL;
+    bool b_complete = true;
 
-    vlc_stream_Seek( p_demux->s, p_movi->i_chunk_pos + 12 );
+    if( vlc_stream_Seek( s, p_idxr->i_movi_start ) )
+    {
+        msg_Err( p_demux, "cannot seek to LIST-movi, abort index creation" );
+        b_complete = false;
+        goto end;
+    }
     msg_Warn( p_demux, "creating index from LIST-movi, will take time !" );
 
-
     /* Only show dialog if AVI is > 10MB */
     i_dialog_update = mdate();
-    if( stream_Size( p_demux->s ) > 10000000 )
+    if( stream_Size( s ) > 10000000 )
     {
         p_dialog_id =
             vlc_dialog_display_progress( p_demux, false, 0.0, _("Cancel"),
@@ -2661,21 +2721,30 @@ static void AVI_IndexCreate( demux_t *p_demux )
     {
         avi_packet_t pk;
 
+        if( atomic_load( &p_idxr->b_abort ) )
+        {
+            b_complete = false;
+            break;
+        }
+
         /* Don't update/check dialog too often */
         if( p_dialog_id != NULL && mdate() - i_dialog_update > 100000 )
         {
             if( vlc_dialog_is_cancelled( p_demux, p_dialog_id ) )
+            {
+                b_complete = false;
                 break;
+            }
 
-            double f_current = vlc_stream_Tell( p_demux->s );
-            double f_size    = stream_Size( p_demux->s );
+            double f_current = vlc_stream_Tell( s );
+            double f_size    = stream_Size( s );
             double f_pos     = f_current / f_size;
             vlc_dialog_update_progress( p_demux, p_dialog_id, f_pos );
 
             i_dialog_update = mdate();
         }
 
-        if( AVI_PacketGetHeader( p_demux, &pk ) )
+        if( AVI_PacketGetHeader( s, &pk ) )
             break;
 
         if( pk.i_stream < p_sys->i_track &&
@@ -2689,26 +2758,25 @@ static void AVI_IndexCreate( demux_t *p_demux )
             index.i_pos     = pk.i_pos;
             index.i_length  = pk.i_size;
             index.i_lengthtotal = pk.i_size;
-            avi_index_Append( &tk->idx, &p_sys->i_movi_lastchunk_pos, &index );
+
+            vlc_mutex_lock( &p_idxr->lock );
+            avi_index_Append( &p_idxr->p_index[pk.i_stream],
+                              &p_idxr->i_last_pos, &index );
+            vlc_mutex_unlock( &p_idxr->lock );
         }
         else
         {
             switch( pk.i_fourcc )
             {
             case AVIFOURCC_idx1:
-                if( p_sys->b_odml )
+                if( p_sys->b_odml && p_idxr->i_riff1_start >= 0 )
                 {
-                    avi_chunk_list_t *p_sysx;
-                    p_sysx = AVI_ChunkFind( &p_sys->ck_root,
-                                            AVIFOURCC_RIFF, 1 );
-
                     msg_Dbg( p_demux, "looking for new RIFF chunk" );
-                    if( vlc_stream_Seek( p_demux->s,
-                                         p_sysx->i_chunk_pos + 24 ) )
-                        goto print_stat;
+                    if( vlc_stream_Seek( s, p_idxr->i_riff1_start ) )
+                        goto end;
                     break;
                 }
-                goto print_stat;
+                goto end;
 
             case AVIFOURCC_RIFF:
                     msg_Dbg( p_demux, "new RIFF chunk found" );
@@ -2720,30 +2788,330 @@ static void AVI_IndexCreate( demux_t *p_demux )
 
             default:
                 msg_Warn( p_demux, "need resync, probably broken avi" );
-                if( AVI_PacketSearch( p_demux ) )
+                if( AVI_PacketSearch( p_demux, s ) )
                 {
                     msg_Warn( p_demux, "lost sync, abord index creation" );
-                    goto print_stat;
+                    goto end;
                 }
             }
         }
 
-        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= i_movi_end ) ||
-            AVI_PacketNext( p_demux ) )
+        if( ( !p_sys->b_odml && pk.i_pos + pk.i_size >= p_idxr->i_movi_end ) ||
+            AVI_PacketNext( s ) )
         {
             break;
         }
     }
 
-print_stat:
+end:
     if( p_dialog_id != NULL )
         vlc_dialog_release( p_demux, p_dialog_id );
 
-    for( i_stream = 0; i_stream < p_sys->i_track; i_stream++ )
+    vlc_mutex_lock( &p_idxr->lock );
+    p_idxr->b_done = true;
+    p_idxr->b_complete = b_complete;
+    vlc_mutex_unlock( &p_idxr->lock );
+
+    return NULL;
+}
+
+static void AVI_IndexerDelete( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_idxr = p_sys->p_indexer;
+
+    if( p_idxr->s != p_demux->s )
     {
-        msg_Dbg( p_demux, "stream[%d] creating %d index entries",
-                i_stream, p_sys->track[i_stream]->idx.i_size );
+        atomic_store( &p_idxr->b_abort, true );
+        vlc_join( p_idxr->thread, NULL );
+        vlc_stream_Delete( p_idxr->s );
     }
+    vlc_mutex_destroy( &p_idxr->lock );
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Clean( &p_idxr->p_index[i] );
+    free( p_idxr->p_index );
+    free( p_idxr->pi_merged );
+    free( p_idxr );
+    p_sys->p_indexer = NULL;
+}
+
+/* Appends to the tracks index the entries found by the indexer past the last
+ * chunk already known by the demuxer */
+static void AVI_IndexerMerge( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+    avi_indexer_t *p_idxr = p_sys->p_indexer;
+    bool b_merged = false;
+
+    if( p_idxr == NULL )
+        return;
+
+    vlc_mutex_lock( &p_idxr->lock );
+    const off_t i_last_pos = p_sys->i_movi_lastchunk_pos;
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        const avi_index_t *p_index = &p_idxr->p_index[i];
+
+        for( ; p_idxr->pi_merged[i] < p_index->i_size; p_idxr->pi_merged[i]++ )
+        {
+            avi_entry_t index = p_index->p_entry[p_idxr->pi_merged[i]];
+            if( index.i_pos <= i_last_pos )
+                continue;
+            avi_index_Append( &p_sys->track[i]->idx,
+                              &p_sys->i_movi_lastchunk_pos, &index );
+            b_merged = true;
+        }
+    }
+    const bool b_done = p_idxr->b_done;
+    const bool b_complete = p_idxr->b_complete;
+    vlc_mutex_unlock( &p_idxr->lock );
+
+    if( b_merged )
+        p_sys->i_length = __MAX( p_sys->i_length, AVI_IndexGetLength( p_demux ) );
+
+    if( b_done )
+    {
+        for( unsigned i = 0; i < p_sys->i_track; i++ )
+            msg_Dbg( p_demux, "stream[%d] creating %d index entries",
+                     i, p_sys->track[i]->idx.i_size );
+
+        AVI_IndexerDelete( p_demux );
+        if( b_complete )
+            AVI_IndexCacheStore( p_demux );
+
+        /* the BeOS fix-up of Open had no index to work on */
+        AVI_IndexFixBeOS( p_demux );
+        p_sys->i_length = __MAX( p_sys->i_length, AVI_IndexGetLength( p_demux ) );
+    }
+}
+
+static void AVI_IndexCreate( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    avi_chunk_list_t *p_riff;
+    avi_chunk_list_t *p_movi;
+
+    p_riff = AVI_ChunkFind( &p_sys->ck_root, AVIFOURCC_RIFF, 0);
+    p_movi = AVI_ChunkFind( p_riff, AVIFOURCC_movi, 0);
+
+    if( !p_movi )
+    {
+        msg_Err( p_demux, "cannot find p_movi" );
+        return;
+    }
+
+    if( p_sys->p_indexer )
+        AVI_IndexerDelete( p_demux );
+
+    /* the index is now ours, never reload it from the file */
+    p_sys->b_indexloaded = true;
+
+    if( AVI_IndexCacheLoad( p_demux ) == VLC_SUCCESS )
+        return;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        avi_index_Init( &p_sys->track[i]->idx );
+    }
+    p_sys->i_movi_lastchunk_pos = 0;
+
+    avi_indexer_t *p_idxr = calloc( 1, sizeof( *p_idxr ) );
+    if( !p_idxr )
+        return;
+    p_idxr->p_index = calloc( p_sys->i_track, sizeof( *p_idxr->p_index ) );
+    p_idxr->pi_merged = calloc( p_sys->i_track, sizeof( *p_idxr->pi_merged ) );
+    if( !p_idxr->p_index || !p_idxr->pi_merged )
+    {
+        free( p_idxr->p_index );
+        free( p_idxr->pi_merged );
+        free( p_idxr );
+        return;
+    }
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_idxr->p_index[i] );
+
+    vlc_mutex_init( &p_idxr->lock );
+    atomic_init( &p_idxr->b_abort, false );
+    p_idxr->i_movi_start = p_movi->i_chunk_pos + 12;
+    p_idxr->i_movi_end = __MIN( (off_t)(p_movi->i_chunk_pos + p_movi->i_chunk_size),
+                                stream_Size( p_demux->s ) );
+    p_idxr->i_riff1_start = -1;
+    if( p_sys->b_odml )
+    {
+        avi_chunk_list_t *p_sysx = AVI_ChunkFind( &p_sys->ck_root,
+                                                  AVIFOURCC_RIFF, 1 );
+        if( p_sysx )
+            p_idxr->i_riff1_start = p_sysx->i_chunk_pos + 24;
+    }
+    p_sys->p_indexer = p_idxr;
+
+    /* The walk is done on a private stream so that it does not disturb
+     * the demuxer reads, fallback to a blocking walk otherwise */
+    if( p_demux->s->psz_url )
+        p_idxr->s = vlc_stream_NewURL( p_demux, p_demux->s->psz_url );
+    if( p_idxr->s &&
+        vlc_clone( &p_idxr->thread, AVI_IndexerThread, p_demux,
+                   VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_stream_Delete( p_idxr->s );
+        p_idxr->s = NULL;
+    }
+
+    if( p_idxr->s == NULL )
+    {
+        p_idxr->s = p_demux->s;
+        AVI_IndexerThread( p_demux );
+        AVI_IndexerMerge( p_demux );
+    }
+}
+
+/*****************************************************************************
+ * Index cache: indexes created for broken files are stored in the user cache
+ * directory, keyed by the file URL, and checked against the file size.
+ *****************************************************************************/
+#define AVI_INDEX_CACHE_MAGIC   "VLCAVIDX"
+#define AVI_INDEX_CACHE_VERSION 1
+#define AVI_INDEX_CACHE_ENTRY   20
+
+static char *AVI_IndexCachePath( demux_t *p_demux, bool b_create )
+{
+    const char *psz_url = p_demux->s->psz_url;
+
+    if( !var_InheritBool( p_demux, "avi-index-cache" ) || psz_url == NULL )
+        return NULL;
+
+    return demux_IndexCachePath( "avi-index", psz_url, strlen( psz_url ),
+                                 b_create );
+}
+
+static int AVI_IndexCacheLoad( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    char *psz_path = AVI_IndexCachePath( p_demux, false );
+    if( psz_path == NULL )
+        return VLC_EGENERIC;
+
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( p_file == NULL )
+        return VLC_EGENERIC;
+
+    uint8_t header[24];
+    if( fread( header, sizeof(header), 1, p_file ) != 1 ||
+        memcmp( header, AVI_INDEX_CACHE_MAGIC, 8 ) ||
+        GetDWLE( &header[8] ) != AVI_INDEX_CACHE_VERSION ||
+        GetDWLE( &header[12] ) != p_sys->i_track ||
+        GetQWLE( &header[16] ) != (uint64_t)stream_Size( p_demux->s ) )
+    {
+        fclose( p_file );
+        return VLC_EGENERIC;
+    }
+
+    assert( p_sys->i_track <= 100 );
+    avi_index_t p_idx_cache[p_sys->i_track];
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Init( &p_idx_cache[i] );
+    off_t i_last_pos = 0;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_t *p_index = &p_idx_cache[i];
+        uint8_t count[4];
+
+        if( fread( count, sizeof(count), 1, p_file ) != 1 )
+            goto error;
+
+        for( uint32_t j = GetDWLE( count ); j > 0; j-- )
+        {
+            uint8_t entry[AVI_INDEX_CACHE_ENTRY];
+            if( fread( entry, sizeof(entry), 1, p_file ) != 1 )
+                goto error;
+
+            avi_entry_t index;
+            index.i_id     = GetDWLE( &entry[0] );
+            index.i_flags  = GetDWLE( &entry[4] );
+            index.i_pos    = GetQWLE( &entry[8] );
+            index.i_length = GetDWLE( &entry[16] );
+            index.i_lengthtotal = index.i_length;
+            avi_index_Append( p_index, &i_last_pos, &index );
+            if( p_index->p_entry == NULL )
+                goto error;
+        }
+    }
+    fclose( p_file );
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_index_Clean( &p_sys->track[i]->idx );
+        p_sys->track[i]->idx = p_idx_cache[i];
+        msg_Dbg( p_demux, "stream[%u] loaded %u cached index entries",
+                 i, p_idx_cache[i].i_size );
+    }
+    p_sys->i_movi_lastchunk_pos = i_last_pos;
+    return VLC_SUCCESS;
+
+error:
+    msg_Warn( p_demux, "invalid index cache, discarding it" );
+    fclose( p_file );
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+        avi_index_Clean( &p_idx_cache[i] );
+    return VLC_EGENERIC;
+}
+
+static void AVI_IndexCacheStore( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    char *psz_path = AVI_IndexCachePath( p_demux, true );
+    if( psz_path == NULL )
+        return;
+
+    FILE *p_file = vlc_fopen( psz_path, "wb" );
+    if( p_file == NULL )
+    {
+        msg_Warn( p_demux, "cannot write index cache %s", psz_path );
+        free( psz_path );
+        return;
+    }
+
+    uint8_t header[24];
+    memcpy( header, AVI_INDEX_CACHE_MAGIC, 8 );
+    SetDWLE( &header[8], AVI_INDEX_CACHE_VERSION );
+    SetDWLE( &header[12], p_sys->i_track );
+    SetQWLE( &header[16], stream_Size( p_demux->s ) );
+    bool b_error = fwrite( header, sizeof(header), 1, p_file ) != 1;
+
+    for( unsigned i = 0; i < p_sys->i_track && !b_error; i++ )
+    {
+        const avi_index_t *p_index = &p_sys->track[i]->idx;
+        uint8_t count[4];
+
+        SetDWLE( count, p_index->i_size );
+        b_error = fwrite( count, sizeof(count), 1, p_file ) != 1;
+
+        for( unsigned j = 0; j < p_index->i_size && !b_error; j++ )
+        {
+            uint8_t entry[AVI_INDEX_CACHE_ENTRY];
+            SetDWLE( &entry[0], p_index->p_entry[j].i_id );
+            SetDWLE( &entry[4], p_index->p_entry[j].i_flags );
+            SetQWLE( &entry[8], p_index->p_entry[j].i_pos );
+            SetDWLE( &entry[16], p_index->p_entry[j].i_length );
+            b_error = fwrite( entry, sizeof(entry), 1, p_file ) != 1;
+        }
+    }
+
+    if( fclose( p_file ) || b_error )
+    {
+        msg_Warn( p_demux, "cannot write index cache %s", psz_path );
+        vlc_unlink( psz_path );
+    }
+    else
+        msg_Dbg( p_demux, "index cached in %s", psz_path );
+    free( psz_path );
 }
 
 /* */
@@ -3013,6 +3381,42 @@ static int AVI_TrackStopFinishedStreams( demux_t *p_demux )
 /****************************************************************************
  * AVI_MovieGetLength give max streams length in second
  ****************************************************************************/
+static mtime_t AVI_TrackGetLength( avi_track_t *tk )
+{
+    mtime_t i_length;
+
+    if( tk->i_samplesize )
+    {
+        i_length = AVI_GetDPTS( tk,
+                                tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
+                                    tk->idx.p_entry[tk->idx.i_size-1].i_length );
+    }
+    else
+    {
+        i_length = AVI_GetDPTS( tk, tk->idx.i_size );
+    }
+    return i_length / CLOCK_FREQ;    /* in seconds */
+}
+
+/****************************************************************************
+ * AVI_IndexGetLength: same as AVI_MovieGetLength, without logging
+ ****************************************************************************/
+static mtime_t AVI_IndexGetLength( demux_t *p_demux )
+{
+    demux_sys_t  *p_sys = p_demux->p_sys;
+    mtime_t      i_maxlength = 0;
+
+    for( unsigned i = 0; i < p_sys->i_track; i++ )
+    {
+        avi_track_t *tk = p_sys->track[i];
+
+        if( tk->idx.i_size > 0 && tk->idx.p_entry )
+            i_maxlength = __MAX( i_maxlength, AVI_TrackGetLength( tk ) );
+    }
+
+    return i_maxlength;
+}
+
 static mtime_t  AVI_MovieGetLength( demux_t *p_demux )
 {
     demux_sys_t  *p_sys = p_demux->p_sys;
@@ -3030,17 +3434,7 @@ static mtime_t  AVI_MovieGetLength( demux_t *p_demux )
             continue;
         }
 
-        if( tk->i_samplesize )
-        {
-            i_length = AVI_GetDPTS( tk,
-                                    tk->idx.p_entry[tk->idx.i_size-1].i_lengthtotal +
-                                        tk->idx.p_entry[tk->idx.i_size-1].i_length );
-        }
-        else
-        {
-            i_length = AVI_GetDPTS( tk, tk->idx.i_size );
-        }
-        i_length /= CLOCK_FREQ;    /* in seconds */
+        i_length = AVI_TrackGetLength( tk );
 
         msg_Dbg( p_demux,
                  "stream[%d] length:%"PRId64" (based on index)",
@@ -0,0 +1,89 @@
+/*****************************************************************************
+ * index_cache.h: index cache helper functions
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include <sys/stat.h>
+
+#include <vlc_fs.h>
+#include <vlc_md5.h>
+#include <vlc_url.h>
+
+/**
+ * Returns the path of an index cache file: the MD5 of the key, in the given
+ * sub-directory of the user cache directory.
+ *
+ * \param psz_subdir the sub-directory of the demuxer
+ * \param p_key the bytes identifying the indexed file
+ * \param i_key the number of bytes of the key
+ * \param b_create whether to create the directories
+ * \return the path to free(), or NULL on error
+ */
+static inline char *demux_IndexCachePath( const char *psz_subdir,
+                                          const void *p_key, size_t i_key,
+                                          bool b_create )
+{
+    char *psz_cachedir = config_GetUserDir( VLC_CACHE_DIR );
+    if( psz_cachedir == NULL )
+        return NULL;
+
+    char *psz_dir;
+    if( asprintf( &psz_dir, "%s" DIR_SEP "%s", psz_cachedir, psz_subdir ) == -1 )
+        psz_dir = NULL;
+    else if( b_create )
+    {
+        vlc_mkdir( psz_cachedir, 0700 );
+        vlc_mkdir( psz_dir, 0700 );
+    }
+    free( psz_cachedir );
+    if( psz_dir == NULL )
+        return NULL;
+
+    struct md5_s md5;
+    InitMD5( &md5 );
+    AddMD5( &md5, p_key, i_key );
+    EndMD5( &md5 );
+    char *psz_hash = psz_md5_hash( &md5 );
+
+    char *psz_path;
+    if( psz_hash == NULL ||
+        asprintf( &psz_path, "%s" DIR_SEP "%s.idx", psz_dir, psz_hash ) == -1 )
+        psz_path = NULL;
+    free( psz_hash );
+    free( psz_dir );
+    return psz_path;
+}
+
+/**
+ * Returns the modification time of a local file, stored with its index cache
+ * to detect a file rewritten in place.
+ *
+ * \param psz_url the URL of the indexed file
+ * \return the modification time, or 0 if the file is not local
+ */
+static inline int64_t demux_IndexCacheMTime( const char *psz_url )
+{
+    char *psz_path = psz_url != NULL ? vlc_uri2path( psz_url ) : NULL;
+    int64_t i_mtime = 0;
+    struct stat st;
+
+    if( psz_path != NULL && vlc_stat( psz_path, &st ) == 0 )
+        i_mtime = st.st_mtime;
+    free( psz_path );
+    return i_mtime;
+}
@@ -28,9 +28,14 @@
 #include "util.hpp"
 #include "Ebml_parser.hpp"
 #include "Ebml_dispatcher.hpp"
+#include "stream_io_callback.hpp"
 
 #include <new>
 
+#include <vlc_fs.h>
+
+#include "../index_cache.h"
+
 matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estream )
     :segment(NULL)
     ,es(estream)
@@ -50,6 +55,7 @@ matroska_segment_c::matroska_segment_c( demux_sys_t & demuxer, EbmlStream & estr
     ,p_prev_segment_uid(NULL)
     ,p_next_segment_uid(NULL)
     ,b_cues(false)
+    ,b_index_cached(false)
     ,psz_muxing_application(NULL)
     ,psz_writing_application(NULL)
     ,psz_segment_filename(NULL)
@@ -691,6 +697,9 @@ bool matroska_segment_c::Preload( )
 
     b_preloaded = true;
 
+    if( cluster && !b_cues )
+        IndexCacheLoad();
+
     if( cluster )
         EnsureDuration();
 
@@ -812,6 +821,10 @@ void matroska_segment_c::Seek( mtime_t i_absolute_mk_date, mtime_t i_mk_time_off
     mtime_t i_mk_seek_time   = -1;
     mtime_t i_mk_date = i_absolute_mk_date - i_mk_time_offset;
 
+    // pick up the clusters found in the background so far //
+
+    _seeker.merge_indexed_clusters();
+
     // reset information for all tracks //
 
     for( tracks_map_t::iterator it = tracks.begin(); it != tracks.end(); ++it )
@@ -1103,6 +1116,29 @@ bool matroska_segment_c::ESCreate()
         }
     }
 
+    /* without cues, find the clusters in the background so that seeking
+     * does not have to walk the segment */
+    if( !b_cues && cluster != NULL && !_seeker._clusters_complete )
+    {
+        stream_t *s = IndexStream();
+        bool b_fastseek = false;
+
+        if( s != NULL && s->psz_url != NULL &&
+            vlc_stream_Control( s, STREAM_CAN_FASTSEEK, &b_fastseek ) == VLC_SUCCESS &&
+            b_fastseek )
+        {
+            uint64_t i_end = segment->IsFiniteSize()
+                ? segment->GetEndPosition()
+                : stream_Size( s );
+
+            _seeker.start_indexer( &sys.demuxer, s->psz_url,
+                                   _seeker._cluster_positions.empty()
+                                       ? cluster->GetElementPosition()
+                                       : _seeker._cluster_positions.front(),
+                                   i_end, i_timescale );
+        }
+    }
+
     return true;
 }
 
@@ -1110,6 +1146,13 @@ void matroska_segment_c::ESDestroy( )
 {
     sys.p_ev->ResetPci();
 
+    _seeker.merge_indexed_clusters();
+    _seeker.stop_indexer();
+
+    /* a partial index would hide the clusters it misses */
+    if( !b_cues && !b_index_cached && _seeker._clusters_complete )
+        IndexCacheStore();
+
     for( tracks_map_t::iterator it = tracks.begin(); it != tracks.end(); ++it )
     {
         tracks_map_t::mapped_type& track = it->second;
@@ -1395,3 +1438,112 @@ int matroska_segment_c::BlockGet( KaxBlock * & pp_block, KaxSimpleBlock * & pp_s
         }
     }
 }
+
+/*****************************************************************************
+ * Index cache: the clusters found in segments without cues are stored in the
+ * user cache directory once they are all known, keyed by the segment UID (or
+ * by the stream URL and the segment position if it has none), and checked
+ * against the stream size and the file modification time.
+ *****************************************************************************/
+#define MKV_INDEX_CACHE_MAGIC   "VLCMKVIX"
+#define MKV_INDEX_CACHE_VERSION 2
+
+stream_t *matroska_segment_c::IndexStream() const
+{
+    return static_cast<vlc_stream_io_callback&>( es.I_O() ).stream();
+}
+
+char *matroska_segment_c::IndexCachePath( bool b_create ) const
+{
+    stream_t *s = IndexStream();
+
+    if( !var_InheritBool( &sys.demuxer, "mkv-index-cache" ) ||
+        s == NULL || segment == NULL )
+        return NULL;
+
+    if( p_segment_uid != NULL && p_segment_uid->GetSize() > 0 )
+        return demux_IndexCachePath( "mkv-index", p_segment_uid->GetBuffer(),
+                                     p_segment_uid->GetSize(), b_create );
+
+    if( s->psz_url == NULL )
+        return NULL;
+
+    uint8_t position[8];
+    SetQWLE( position, segment->GetElementPosition() );
+
+    std::string key( s->psz_url );
+    key.append( reinterpret_cast<char *>( position ), sizeof( position ) );
+    return demux_IndexCachePath( "mkv-index", key.data(), key.size(),
+                                 b_create );
+}
+
+bool matroska_segment_c::IndexCacheLoad()
+{
+    char *psz_path = IndexCachePath( false );
+    if( psz_path == NULL )
+        return false;
+
+    FILE *p_file = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( p_file == NULL )
+        return false;
+
+    /* the size and modification time tell a file rewritten in place,
+     * even by a tool keeping its segment UID */
+    stream_t *s = IndexStream();
+    uint8_t header[28];
+    bool b_ok = fread( header, sizeof( header ), 1, p_file ) == 1 &&
+                !memcmp( header, MKV_INDEX_CACHE_MAGIC, 8 ) &&
+                GetDWLE( &header[8] ) == MKV_INDEX_CACHE_VERSION &&
+                GetQWLE( &header[12] ) == (uint64_t)stream_Size( s ) &&
+                (int64_t)GetQWLE( &header[20] ) ==
+                    demux_IndexCacheMTime( s->psz_url );
+
+    if( b_ok )
+    {
+        b_ok = _seeker.load_index( p_file );
+
+        if( b_ok )
+            msg_Dbg( &sys.demuxer, "loaded %zu cached clusters",
+                     _seeker._clusters.size() );
+        else
+            msg_Warn( &sys.demuxer, "invalid index cache, discarding it" );
+    }
+
+    fclose( p_file );
+    b_index_cached = b_ok;
+    return b_ok;
+}
+
+void matroska_segment_c::IndexCacheStore()
+{
+    char *psz_path = IndexCachePath( true );
+    if( psz_path == NULL )
+        return;
+
+    FILE *p_file = vlc_fopen( psz_path, "wb" );
+    if( p_file == NULL )
+    {
+        msg_Warn( &sys.demuxer, "cannot write index cache %s", psz_path );
+        free( psz_path );
+        return;
+    }
+
+    stream_t *s = IndexStream();
+    uint8_t header[28];
+    memcpy( header, MKV_INDEX_CACHE_MAGIC, 8 );
+    SetDWLE( &header[8], MKV_INDEX_CACHE_VERSION );
+    SetQWLE( &header[12], stream_Size( s ) );
+    SetQWLE( &header[20], demux_IndexCacheMTime( s->psz_url ) );
+    bool b_error = fwrite( header, sizeof( header ), 1, p_file ) != 1 ||
+                   !_seeker.store_index( p_file );
+
+    if( fclose( p_file ) || b_error )
+    {
+        msg_Warn( &sys.demuxer, "cannot write index cache %s", psz_path );
+        vlc_unlink( psz_path );
+    }
+    else
+        msg_Dbg( &sys.demuxer, "index cached in %s", psz_path );
+    free( psz_path );
+}
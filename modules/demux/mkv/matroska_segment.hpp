@@ -110,6 +110,7 @@ public:
     KaxNextUID              *p_next_segment_uid;
 
     bool                    b_cues;
+    bool                    b_index_cached; /* index loaded from the cache */
 
     /* info */
     char                    *psz_muxing_application;
@@ -170,6 +171,11 @@ private:
     void ComputeTrackPriority();
     void EnsureDuration();
 
+    stream_t *IndexStream() const;
+    char *IndexCachePath( bool b_create ) const;
+    bool IndexCacheLoad();
+    void IndexCacheStore();
+
     SegmentSeeker _seeker;
 
     friend SegmentSeeker;
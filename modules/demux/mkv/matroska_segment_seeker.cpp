@@ -31,6 +31,7 @@
 
 #include <sstream>
 #include <limits>
+#include <new>
 
 namespace { 
     template<class It, class T>
@@ -47,6 +48,134 @@ namespace {
 
     template<class It> It prev_( It it ) { return --it; }
     template<class It> It next_( It it ) { return ++it; }
+
+    // The background indexer walks the segment on its own stream, without
+    // libebml, reading only the element headers and the cluster timecodes.
+
+    uint64_t const EBML_ID_CLUSTER          = 0x1F43B675;
+    uint64_t const EBML_ID_CLUSTER_TIMECODE = 0xE7;
+    uint64_t const EBML_SIZE_UNKNOWN        = UINT64_MAX;
+
+    bool ebml_is_cluster_child( uint64_t id )
+    {
+        switch( id )
+        {
+            case 0xE7:   // Timecode
+            case 0x5854: // SilentTracks
+            case 0xA7:   // Position
+            case 0xAB:   // PrevSize
+            case 0xA3:   // SimpleBlock
+            case 0xA0:   // BlockGroup
+            case 0xAF:   // EncryptedBlock
+            case 0xEC:   // Void
+            case 0xBF:   // CRC-32
+                return true;
+        }
+        return false;
+    }
+
+    bool ebml_read_vint( stream_t *s, bool b_id, uint64_t *pi_value )
+    {
+        uint8_t p_buf[8];
+
+        if( vlc_stream_Read( s, p_buf, 1 ) != 1 )
+            return false;
+
+        unsigned i_len = 1;
+        uint8_t  i_mask = 0x80;
+
+        while( i_len <= 8 && !( p_buf[0] & i_mask ) )
+        {
+            i_mask >>= 1;
+            i_len++;
+        }
+
+        if( i_len > ( b_id ? 4 : 8 ) )
+            return false;
+
+        if( i_len > 1 && vlc_stream_Read( s, p_buf + 1, i_len - 1 ) != ssize_t( i_len - 1 ) )
+            return false;
+
+        // IDs keep their length marker, sizes with all bits set are unknown
+        uint64_t i_value   = b_id ? p_buf[0] : p_buf[0] & ( i_mask - 1 );
+        bool     b_unknown = !b_id && i_value == uint64_t( i_mask - 1 );
+
+        for( unsigned i = 1; i < i_len; i++ )
+        {
+            i_value = ( i_value << 8 ) | p_buf[i];
+            b_unknown &= p_buf[i] == 0xFF;
+        }
+
+        *pi_value = b_unknown ? EBML_SIZE_UNKNOWN : i_value;
+        return true;
+    }
+
+    bool ebml_read_header( stream_t *s, uint64_t *pi_id, uint64_t *pi_size )
+    {
+        return ebml_read_vint( s, true, pi_id ) && ebml_read_vint( s, false, pi_size );
+    }
+
+    // index cache helpers, little-endian
+
+    bool write_u32( FILE *p_file, uint32_t i_value )
+    {
+        uint8_t p_buf[4];
+        SetDWLE( p_buf, i_value );
+        return fwrite( p_buf, sizeof( p_buf ), 1, p_file ) == 1;
+    }
+
+    bool write_u64( FILE *p_file, uint64_t i_value )
+    {
+        uint8_t p_buf[8];
+        SetQWLE( p_buf, i_value );
+        return fwrite( p_buf, sizeof( p_buf ), 1, p_file ) == 1;
+    }
+
+    bool read_u32( FILE *p_file, uint32_t *pi_value )
+    {
+        uint8_t p_buf[4];
+        if( fread( p_buf, sizeof( p_buf ), 1, p_file ) != 1 )
+            return false;
+        *pi_value = GetDWLE( p_buf );
+        return true;
+    }
+
+    bool read_u64( FILE *p_file, uint64_t *pi_value )
+    {
+        uint8_t p_buf[8];
+        if( fread( p_buf, sizeof( p_buf ), 1, p_file ) != 1 )
+            return false;
+        *pi_value = GetQWLE( p_buf );
+        return true;
+    }
+}
+
+struct SegmentSeeker::Indexer
+{
+    demux_t      *p_demux;
+    stream_t     *s;
+    vlc_thread_t  thread;
+    vlc_mutex_t   lock;
+
+    fptr_t        start;
+    fptr_t        end;
+    uint64_t      i_timescale;
+
+    /* protected by lock */
+    bool          b_abort;
+    bool          b_done;
+    bool          b_complete;
+    std::vector<Cluster> clusters; /* found, not merged yet */
+};
+
+SegmentSeeker::SegmentSeeker()
+    : _clusters_complete( false )
+    , _indexer( NULL )
+{ }
+
+SegmentSeeker::~SegmentSeeker()
+{
+    stop_indexer();
 }
 
 SegmentSeeker::cluster_positions_t::iterator
@@ -58,19 +187,32 @@ SegmentSeeker::add_cluster_position( fptr_t fpos )
       fpos
     );
 
+    if( insertion_point != _cluster_positions.begin() && *prev_( insertion_point ) == fpos )
+        return prev_( insertion_point ); // already known
+
     return _cluster_positions.insert( insertion_point, fpos );
 }
 
 SegmentSeeker::cluster_map_t::iterator
 SegmentSeeker::add_cluster( KaxCluster * const p_cluster )
+{
+    return add_cluster(
+      p_cluster->GetElementPosition(),
+      mtime_t( p_cluster->GlobalTimecode() / INT64_C( 1000 ) ),
+      p_cluster->IsFiniteSize()
+        ? p_cluster->GetEndPosition() - p_cluster->GetElementPosition()
+        : UINT64_MAX
+    );
+}
+
+SegmentSeeker::cluster_map_t::iterator
+SegmentSeeker::add_cluster( fptr_t fpos, mtime_t pts, fptr_t size )
 {
     Cluster cinfo = {
-        /* fpos     */ p_cluster->GetElementPosition(),
-        /* pts      */ mtime_t( p_cluster->GlobalTimecode() / INT64_C( 1000 ) ),
+        /* fpos     */ fpos,
+        /* pts      */ pts,
         /* duration */ mtime_t( -1 ),
-        /* size     */ p_cluster->IsFiniteSize()
-            ? p_cluster->GetEndPosition() - p_cluster->GetElementPosition()
-            : UINT64_MAX
+        /* size     */ size
     };
 
     add_cluster_position( cinfo.fpos );
@@ -464,3 +606,344 @@ SegmentSeeker::mkv_jump_to( matroska_segment_c& ms, fptr_t fpos )
     ms.es.I_O().setFilePointer( fpos );
 }
 
+
+bool
+SegmentSeeker::start_indexer( demux_t *p_demux, char const *psz_url, fptr_t start, fptr_t end, uint64_t i_timescale )
+{
+    if( _indexer || _clusters_complete || psz_url == NULL || start >= end )
+        return false;
+
+    Indexer *idx = new (std::nothrow) Indexer;
+    if( unlikely( idx == NULL ) )
+        return false;
+
+    idx->s = vlc_stream_NewURL( p_demux, psz_url );
+    if( idx->s == NULL )
+    {
+        delete idx;
+        return false;
+    }
+
+    idx->p_demux     = p_demux;
+    idx->start       = start;
+    idx->end         = end;
+    idx->i_timescale = i_timescale;
+    idx->b_abort     = false;
+    idx->b_done      = false;
+    idx->b_complete  = false;
+    vlc_mutex_init( &idx->lock );
+
+    if( vlc_clone( &idx->thread, IndexerThread, idx, VLC_THREAD_PRIORITY_LOW ) )
+    {
+        vlc_mutex_destroy( &idx->lock );
+        vlc_stream_Delete( idx->s );
+        delete idx;
+        return false;
+    }
+
+    msg_Dbg( p_demux, "indexing clusters from %" PRIu64 " to %" PRIu64 " in the background", start, end );
+
+    _indexer = idx;
+    return true;
+}
+
+void
+SegmentSeeker::stop_indexer()
+{
+    if( _indexer == NULL )
+        return;
+
+    vlc_mutex_lock( &_indexer->lock );
+    _indexer->b_abort = true;
+    vlc_mutex_unlock( &_indexer->lock );
+
+    vlc_join( _indexer->thread, NULL );
+    vlc_stream_Delete( _indexer->s );
+    vlc_mutex_destroy( &_indexer->lock );
+
+    delete _indexer;
+    _indexer = NULL;
+}
+
+void
+SegmentSeeker::merge_indexed_clusters()
+{
+    if( _indexer == NULL )
+        return;
+
+    std::vector<Cluster> clusters;
+    bool b_done, b_complete;
+
+    vlc_mutex_lock( &_indexer->lock );
+    clusters.swap( _indexer->clusters );
+    b_done     = _indexer->b_done;
+    b_complete = _indexer->b_complete;
+    vlc_mutex_unlock( &_indexer->lock );
+
+    for( std::vector<Cluster>::const_iterator it = clusters.begin(); it != clusters.end(); ++it )
+        add_cluster( it->fpos, it->pts, it->size );
+
+    if( b_done )
+    {
+        msg_Dbg( _indexer->p_demux, "background indexing %s, %zu clusters known",
+                 b_complete ? "complete" : "interrupted", _clusters.size() );
+
+        stop_indexer();
+        _clusters_complete = b_complete;
+    }
+}
+
+void *
+SegmentSeeker::IndexerThread( void *data )
+{
+    Indexer  *idx = static_cast<Indexer *>( data );
+    stream_t *s   = idx->s;
+    fptr_t    pos = idx->start;
+    bool      b_complete = false;
+
+    for( ;; )
+    {
+        vlc_mutex_lock( &idx->lock );
+        bool b_abort = idx->b_abort;
+        vlc_mutex_unlock( &idx->lock );
+
+        if( b_abort )
+            break;
+
+        if( pos >= idx->end )
+        {
+            b_complete = true;
+            break;
+        }
+
+        uint64_t id, size;
+
+        if( vlc_stream_Seek( s, pos ) || !ebml_read_header( s, &id, &size ) )
+            break;
+
+        fptr_t const data_pos = vlc_stream_Tell( s );
+
+        if( id != EBML_ID_CLUSTER )
+        {
+            if( size == EBML_SIZE_UNKNOWN )
+                break;
+
+            pos = data_pos + size;
+            continue;
+        }
+
+        // read the children up to the timecode, or up to the end of the
+        // cluster if its size is unknown
+
+        fptr_t  next = size != EBML_SIZE_UNKNOWN ? data_pos + size : idx->end;
+        fptr_t  child_pos = data_pos;
+        mtime_t pts = -1;
+        bool    b_error = false;
+
+        while( child_pos < next && ( pts < 0 || size == EBML_SIZE_UNKNOWN ) )
+        {
+            uint64_t child_id, child_size;
+
+            if( vlc_stream_Seek( s, child_pos ) || !ebml_read_header( s, &child_id, &child_size ) )
+            {
+                b_error = true;
+                break;
+            }
+
+            if( size == EBML_SIZE_UNKNOWN && !ebml_is_cluster_child( child_id ) )
+            {
+                next = child_pos;
+                break;
+            }
+
+            if( child_size == EBML_SIZE_UNKNOWN )
+            {
+                b_error = true;
+                break;
+            }
+
+            fptr_t const child_data_pos = vlc_stream_Tell( s );
+
+            if( child_id == EBML_ID_CLUSTER_TIMECODE && child_size <= 8 )
+            {
+                uint8_t p_buf[8];
+
+                if( vlc_stream_Read( s, p_buf, child_size ) != ssize_t( child_size ) )
+                {
+                    b_error = true;
+                    break;
+                }
+
+                uint64_t i_timecode = 0;
+                for( unsigned i = 0; i < child_size; i++ )
+                    i_timecode = ( i_timecode << 8 ) | p_buf[i];
+
+                pts = mtime_t( i_timecode * idx->i_timescale / 1000 );
+            }
+
+            child_pos = child_data_pos + child_size;
+        }
+
+        if( b_error )
+            break;
+
+        if( pts >= 0 )
+        {
+            Cluster const cinfo = { pos, pts, mtime_t( -1 ), next - pos };
+
+            vlc_mutex_lock( &idx->lock );
+            idx->clusters.push_back( cinfo );
+            vlc_mutex_unlock( &idx->lock );
+        }
+
+        pos = next;
+    }
+
+    vlc_mutex_lock( &idx->lock );
+    idx->b_done     = true;
+    idx->b_complete = b_complete;
+    vlc_mutex_unlock( &idx->lock );
+
+    return NULL;
+}
+
+bool
+SegmentSeeker::store_index( FILE *p_file ) const
+{
+    bool b_ok = write_u32( p_file, _clusters_complete ) &&
+                write_u32( p_file, _clusters.size() );
+
+    for( cluster_map_t::const_iterator it = _clusters.begin(); b_ok && it != _clusters.end(); ++it )
+    {
+        b_ok = write_u64( p_file, it->second.fpos ) &&
+               write_u64( p_file, it->second.pts ) &&
+               write_u64( p_file, it->second.duration ) &&
+               write_u64( p_file, it->second.size );
+    }
+
+    b_ok = b_ok && write_u32( p_file, _cluster_positions.size() );
+
+    for( cluster_positions_t::const_iterator it = _cluster_positions.begin(); b_ok && it != _cluster_positions.end(); ++it )
+        b_ok = write_u64( p_file, *it );
+
+    b_ok = b_ok && write_u32( p_file, _ranges_searched.size() );
+
+    for( ranges_t::const_iterator it = _ranges_searched.begin(); b_ok && it != _ranges_searched.end(); ++it )
+        b_ok = write_u64( p_file, it->start ) && write_u64( p_file, it->end );
+
+    b_ok = b_ok && write_u32( p_file, _tracks_seekpoints.size() );
+
+    for( tracks_seekpoints_t::const_iterator it = _tracks_seekpoints.begin(); b_ok && it != _tracks_seekpoints.end(); ++it )
+    {
+        b_ok = write_u32( p_file, it->first ) &&
+               write_u32( p_file, it->second.size() );
+
+        for( seekpoints_t::const_iterator sp = it->second.begin(); b_ok && sp != it->second.end(); ++sp )
+        {
+            b_ok = write_u64( p_file, sp->fpos ) &&
+                   write_u64( p_file, sp->pts ) &&
+                   write_u32( p_file, sp->trust_level );
+        }
+    }
+
+    return b_ok;
+}
+
+bool
+SegmentSeeker::load_index( FILE *p_file )
+{
+    uint32_t i_complete, i_count;
+
+    // read everything first, so that a broken cache changes nothing
+
+    cluster_map_t       clusters;
+    cluster_positions_t cluster_positions;
+    ranges_t            ranges;
+    tracks_seekpoints_t tracks_seekpoints;
+
+    if( !read_u32( p_file, &i_complete ) || !read_u32( p_file, &i_count ) )
+        return false;
+
+    for( ; i_count > 0; i_count-- )
+    {
+        uint64_t fpos, pts, duration, size;
+
+        if( !read_u64( p_file, &fpos ) || !read_u64( p_file, &pts ) ||
+            !read_u64( p_file, &duration ) || !read_u64( p_file, &size ) )
+            return false;
+
+        Cluster const cinfo = { fpos, mtime_t( pts ), mtime_t( duration ), size };
+        clusters.insert( cluster_map_t::value_type( cinfo.pts, cinfo ) );
+    }
+
+    if( !read_u32( p_file, &i_count ) )
+        return false;
+
+    for( ; i_count > 0; i_count-- )
+    {
+        uint64_t fpos;
+
+        if( !read_u64( p_file, &fpos ) )
+            return false;
+
+        cluster_positions.push_back( fpos );
+    }
+
+    if( !read_u32( p_file, &i_count ) )
+        return false;
+
+    for( ; i_count > 0; i_count-- )
+    {
+        uint64_t start, end;
+
+        if( !read_u64( p_file, &start ) || !read_u64( p_file, &end ) )
+            return false;
+
+        ranges.push_back( Range( start, end ) );
+    }
+
+    if( !read_u32( p_file, &i_count ) )
+        return false;
+
+    for( ; i_count > 0; i_count-- )
+    {
+        uint32_t track_id, i_points;
+
+        if( !read_u32( p_file, &track_id ) || !read_u32( p_file, &i_points ) )
+            return false;
+
+        seekpoints_t& seekpoints = tracks_seekpoints[ track_id ];
+
+        for( ; i_points > 0; i_points-- )
+        {
+            uint64_t fpos, pts;
+            uint32_t trust_level;
+
+            if( !read_u64( p_file, &fpos ) || !read_u64( p_file, &pts ) ||
+                !read_u32( p_file, &trust_level ) )
+                return false;
+
+            seekpoints.push_back( Seekpoint( int32_t( trust_level ), fpos, mtime_t( pts ) ) );
+        }
+    }
+
+    // merge with what was already found while opening
+
+    for( cluster_map_t::const_iterator it = clusters.begin(); it != clusters.end(); ++it )
+        add_cluster( it->second.fpos, it->second.pts, it->second.size );
+
+    for( cluster_positions_t::const_iterator it = cluster_positions.begin(); it != cluster_positions.end(); ++it )
+        add_cluster_position( *it );
+
+    for( ranges_t::const_iterator it = ranges.begin(); it != ranges.end(); ++it )
+        mark_range_as_searched( *it );
+
+    for( tracks_seekpoints_t::const_iterator it = tracks_seekpoints.begin(); it != tracks_seekpoints.end(); ++it )
+    {
+        for( seekpoints_t::const_iterator sp = it->second.begin(); sp != it->second.end(); ++sp )
+            add_seekpoint( it->first, sp->trust_level, sp->fpos, sp->pts );
+    }
+
+    _clusters_complete = i_complete != 0;
+    return true;
+}
@@ -30,6 +30,7 @@
 #include <vector>
 #include <map>
 #include <limits>
+#include <cstdio>
 
 class matroska_segment_c;
 
@@ -86,6 +87,9 @@ class SegmentSeeker
         };
 
     public:
+        SegmentSeeker();
+        ~SegmentSeeker();
+
         typedef std::vector<track_id_t> track_ids_t;
         typedef std::vector<Range> ranges_t;
         typedef std::vector<Seekpoint> seekpoints_t;
@@ -107,6 +111,14 @@ class SegmentSeeker
 
         cluster_positions_t::iterator add_cluster_position( fptr_t pos );
         cluster_map_t      ::iterator add_cluster( KaxCluster * const );
+        cluster_map_t      ::iterator add_cluster( fptr_t fpos, mtime_t pts, fptr_t size );
+
+        bool start_indexer( demux_t *, char const * psz_url, fptr_t start, fptr_t end, uint64_t i_timescale );
+        void stop_indexer();
+        void merge_indexed_clusters();
+
+        bool load_index( FILE * );
+        bool store_index( FILE * ) const;
 
         void mkv_jump_to( matroska_segment_c&, fptr_t );
 
@@ -121,6 +133,18 @@ class SegmentSeeker
         tracks_seekpoints_t _tracks_seekpoints;
         cluster_positions_t _cluster_positions;
         cluster_map_t       _clusters;
+        bool                _clusters_complete; /* all the clusters are known */
+
+    private:
+        /* walks the clusters of the segment on a private stream */
+        struct Indexer;
+        Indexer            *_indexer;
+
+        /* the indexer is owned, not copyable */
+        SegmentSeeker( SegmentSeeker const& );
+        SegmentSeeker& operator=( SegmentSeeker const& );
+
+        static void *IndexerThread( void * );
 };
 
 #endif /* include-guard */
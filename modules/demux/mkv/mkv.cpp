@@ -76,6 +76,10 @@ vlc_module_begin ()
             N_("Preload clusters"),
             N_("Find all cluster positions by jumping cluster-to-cluster before playback"), true );
 
+    add_bool( "mkv-index-cache", false,
+            N_("Cache cluster index"),
+            N_("Store the cluster positions found in segments without cues in the user cache directory, and reuse them when the same file is opened again."), true );
+
     add_shortcut( "mka", "mkv" )
 vlc_module_end ()
 
@@ -137,6 +137,7 @@ static uint64_t MP4_TrackGetPos    ( mp4_track_t * );
 static uint32_t MP4_TrackGetReadSize( mp4_track_t *, uint32_t * );
 static int      MP4_TrackNextSample( demux_t *, mp4_track_t *, uint32_t );
 static void     MP4_TrackSetELST( demux_t *, mp4_track_t *, int64_t );
+static int      TrackChunkLoadTables( demux_t *, mp4_track_t *, uint32_t );
 
 static void     MP4_UpdateSeekpoint( demux_t *, int64_t );
 
@@ -277,6 +278,10 @@ static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
     demux_sys_t *p_sys = p_demux->p_sys;
     const mp4_chunk_t *p_chunk = &p_track->chunk[p_track->i_chunk];
 
+    /* falls back to the chunk first dts on failure */
+    if( TrackChunkLoadTables( p_demux, p_track, p_track->i_chunk ) )
+        return MP4_rescale( p_chunk->i_first_dts, p_track->i_timescale, CLOCK_FREQ );
+
     unsigned int i_index = 0;
     unsigned int i_sample = p_track->i_sample - p_chunk->i_sample_first;
     int64_t i_dts = p_chunk->i_first_dts;
@@ -322,13 +327,13 @@ static inline int64_t MP4_TrackGetDTS( demux_t *p_demux, mp4_track_t *p_track )
 static inline bool MP4_TrackGetPTSDelta( demux_t *p_demux, mp4_track_t *p_track,
                                          int64_t *pi_delta )
 {
-    VLC_UNUSED( p_demux );
     mp4_chunk_t *ck = &p_track->chunk[p_track->i_chunk];
 
     unsigned int i_index = 0;
     unsigned int i_sample = p_track->i_sample - ck->i_sample_first;
 
-    if( ck->p_sample_count_pts == NULL || ck->p_sample_offset_pts == NULL )
+    if( ck->i_entries_pts == 0 ||
+        TrackChunkLoadTables( p_demux, p_track, p_track->i_chunk ) )
         return false;
 
     for( i_index = 0; i_index < ck->i_entries_pts ; i_index++ )
@@ -2203,52 +2208,147 @@ static int TrackCreateChunksIndex( demux_t *p_demux,
     return VLC_SUCCESS;
 }
 
-static int xTTS_CountEntries( demux_t *p_demux, uint32_t *pi_entry /* out */,
-                              const uint32_t i_index,
-                              uint32_t i_index_samples_left,
-                              uint32_t i_sample_count,
-                              const uint32_t *pi_index_sample_count,
-                              const uint32_t i_table_count )
+/* Walks the stts/ctts runs covering i_sample_count samples, starting at entry
+ * *pi_index with *pi_left samples remaining in it (0 when the entry is
+ * untouched), and advances the cursor past them.
+ * When pi_count/pi_value are given, the per chunk runs are stored there. */
+static int xTTS_WalkChunk( uint32_t *pi_index, uint32_t *pi_left,
+                           uint32_t i_sample_count,
+                           const uint32_t *pi_table_count,
+                           const int32_t *pi_table_value,
+                           const uint32_t i_table_count,
+                           uint32_t *pi_entries /* out */,
+                           uint32_t *pi_count, int32_t *pi_value,
+                           uint64_t *pi_duration )
 {
-    uint32_t i_array_offset;
+    uint32_t i_index = *pi_index;
+    uint32_t i_left = *pi_left;
+    uint32_t i_entries = 0;
+    uint64_t i_duration = 0;
+    int i_ret = VLC_SUCCESS;
+
     while( i_sample_count > 0 )
     {
-        if ( likely((UINT32_MAX - i_index) >= *pi_entry) )
-            i_array_offset = i_index + *pi_entry;
-        else
-            return VLC_EGENERIC;
+        if( i_index >= i_table_count )
+        {
+            i_ret = VLC_ENOVAR;
+            break;
+        }
+
+        const uint32_t i_run = i_left ? i_left : pi_table_count[i_index];
+        const uint32_t i_used = __MIN( i_run, i_sample_count );
 
-        if ( i_array_offset >= i_table_count )
+        if( pi_count )
         {
-            msg_Err( p_demux, "invalid index counting total samples %u %u", i_array_offset,  i_table_count );
-            return VLC_ENOVAR;
+            pi_count[i_entries] = i_used;
+            pi_value[i_entries] = pi_table_value[i_index];
         }
+        i_duration += (uint64_t) i_used * (uint32_t) pi_table_value[i_index];
+        i_entries++;
 
-        if ( i_index_samples_left )
+        i_sample_count -= i_used;
+        if( i_used < i_run )
         {
-            if ( i_index_samples_left > i_sample_count )
-            {
-                i_index_samples_left -= i_sample_count;
-                i_sample_count = 0;
-                *pi_entry +=1; /* No samples left, go copy */
-                break;
-            }
-            else
-            {
-                i_sample_count -= i_index_samples_left;
-                i_index_samples_left = 0;
-                *pi_entry += 1;
-                continue;
-            }
+            i_left = i_run - i_used; /* keep building from same index */
         }
         else
         {
-            i_sample_count -= __MIN( i_sample_count, pi_index_sample_count[i_array_offset] );
-            *pi_entry += 1;
+            i_left = 0;
+            i_index++;
         }
     }
 
+    *pi_index = i_index;
+    *pi_left = i_left;
+    *pi_entries = i_entries;
+    if( pi_duration )
+        *pi_duration = i_duration;
+
+    return i_ret;
+}
+
+static void TrackChunkUnloadTables( mp4_chunk_t *ck )
+{
+    FREENULL( ck->p_sample_count_dts );
+    FREENULL( ck->p_sample_delta_dts );
+    FREENULL( ck->p_sample_count_pts );
+    FREENULL( ck->p_sample_offset_pts );
+}
+
+/* Expands the dts/pts runs of a chunk from the stts/ctts tables.
+ * Only MP4_CHUNK_TABLES_WINDOW chunks per track keep their runs expanded,
+ * the least recently loaded one being released first. */
+static int TrackChunkLoadTables( demux_t *p_demux, mp4_track_t *p_track,
+                                 uint32_t i_chunk )
+{
+    if( i_chunk >= p_track->i_chunk_count )
+        return VLC_EGENERIC;
+
+    mp4_chunk_t *ck = &p_track->chunk[i_chunk];
+
+    if( ( ck->i_entries_dts == 0 || ck->p_sample_count_dts ) &&
+        ( ck->i_entries_pts == 0 || ck->p_sample_count_pts ) )
+        return VLC_SUCCESS;
+
+    if( p_track->tables.i_count == MP4_CHUNK_TABLES_WINDOW )
+    {
+        uint32_t i_oldest = p_track->tables.chunks[p_track->tables.i_next];
+        TrackChunkUnloadTables( &p_track->chunk[i_oldest] );
+        p_track->tables.i_count--;
+    }
+
+    TrackChunkUnloadTables( ck );
+
+    if( ck->i_entries_dts )
+    {
+        const MP4_Box_t *p_stts = MP4_BoxGet( p_track->p_stbl, "stts" );
+        if( !p_stts || !BOXDATA(p_stts) )
+            return VLC_EGENERIC;
+
+        ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
+        ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
+        if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
+            goto error;
+
+        uint32_t i_index = ck->i_stts_index, i_left = ck->i_stts_left;
+        xTTS_WalkChunk( &i_index, &i_left, ck->i_sample_count,
+                        BOXDATA(p_stts)->pi_sample_count,
+                        BOXDATA(p_stts)->pi_sample_delta,
+                        BOXDATA(p_stts)->i_entry_count,
+                        &ck->i_entries_dts, ck->p_sample_count_dts,
+                        (int32_t *) ck->p_sample_delta_dts, NULL );
+    }
+
+    if( ck->i_entries_pts )
+    {
+        const MP4_Box_t *p_ctts = MP4_BoxGet( p_track->p_stbl, "ctts" );
+        if( !p_ctts || !BOXDATA(p_ctts) )
+            goto error;
+
+        ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
+        ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
+        if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
+            goto error;
+
+        uint32_t i_index = ck->i_ctts_index, i_left = ck->i_ctts_left;
+        xTTS_WalkChunk( &i_index, &i_left, ck->i_sample_count,
+                        BOXDATA(p_ctts)->pi_sample_count,
+                        BOXDATA(p_ctts)->pi_sample_offset,
+                        BOXDATA(p_ctts)->i_entry_count,
+                        &ck->i_entries_pts, ck->p_sample_count_pts,
+                        ck->p_sample_offset_pts, NULL );
+    }
+
+    p_track->tables.chunks[p_track->tables.i_next] = i_chunk;
+    p_track->tables.i_next = (p_track->tables.i_next + 1) % MP4_CHUNK_TABLES_WINDOW;
+    p_track->tables.i_count++;
+
     return VLC_SUCCESS;
+
+error:
+    msg_Err( p_demux, "can't expand sample tables for chunk %"PRIu32, i_chunk );
+    TrackChunkUnloadTables( ck );
+    return VLC_ENOMEM;
 }
 
 static int TrackCreateSamplesIndex( demux_t *p_demux,
@@ -2290,18 +2390,10 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
     }
     else
     {
-        /* 2: each sample can have a different size */
+        /* 2: each sample can have a different size, use the stsz table
+         * directly as it lives as long as the moov box */
         p_demux_track->i_sample_size = 0;
-        p_demux_track->p_sample_size =
-            calloc( p_demux_track->i_sample_count, sizeof( uint32_t ) );
-        if( p_demux_track->p_sample_size == NULL )
-            return VLC_ENOMEM;
-
-        for( uint32_t i_sample = 0; i_sample < p_demux_track->i_sample_count; i_sample++ )
-        {
-            p_demux_track->p_sample_size[i_sample] =
-                    stsz->i_entry_size[i_sample];
-        }
+        p_demux_track->p_sample_size = stsz->i_entry_size;
     }
 
     if ( p_demux_track->i_chunk_count )
@@ -2334,12 +2426,10 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
     /* Use stts table to create a sample number -> dts table.
      * XXX: if we don't want to waste too much memory, we can't expand
-     *  the box! so each chunk will contain an "extract" of this table
-     *  for fast research (problem with raw stream where a sample is sometime
-     *  just channels*bits_per_sample/8 */
-
-     /* FIXME: refactor STTS & CTTS, STTS having now only few extra lines and
-      *        differing in 2/2 fields and 1 signedness */
+     *  the box! so each chunk only records where its runs start in the
+     *  stts/ctts tables, and TrackChunkLoadTables() extracts them on
+     *  demand around the read position (problem with raw stream where
+     *  a sample is sometime just channels*bits_per_sample/8 */
 
     mtime_t i_next_dts = 0;
     /* Find stts
@@ -2357,96 +2447,29 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "STTS table of %"PRIu32" entries", stts->i_entry_count );
 
-        /* Create sample -> dts table per chunk */
+        /* Record sample -> dts runs position per chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
 
             /* save first dts */
             ck->i_first_dts = i_next_dts;
+            ck->i_stts_index = i_index;
+            ck->i_stts_left = i_current_index_samples_left;
 
-            /* count how many entries are needed for this chunk
-             * for p_sample_delta_dts and p_sample_count_dts */
-            ck->i_entries_dts = 0;
-
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_dts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           stts->pi_sample_count,
-                                           stts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            ck->p_sample_delta_dts = calloc( ck->i_entries_dts, sizeof( uint32_t ) );
-            if( !ck->p_sample_count_dts || !ck->p_sample_delta_dts )
-            {
-                free( ck->p_sample_count_dts );
-                free( ck->p_sample_delta_dts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_dts );
-                ck->i_entries_dts = 0;
-                return VLC_ENOMEM;
-            }
-
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
-
-            for( uint32_t i = 0; i < ck->i_entries_dts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = i_current_index_samples_left;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_current_index_samples_left ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( stts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_dts[i] = i_sample_count;
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( i_sample_count ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_current_index_samples_left = stts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_dts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_dts[i] = stts->pi_sample_count[i_index];
-                        ck->p_sample_delta_dts[i] = stts->pi_sample_delta[i_index];
-                        i_next_dts += ck->p_sample_count_dts[i] * stts->pi_sample_delta[i_index];
-                        if ( stts->pi_sample_count[i_index] ) ck->i_duration = i_next_dts - ck->i_first_dts;
-                        i_sample_count -= stts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
+            if( xTTS_WalkChunk( &i_index, &i_current_index_samples_left,
+                                ck->i_sample_count,
+                                stts->pi_sample_count, stts->pi_sample_delta,
+                                stts->i_entry_count, &ck->i_entries_dts,
+                                NULL, NULL, &ck->i_duration ) != VLC_SUCCESS &&
+                ck->i_stts_index < stts->i_entry_count )
+                msg_Err( p_demux, "invalid index counting total samples %u %u",
+                         i_index, stts->i_entry_count );
 
-            }
+            i_next_dts += ck->i_duration;
         }
     }
 
@@ -2461,88 +2484,27 @@ static int TrackCreateSamplesIndex( demux_t *p_demux,
 
         msg_Warn( p_demux, "CTTS table of %"PRIu32" entries", ctts->i_entry_count );
 
-        /* Create pts-dts table per chunk */
+        /* Record pts-dts runs position per chunk */
         uint32_t i_index = 0;
         uint32_t i_current_index_samples_left = 0;
 
         for( uint32_t i_chunk = 0; i_chunk < p_demux_track->i_chunk_count; i_chunk++ )
         {
             mp4_chunk_t *ck = &p_demux_track->chunk[i_chunk];
-            uint32_t i_sample_count;
-
-            /* count how many entries are needed for this chunk
-             * for p_sample_offset_pts and p_sample_count_pts */
-            ck->i_entries_pts = 0;
-            int i_ret = xTTS_CountEntries( p_demux, &ck->i_entries_pts, i_index,
-                                           i_current_index_samples_left,
-                                           ck->i_sample_count,
-                                           ctts->pi_sample_count,
-                                           ctts->i_entry_count );
-            if ( i_ret == VLC_EGENERIC )
-                return i_ret;
-
-            /* allocate them */
-            ck->p_sample_count_pts = calloc( ck->i_entries_pts, sizeof( uint32_t ) );
-            ck->p_sample_offset_pts = calloc( ck->i_entries_pts, sizeof( int32_t ) );
-            if( !ck->p_sample_count_pts || !ck->p_sample_offset_pts )
-            {
-                free( ck->p_sample_count_pts );
-                free( ck->p_sample_offset_pts );
-                msg_Err( p_demux, "can't allocate memory for i_entry=%"PRIu32, ck->i_entries_pts );
-                ck->i_entries_pts = 0;
-                return VLC_ENOMEM;
-            }
 
-            /* now copy */
-            i_sample_count = ck->i_sample_count;
+            ck->i_ctts_index = i_index;
+            ck->i_ctts_left = i_current_index_samples_left;
 
-            for( uint32_t i = 0; i < ck->i_entries_pts; i++ )
-            {
-                if ( i_current_index_samples_left )
-                {
-                    if ( i_current_index_samples_left > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left -= i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        break;
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = i_current_index_samples_left;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= i_current_index_samples_left;
-                        i_current_index_samples_left = 0;
-                        i_index++;
-                    }
-                }
-                else
-                {
-                    if ( ctts->pi_sample_count[i_index] > i_sample_count )
-                    {
-                        ck->p_sample_count_pts[i] = i_sample_count;
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_current_index_samples_left = ctts->pi_sample_count[i_index] - i_sample_count;
-                        i_sample_count = 0;
-                        assert( i == ck->i_entries_pts - 1 );
-                        // keep building from same index
-                    }
-                    else
-                    {
-                        ck->p_sample_count_pts[i] = ctts->pi_sample_count[i_index];
-                        ck->p_sample_offset_pts[i] = ctts->pi_sample_offset[i_index];
-                        i_sample_count -= ctts->pi_sample_count[i_index];
-                        i_index++;
-                    }
-                }
-
-
-            }
+            if( xTTS_WalkChunk( &i_index, &i_current_index_samples_left,
+                                ck->i_sample_count,
+                                ctts->pi_sample_count, ctts->pi_sample_offset,
+                                ctts->i_entry_count, &ck->i_entries_pts,
+                                NULL, NULL, NULL ) != VLC_SUCCESS &&
+                ck->i_ctts_index < ctts->i_entry_count )
+                msg_Err( p_demux, "invalid index counting total samples %u %u",
+                         i_index, ctts->i_entry_count );
         }
     }
-
     msg_Dbg( p_demux, "track[Id 0x%x] read %"PRIu32" samples length:%"PRId64"s",
              p_demux_track->i_track_ID, p_demux_track->i_sample_count,
              i_next_dts / p_demux_track->i_timescale );
@@ -2834,6 +2796,9 @@ static int TrackTimeToSampleChunk( demux_t *p_demux, mp4_track_t *p_track,
         }
     }
 
+    if( TrackChunkLoadTables( p_demux, p_track, i_chunk ) )
+        return VLC_ENOMEM;
+
     /* *** find sample in the chunk *** */
     i_sample = p_track->chunk[i_chunk].i_sample_first;
     i_dts    = p_track->chunk[i_chunk].i_first_dts;
@@ -3289,10 +3254,7 @@ static void MP4_TrackCreate( demux_t *p_demux, mp4_track_t *p_track,
 
 static void DestroyChunk( mp4_chunk_t *ck )
 {
-    free( ck->p_sample_count_dts );
-    free( ck->p_sample_delta_dts );
-    free( ck->p_sample_count_pts );
-    free( ck->p_sample_offset_pts );
+    TrackChunkUnloadTables( ck );
     free( ck->p_sample_size );
 }
 
@@ -3315,9 +3277,6 @@ static void MP4_TrackDestroy( demux_t *p_demux, mp4_track_t *p_track )
     }
     free( p_track->chunk );
 
-    if( !p_track->i_sample_size )
-        free( p_track->p_sample_size );
-
     if ( p_track->asfinfo.p_frame )
         block_ChainRelease( p_track->asfinfo.p_frame );
 }
@@ -4265,12 +4224,18 @@ static int LeafMOOVGetSamplesSize( const mp4_track_t *p_track, const uint32_t i_
     return VLC_SUCCESS;
 }
 
-static inline mtime_t LeafGetMOOVTimeInChunk( const mp4_chunk_t *p_chunk, uint32_t i_sample )
+static int LeafGetMOOVTimeInChunk( demux_t *p_demux, mp4_track_t *p_track,
+                                   uint32_t i_chunk, uint32_t i_sample,
+                                   mtime_t *pi_time )
 {
+    const mp4_chunk_t *p_chunk = &p_track->chunk[i_chunk];
     mtime_t i_time = 0;
     uint32_t i_index = 0;
 
-    while( i_sample > 0 )
+    if( TrackChunkLoadTables( p_demux, p_track, i_chunk ) )
+        return VLC_EGENERIC;
+
+    while( i_sample > 0 && i_index < p_chunk->i_entries_dts )
     {
         if( i_sample > p_chunk->p_sample_count_dts[i_index] )
         {
@@ -4286,7 +4251,8 @@ static inline mtime_t LeafGetMOOVTimeInChunk( const mp4_chunk_t *p_chunk, uint32
         }
     }
 
-    return i_time;
+    *pi_time = i_time;
+    return VLC_SUCCESS;
 }
 
 static int LeafParseMDATwithMOOV( demux_t *p_demux )
@@ -4379,7 +4345,13 @@ static int LeafParseMDATwithMOOV( demux_t *p_demux )
                 p_sys->context.i_mdatbytesleft -= i_samplessize;
 
                 /* dts */
-                mtime_t i_time = LeafGetMOOVTimeInChunk( p_chunk, i_nb_samples );
+                mtime_t i_time;
+                if( LeafGetMOOVTimeInChunk( p_demux, p_track, i_chunk,
+                                            i_nb_samples, &i_time ) )
+                {
+                    block_Release( p_block );
+                    goto error;
+                }
                 i_time += p_chunk->i_first_dts;
                 p_track->i_time = i_time;
                 p_block->i_dts = VLC_TS_0 + MP4_rescale( i_time, p_track->i_timescale, CLOCK_FREQ ) ;
@@ -30,6 +30,9 @@
 #include "fragments.h"
 #include "../asf/asfpacket.h"
 
+/* Maximum number of chunks per track having their dts/pts runs expanded */
+#define MP4_CHUNK_TABLES_WINDOW 32
+
 /* Contain all information about a chunk */
 typedef struct
 {
@@ -47,6 +50,13 @@ typedef struct
     uint64_t     i_first_dts;   /* DTS of the first sample */
     uint64_t     i_duration;    /* total duration of all samples */
 
+    /* stts/ctts runs of this chunk, the tables being only expanded on
+       demand (see MP4_CHUNK_TABLES_WINDOW) from the recorded position */
+    uint32_t     i_stts_index;  /* stts entry of the first sample */
+    uint32_t     i_stts_left;   /* samples left in that entry, 0 if whole */
+    uint32_t     i_ctts_index;
+    uint32_t     i_ctts_left;
+
     uint32_t     i_entries_dts;
     uint32_t     *p_sample_count_dts;
     uint32_t     *p_sample_delta_dts;   /* dts delta */
@@ -110,11 +120,19 @@ typedef struct
 
     mp4_chunk_t    *chunk; /* always defined  for each chunk */
 
+    /* chunks with expanded dts/pts runs, oldest at i_next when full */
+    struct
+    {
+        uint32_t     chunks[MP4_CHUNK_TABLES_WINDOW];
+        unsigned     i_next;
+        unsigned     i_count;
+    } tables;
+
     /* sample size, p_sample_size defined only if i_sample_size == 0
         else i_sample_size is size for all sample */
     uint32_t         i_sample_size;
-    uint32_t         *p_sample_size; /* XXX perhaps add file offset if take
-                                    too much time to do sumations each time*/
+    const uint32_t   *p_sample_size; /* points to stsz table, XXX perhaps add
+                         file offset if take too much time to do sumations each time*/
 
     uint32_t     i_sample_first; /* i_sample_first value
                                                    of the next chunk */
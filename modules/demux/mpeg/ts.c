@@ -1614,6 +1614,73 @@ static void ParsePESDataChain( demux_t *p_demux, ts_pid_t *pid, block_t *p_pes )
     }
 }
 
+/* Upper bound for the payload buffer reserved ahead of PES reassembly */
+#define PES_GATHER_MAX_RESERVE (4 * 1024 * 1024)
+
+static void AppendPESPayload( ts_pes_t *p_pes, block_t *p_pkt )
+{
+    block_t *p_data = p_pes->gather.p_data;
+
+    /* Rather than chaining every TS packet and gathering the chain when the
+     * PES completes, payloads are copied into a single buffer reserved from
+     * the PES size (or the largest one when unbounded), and grown if needed,
+     * so that packets are released as soon as read. */
+    if( p_data == NULL )
+    {
+        size_t i_reserve = p_pes->gather.i_data_size;
+        if( i_reserve == 0 )
+            i_reserve = __MIN( p_pes->gather.i_size_max,
+                               PES_GATHER_MAX_RESERVE );
+
+        if( i_reserve > p_pkt->i_buffer )
+        {
+            p_data = block_Alloc( i_reserve );
+            if( likely(p_data) )
+            {
+                block_CopyProperties( p_data, p_pkt );
+                memcpy( p_data->p_buffer, p_pkt->p_buffer, p_pkt->i_buffer );
+                p_data->i_buffer = p_pkt->i_buffer;
+                block_Release( p_pkt );
+                p_pkt = p_data;
+            }
+            else
+                i_reserve = p_pkt->i_buffer;
+        }
+        else
+            i_reserve = p_pkt->i_buffer;
+
+        p_pes->gather.i_reserved = i_reserve;
+        block_ChainLastAppend( &p_pes->gather.pp_last, p_pkt );
+        return;
+    }
+
+    const size_t i_used = p_data->i_buffer;
+    if( i_used + p_pkt->i_buffer > p_pes->gather.i_reserved )
+    {
+        /* Grow geometrically: the payload gathered so far is copied again */
+        size_t i_reserve = __MAX( i_used + p_pkt->i_buffer,
+                                  2 * p_pes->gather.i_reserved );
+        p_data = block_Realloc( p_data, 0, i_reserve );
+        if( unlikely(p_data == NULL) )
+        {
+            block_Release( p_pkt );
+            p_pes->gather.p_data = NULL;
+            p_pes->gather.pp_last = &p_pes->gather.p_data;
+            p_pes->gather.i_data_size = 0;
+            p_pes->gather.i_gathered = 0;
+            return;
+        }
+        p_data->i_buffer = i_used;
+        p_pes->gather.i_reserved = i_reserve;
+        p_pes->gather.p_data = p_data;
+        p_pes->gather.pp_last = &p_data->p_next;
+    }
+
+    memcpy( &p_data->p_buffer[i_used], p_pkt->p_buffer, p_pkt->i_buffer );
+    p_data->i_buffer += p_pkt->i_buffer;
+    block_Release( p_pkt );
+}
+
 static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool b_unit_start )
 {
     bool b_ret = false;
@@ -1622,6 +1689,9 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
     if ( b_unit_start && p_pes->gather.p_data )
     {
         block_t *p_datachain = p_pes->gather.p_data;
+        if( p_pes->gather.i_data_size == 0 &&
+            p_pes->gather.i_gathered > p_pes->gather.i_size_max )
+            p_pes->gather.i_size_max = p_pes->gather.i_gathered;
         /* Flush the pes from pid */
         p_pes->gather.p_data = NULL;
         p_pes->gather.i_data_size = 0;
@@ -1641,8 +1711,8 @@ static bool PushPESBlock( demux_t *p_demux, ts_pid_t *pid, block_t *p_pkt, bool
         return b_ret;
     }
 
-    block_ChainLastAppend( &p_pes->gather.pp_last, p_pkt );
     p_pes->gather.i_gathered += p_pkt->i_buffer;
+    AppendPESPayload( p_pes, p_pkt );
 
     if( p_pes->gather.i_data_size > 0 &&
         p_pes->gather.i_gathered >= p_pes->gather.i_data_size )
@@ -2167,24 +2237,18 @@ static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_pmt, mtime_t i_pcr )
 
 static int IsVideoEnd( ts_pid_t *p_pid )
 {
-    /* jump to near end of PES packet */
-    block_t *p = p_pid->u.p_pes->gather.p_data;
-    if( !p || !p->p_next )
+    /* jump to end of PES packet, gathered into a single block */
+    const block_t *p = p_pid->u.p_pes->gather.p_data;
+    if( !p || p->i_buffer < 4 )
         return 0;
-    while( p->p_next->p_next )
-        p = p->p_next;
-    if( p->p_next->i_buffer > 4)
-        p = p->p_next;
+    assert( p->p_next == NULL );
 
     /* extract last bytes */
-    uint8_t tail[ 188 ];
-    const int i_tail = block_ChainExtract( p, tail, sizeof( tail ) );
-    if( i_tail < 4 )
-        return 0;
+    const uint8_t *tail = &p->p_buffer[p->i_buffer - 4];
 
     /* check for start code at end */
-    return ( tail[ i_tail - 4 ] == 0 && tail[ i_tail - 3 ] == 0 && tail[ i_tail - 2 ] == 1 &&
-             ( tail[ i_tail - 1 ] == 0xb7 ||  tail[ i_tail - 1 ] == 0x0a ) );
+    return ( tail[0] == 0 && tail[1] == 0 && tail[2] == 1 &&
+             ( tail[3] == 0xb7 || tail[3] == 0x0a ) );
 }
 
 static void PCRCheckDTS( demux_t *p_demux, ts_pmt_t *p_pmt, mtime_t i_pcr)
@@ -276,6 +276,8 @@ ts_pes_t *ts_pes_New( demux_t *p_demux, ts_pmt_t *p_program )
     pes->transport = TS_TRANSPORT_PES;
     pes->gather.i_data_size = 0;
     pes->gather.i_gathered = 0;
+    pes->gather.i_reserved = 0;
+    pes->gather.i_size_max = 0;
     pes->gather.p_data = NULL;
     pes->gather.pp_last = &pes->gather.p_data;
     pes->gather.i_saved = 0;
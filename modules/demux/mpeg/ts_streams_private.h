@@ -113,6 +113,8 @@ struct ts_pes_t
     {
         size_t      i_data_size;
         size_t      i_gathered;
+        size_t      i_reserved; /* p_data payload capacity */
+        size_t      i_size_max; /* size of the largest unbounded PES */
         block_t     *p_data;
         block_t     **pp_last;
         uint8_t     saved[5];
@@ -410,6 +410,11 @@ static int Demux( demux_t * p_demux )
             {
                 continue;
             }
+
+            /* Index pages while playing, so seeking back is immediate */
+            if( p_sys->i_page_position >= 0 )
+                Oggseek_IndexPage( p_stream, ogg_page_granulepos( &p_sys->current_page ),
+                                   p_sys->i_page_position );
         }
 
         /* clear the finished flag if pages after eos (ex: after a seek) */
@@ -704,6 +709,7 @@ static void Ogg_ResetStreamsHelper( demux_sys_t *p_sys )
         Ogg_ResetStream( p_sys->pp_stream[i] );
 
     ogg_sync_reset( &p_sys->oy );
+    p_sys->i_page_position = -1;
     p_sys->i_pcr = VLC_TS_UNKNOWN;
 }
 
@@ -777,7 +783,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
                 return VLC_EGENERIC;
             }
             vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b );
-            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) )
+            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) >= 0 )
             {
                 Ogg_ResetStreamsHelper( p_sys );
                 es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
@@ -917,7 +923,7 @@ static int Control( demux_t *p_demux, int i_query, va_list args )
             }
 
             vlc_stream_Control( p_demux->s, STREAM_CAN_FASTSEEK, &b );
-            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) )
+            if ( Oggseek_BlindSeektoAbsoluteTime( p_demux, p_stream, i64, b ) >= 0 )
             {
                 Ogg_ResetStreamsHelper( p_sys );
                 es_out_Control( p_demux->out, ES_OUT_SET_NEXT_DISPLAY_TIME,
@@ -959,6 +965,12 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
         ogg_sync_wrote( &p_ogg->oy, i_read );
     }
 
+    /* The sync buffer only holds data read sequentially since the last
+     * reset, so the page ends where its unused data begins */
+    p_ogg->i_page_position = vlc_stream_Tell( p_demux->s )
+                           - ( p_ogg->oy.fill - p_ogg->oy.returned )
+                           - ( p_oggpage->header_len + p_oggpage->body_len );
+
     return VLC_SUCCESS;
 }
 
@@ -2160,8 +2172,9 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         p_stream->p_es = NULL;
 
-        /* initialise kframe index */
-        p_stream->idx=NULL;
+        /* initialise page index */
+        p_stream->idx.p_entries = NULL;
+        p_stream->idx.i_count = p_stream->idx.i_alloc = 0;
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2255,10 +2268,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( p_stream->idx.p_entries );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -99,8 +99,13 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_keyframe_offset;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* page index for seeking, created as we discover pages */
+    struct
+    {
+        demux_index_entry_t *p_entries;
+        size_t i_count;
+        size_t i_alloc;
+    } idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -198,6 +203,9 @@ struct demux_sys_t
     /* after reading all headers, the first data page is stuffed into the relevant stream, ready to use */
     bool    b_page_waiting;
 
+    /* position of the current page read by Ogg_ReadPage, -1 if unknown */
+    int64_t i_page_position;
+
     /* count of total frames in video stream */
     int64_t i_total_frames;
 
@@ -67,115 +67,122 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
 void oggseek_index_entries_free ( demux_index_entry_t *idx )
 {
-    demux_index_entry_t *idx_next;
-
-    while ( idx != NULL )
-    {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
-    }
+    free( idx );
 }
 
 
-/* internal function to create a new list member */
+/* internal function returning the index of the first entry after i_pagepos */
 
-static demux_index_entry_t *index_entry_new( void )
+static size_t index_upper_bound( const logical_stream_t *p_stream, int64_t i_pagepos )
 {
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
+
+    while ( i_low < i_high )
+    {
+        size_t i_mid = ( i_low + i_high ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_pagepos > i_pagepos )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
+    }
+    return i_low;
 }
 
 /* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
+   time stamps). Entries too close to their neighbours, or not matching their
+   order, are not added. */
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
                                              int64_t i_timestamp,
                                              int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
-
     if ( p_stream == NULL ) return NULL;
 
-    idx = p_stream->idx;
-
     if ( i_timestamp < 1 || i_pagepos < 1 ) return NULL;
 
-    if ( idx == NULL )
-    {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
-    }
+    size_t i_pos = index_upper_bound( p_stream, i_pagepos );
+    demux_index_entry_t *p_prev = i_pos > 0 ? &p_stream->idx.p_entries[i_pos - 1] : NULL;
+    demux_index_entry_t *p_next = i_pos < p_stream->idx.i_count ? &p_stream->idx.p_entries[i_pos] : NULL;
 
-    while ( idx != NULL )
+    if ( p_prev != NULL )
     {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
+        if ( p_prev->i_pagepos == i_pagepos || p_prev->i_value > i_timestamp )
+            return NULL;
+        if ( i_timestamp - p_prev->i_value < OGGSEEK_INDEX_INTERVAL )
+            return p_prev;
     }
-
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
+    if ( p_next != NULL )
     {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
-    }
-    else
-    {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        if ( p_next->i_value < i_timestamp )
+            return NULL;
+        if ( p_next->i_value - i_timestamp < OGGSEEK_INDEX_INTERVAL )
+            return p_next;
     }
 
-    if ( idx->p_next != NULL )
+    if ( p_stream->idx.i_count == p_stream->idx.i_alloc )
     {
-        idx->p_next->p_prev = idx;
+        size_t i_alloc = __MAX( 64, p_stream->idx.i_alloc * 2 );
+        demux_index_entry_t *p_entries = realloc( p_stream->idx.p_entries,
+                                                  i_alloc * sizeof( *p_entries ) );
+        if ( !p_entries ) return NULL;
+        p_stream->idx.p_entries = p_entries;
+        p_stream->idx.i_alloc = i_alloc;
     }
 
+    demux_index_entry_t *idx = &p_stream->idx.p_entries[i_pos];
+    memmove( idx + 1, idx, ( p_stream->idx.i_count - i_pos ) * sizeof( *idx ) );
+    p_stream->idx.i_count++;
+
     idx->i_value = i_timestamp;
     idx->i_pagepos = i_pagepos;
 
     return idx;
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+/* Index a page from which decoding can start, which is any page of an audio
+   stream */
+void Oggseek_IndexPage( logical_stream_t *p_stream, int64_t i_granule,
+                        int64_t i_pagepos )
+{
+    if ( p_stream->fmt.i_cat != AUDIO_ES || p_stream->b_oggds ||
+         i_granule < 1 || i_pagepos < p_stream->i_data_start )
+        return;
+
+    int64_t i_timestamp = Oggseek_GranuleToAbsTimestamp( p_stream, i_granule, false );
+    if ( i_timestamp > 0 )
+        OggSeek_IndexAdd( p_stream, i_timestamp, i_pagepos );
+}
+
+/* returns the last entry at or before i_timestamp, and the bounds to search
+   between */
+static const demux_index_entry_t *OggSeekIndexFind ( logical_stream_t *p_stream,
+                                                     int64_t i_timestamp,
+                                                     int64_t *pi_pos_lower,
+                                                     int64_t *pi_pos_upper )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
 
-    while ( idx != NULL )
+    while ( i_low < i_high )
     {
-        if ( idx->i_value <= i_timestamp )
-        {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
-        }
-        idx = idx->p_next;
+        size_t i_mid = ( i_low + i_high ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_value > i_timestamp )
+            i_high = i_mid;
+        else
+            i_low = i_mid + 1;
     }
 
-    return false;
+    if ( i_low == 0 )
+        return NULL;
+
+    const demux_index_entry_t *idx = &p_stream->idx.p_entries[i_low - 1];
+    *pi_pos_lower = idx->i_pagepos;
+    if ( i_low < p_stream->idx.i_count ) /* not found on last index */
+        *pi_pos_upper = p_stream->idx.p_entries[i_low].i_pagepos;
+
+    return idx;
 }
 
 /*********************************************************************
@@ -193,6 +200,7 @@ static void seek_byte( demux_t *p_demux, int64_t i_pos )
         ogg_sync_reset( &p_sys->oy );
 
         p_sys->i_input_position = i_pos;
+        p_sys->i_page_position = -1;
         p_sys->b_page_waiting = false;
     }
 }
@@ -819,6 +827,7 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
         if ( current.i_pos != -1 && current.i_granule != -1 )
         {
             /* found a page */
+            Oggseek_IndexPage( p_stream, current.i_granule, current.i_pos );
 
             if ( current.i_timestamp <= i_targettime )
             {
@@ -907,10 +916,15 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     Ogg_GetBoundsUsingSkeletonIndex( p_stream, i_time, &i_lowerpos, &i_upperpos );
     if ( i_lowerpos != -1 ) b_found = true;
 
-    /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    /* And also search in our own index, which is enough if the entry found
+     * is close to the target, and otherwise bounds the search */
+    if ( !b_found )
     {
-        b_found = true;
+        const demux_index_entry_t *idx =
+                OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos );
+        if ( idx != NULL &&
+             ( !b_fastseek || i_time - idx->i_value <= OGGSEEK_INDEX_MAX_DISTANCE ) )
+            b_found = true;
     }
 
     /* Or try to be smart with audio fixed bitrate streams */
@@ -927,7 +941,9 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( !b_found && b_fastseek )
     {
         i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                            p_stream->i_data_start, p_sys->i_total_length );
+                                            __MAX( i_lowerpos, p_stream->i_data_start ),
+                                            i_upperpos < 0 ? p_sys->i_total_length : i_upperpos );
+        i_upperpos = -1;
         b_found = ( i_lowerpos != -1 );
     }
 
@@ -1004,8 +1020,17 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     }
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
+    /* Use our own index directly if close enough, otherwise as bounds */
     OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
+    const demux_index_entry_t *idx =
+        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper );
+    if ( idx != NULL && i_time - idx->i_value <= OGGSEEK_INDEX_MAX_DISTANCE )
+    {
+        ogg_stream_reset( &p_stream->os );
+        p_sys->i_input_position = idx->i_pagepos;
+        seek_byte( p_demux, p_sys->i_input_position );
+        return idx->i_pagepos;
+    }
     );
 
     i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
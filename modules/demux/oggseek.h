@@ -30,23 +30,24 @@
 
 #define OGGSEEK_BYTES_TO_READ 8500
 
-/* index entries are structured as follows:
- *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
- *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
+/* minimum time between two index entries */
+#define OGGSEEK_INDEX_INTERVAL (CLOCK_FREQ)
+/* maximum distance to the target for an index entry to be used without
+ * searching for a closer page */
+#define OGGSEEK_INDEX_MAX_DISTANCE (5 * CLOCK_FREQ)
+
+/* index entries map a timestamp to the position of a page from which
+ * decoding can start and that ends at or before that timestamp. They are
+ * kept sorted by position, and so by timestamp:
+ *   - keyframe positions found when seeking, for all streams
+ *   - pages read while playing or probed while seeking, for audio streams
  */
 
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
-    /* value is highest granulepos for theora, sync frame for dirac */
     int64_t i_value;
     int64_t i_pagepos;
-
-    /* not used for theora because the granulepos tells us this */
-    int64_t i_pagepos_end;
 };
 
 int64_t Ogg_GetKeyframeGranule ( logical_stream_t *p_stream, int64_t i_granule );
@@ -58,6 +59,7 @@ int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, int64_t
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, int64_t i_granulepos );
 const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, int64_t, int64_t );
+void    Oggseek_IndexPage( logical_stream_t *, int64_t i_granule, int64_t i_pagepos );
 void    Oggseek_ProbeEnd( demux_t * );
 
 void oggseek_index_entries_free ( demux_index_entry_t * );
@@ -0,0 +1,26 @@
+/*****************************************************************************
+ * crc32.h: MPEG-2 CRC32 of the PSI sections
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+#ifndef VLC_MPEG_CRC32_H_
+#define VLC_MPEG_CRC32_H_
+
+/* CRC32 of the MPEG-2 sections (polynomial 0x04c11db7, MSB first) */
+uint32_t MPEGCRC32( const uint8_t *p, size_t i_size );
+
+#endif
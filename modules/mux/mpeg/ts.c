@@ -157,6 +157,11 @@ static const char *const ts_standards_list_text[] =
 #define BMAX_TEXT N_( "Maximum B (deprecated)")
 #define BMAX_LONGTEXT N_( "This setting is deprecated and not used anymore")
 
+#define MUXRATE_TEXT N_("Mux rate (bits/s)")
+#define MUXRATE_LONGTEXT N_("Output a constant bitrate stream at the given " \
+  "rate, filling unused capacity with null packets and dating PCRs from " \
+  "their position in the stream. 0 disables (variable bitrate).")
+
 #define DTS_TEXT N_("DTS delay (ms)")
 #define DTS_LONGTEXT N_("Delay the DTS (decoding time " \
   "stamps) and PTS (presentation timestamps) of the data in the " \
@@ -224,6 +229,7 @@ vlc_module_begin ()
     add_integer( SOUT_CFG_PREFIX "pcr", 70, PCR_TEXT, PCR_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmin", 0, BMIN_TEXT, BMIN_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "bmax", 0, BMAX_TEXT, BMAX_LONGTEXT, true)
+    add_integer( SOUT_CFG_PREFIX "muxrate", 0, MUXRATE_TEXT, MUXRATE_LONGTEXT, true)
     add_integer( SOUT_CFG_PREFIX "dts-delay", 400, DTS_TEXT, DTS_LONGTEXT, true)
 
     add_bool( SOUT_CFG_PREFIX "crypt-audio", true, ACRYPT_TEXT, ACRYPT_LONGTEXT, true)
@@ -243,7 +249,7 @@ static const char *const ppsz_sout_options[] = {
     "standard",
     "pid-video", "pid-audio", "pid-spu", "pid-pmt", "tsid",
     "netid", "sdtdesc",
-    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "use-key-frames",
+    "es-id-pid", "shaping", "pcr", "bmin", "bmax", "muxrate", "use-key-frames",
     "dts-delay", "csa-ck", "csa2-ck", "csa-use", "csa-pkt", "crypt-audio", "crypt-video",
     "muxpmt", "program-pmt", "alignment",
     NULL
@@ -377,6 +383,19 @@ struct sout_mux_sys_t
 
     mtime_t         i_pcr;  /* last PCR emited */
 
+    /* constant bitrate output: packets are dated from the slot they
+     * occupy, i_origin + i_slot * 188 * 8 / i_muxrate */
+    int64_t         i_muxrate;
+    struct
+    {
+        bool        b_started;
+        mtime_t     i_origin;
+        int64_t     i_slot;
+        uint64_t    i_stuffing; /* null packets sent */
+        uint64_t    i_overflow; /* packets sent past their interval */
+        mtime_t     i_max_late; /* largest overflow, i.e. buffer excess */
+    } cbr;
+
     csa_t           *csa;
     int             i_csa_pkt_size;
     bool            b_crypt_audio;
@@ -726,6 +745,22 @@ static int Open( vlc_object_t *p_this )
     var_Get( p_mux, SOUT_CFG_PREFIX "dts-delay", &val );
     p_sys->i_dts_delay = val.i_int * 1000;
 
+    p_sys->i_muxrate = var_GetInteger( p_mux, SOUT_CFG_PREFIX "muxrate" );
+    if( p_sys->i_muxrate < 0 )
+        p_sys->i_muxrate = 0;
+    else if( p_sys->i_muxrate > 0 )
+    {
+        /* at least one packet per PCR interval */
+        const int64_t i_min = INT64_C(188 * 8) * CLOCK_FREQ / p_sys->i_pcr_delay + 1;
+        if( p_sys->i_muxrate < i_min )
+        {
+            msg_Warn( p_mux, "mux rate too low, using %"PRId64" bits/s", i_min );
+            p_sys->i_muxrate = i_min;
+        }
+        msg_Dbg( p_mux, "constant bitrate output at %"PRId64" bits/s",
+                 p_sys->i_muxrate );
+    }
+
     msg_Dbg( p_mux, "shaping=%"PRId64" pcr=%"PRId64" dts_delay=%"PRId64,
              p_sys->i_shaping_delay, p_sys->i_pcr_delay, p_sys->i_dts_delay );
 
@@ -751,6 +786,11 @@ static void Close( vlc_object_t * p_this )
     sout_mux_t          *p_mux = (sout_mux_t*)p_this;
     sout_mux_sys_t      *p_sys = p_mux->p_sys;
 
+    if( p_sys->i_muxrate > 0 )
+        msg_Dbg( p_mux, "CBR: %"PRIu64" null packets, %"PRIu64" late packets, "
+                 "max lateness %"PRId64"us", p_sys->cbr.i_stuffing,
+                 p_sys->cbr.i_overflow, p_sys->cbr.i_max_late );
+
     if( p_sys->p_dvbpsi )
         dvbpsi_delete( p_sys->p_dvbpsi );
 
@@ -1724,12 +1764,137 @@ static void TSSchedule( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         TSDate( p_mux, &new_chain, i_pcr_length, i_pcr_dts );
 }
 
+static void TSWrite( sout_mux_t *p_mux, block_t *p_ts,
+                     mtime_t i_dts, mtime_t i_length )
+{
+    sout_mux_sys_t  *p_sys = p_mux->p_sys;
+
+    p_ts->i_dts    = i_dts;
+    p_ts->i_length = i_length;
+
+    if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
+    {
+        /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
+        TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
+    }
+    if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
+    {
+        vlc_mutex_lock( &p_sys->csa_lock );
+        csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
+        vlc_mutex_unlock( &p_sys->csa_lock );
+    }
+
+    /* latency */
+    p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+
+    sout_AccessOutWrite( p_mux->p_access, p_ts );
+}
+
+static block_t *TSNewNull( void )
+{
+    block_t *p_ts = block_Alloc( 188 );
+    if( p_ts )
+    {
+        memset( p_ts->p_buffer, 0xff, 188 );
+        p_ts->p_buffer[0] = 0x47;
+        p_ts->p_buffer[1] = 0x1f; /* PID 0x1fff */
+        p_ts->p_buffer[2] = 0xff;
+        p_ts->p_buffer[3] = 0x10; /* payload only */
+    }
+    return p_ts;
+}
+
+static mtime_t TSSlotDate( const sout_mux_sys_t *p_sys, int64_t i_slot )
+{
+    return p_sys->cbr.i_origin +
+           i_slot * INT64_C(188 * 8) * CLOCK_FREQ / p_sys->i_muxrate;
+}
+
+static void TSDateCBR( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
+                       mtime_t i_pcr_length, mtime_t i_pcr_dts )
+{
+    sout_mux_sys_t  *p_sys = p_mux->p_sys;
+    const mtime_t i_end = i_pcr_dts + __MAX( i_pcr_length, 0 );
+    const mtime_t i_slot_length = INT64_C(188 * 8) * CLOCK_FREQ / p_sys->i_muxrate;
+
+    /* (Re)start the slot clock on the first interval or when the input
+     * timeline jumped away from it */
+    mtime_t i_date = TSSlotDate( p_sys, p_sys->cbr.i_slot );
+    if( !p_sys->cbr.b_started ||
+        i_date < i_pcr_dts - CLOCK_FREQ || i_date > i_end + CLOCK_FREQ )
+    {
+        if( p_sys->cbr.b_started )
+            msg_Warn( p_mux, "CBR clock resync (%"PRId64"us off)",
+                      i_date - i_pcr_dts );
+        p_sys->cbr.b_started = true;
+        p_sys->cbr.i_origin = i_pcr_dts;
+        p_sys->cbr.i_slot = 0;
+    }
+
+    /* Number of slots dated before the end of that interval */
+    int64_t i_slots = 0;
+    if( i_end > p_sys->cbr.i_origin )
+    {
+        const int64_t i_last = ( (i_end - p_sys->cbr.i_origin) * p_sys->i_muxrate +
+                                 INT64_C(188 * 8) * CLOCK_FREQ - 1 )
+                               / ( INT64_C(188 * 8) * CLOCK_FREQ );
+        i_slots = __MAX( i_last - p_sys->cbr.i_slot, 0 );
+    }
+
+    const int64_t i_packet_count = p_chain_ts->i_depth;
+    if( i_slots < i_packet_count )
+    {
+        /* Not enough room, the excess is sent past the interval */
+        p_sys->cbr.i_overflow += i_packet_count - i_slots;
+        i_slots = i_packet_count;
+    }
+    else
+        p_sys->cbr.i_stuffing += i_slots - i_packet_count;
+
+    /* Spread the packets evenly over the slots, stuffing the others */
+    int64_t i_acc = 0;
+    for( int64_t i = 0; i < i_slots; i++ )
+    {
+        block_t *p_ts;
+
+        i_acc += i_packet_count;
+        if( i_acc >= i_slots )
+        {
+            i_acc -= i_slots;
+            p_ts = BufferChainGet( p_chain_ts );
+        }
+        else
+            p_ts = TSNewNull();
+
+        if( likely(p_ts) )
+            TSWrite( p_mux, p_ts, TSSlotDate( p_sys, p_sys->cbr.i_slot ),
+                     i_slot_length );
+
+        /* Rebase every 188 * 8 seconds to keep the slot product in range */
+        if( ++p_sys->cbr.i_slot == p_sys->i_muxrate )
+        {
+            p_sys->cbr.i_origin += INT64_C(188 * 8) * CLOCK_FREQ;
+            p_sys->cbr.i_slot = 0;
+        }
+    }
+
+    const mtime_t i_late = TSSlotDate( p_sys, p_sys->cbr.i_slot ) - i_end;
+    if( i_late > p_sys->cbr.i_max_late )
+        p_sys->cbr.i_max_late = i_late;
+}
+
 static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                     mtime_t i_pcr_length, mtime_t i_pcr_dts )
 {
     sout_mux_sys_t  *p_sys = p_mux->p_sys;
     int i_packet_count = p_chain_ts->i_depth;
 
+    if( p_sys->i_muxrate > 0 )
+    {
+        TSDateCBR( p_mux, p_chain_ts, i_pcr_length, i_pcr_dts );
+        return;
+    }
+
     if ( i_pcr_length / 1000 > 0 )
     {
         int i_bitrate = ((uint64_t)i_packet_count * 188 * 8000)
@@ -1753,27 +1918,9 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
     for (int i = 0; i < i_packet_count; i++ )
     {
         block_t *p_ts = BufferChainGet( p_chain_ts );
-        mtime_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
-
-        p_ts->i_dts    = i_new_dts;
-        p_ts->i_length = i_pcr_length / i_packet_count;
-
-        if( p_ts->i_flags & BLOCK_FLAG_CLOCK )
-        {
-            /* msg_Dbg( p_mux, "pcr=%lld ms", p_ts->i_dts / 1000 ); */
-            TSSetPCR( p_ts, p_ts->i_dts - p_sys->first_dts );
-        }
-        if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
-        {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
-        }
-
-        /* latency */
-        p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
 
-        sout_AccessOutWrite( p_mux->p_access, p_ts );
+        TSWrite( p_mux, p_ts, i_pcr_dts + i_pcr_length * i / i_packet_count,
+                 i_pcr_length / i_packet_count );
     }
 }
 
@@ -1882,15 +2029,18 @@ static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
 
 static void TSSetPCR( block_t *p_ts, mtime_t i_dts )
 {
-    mtime_t i_pcr = 9 * i_dts / 100;
+    /* 27MHz: 90kHz base and 0..299 extension */
+    const mtime_t i_pcr27 = 27 * i_dts;
+    const mtime_t i_pcr = i_pcr27 / 300;
+    const unsigned i_ext = i_pcr27 % 300;
 
     p_ts->p_buffer[6]  = ( i_pcr >> 25 )&0xff;
     p_ts->p_buffer[7]  = ( i_pcr >> 17 )&0xff;
     p_ts->p_buffer[8]  = ( i_pcr >> 9  )&0xff;
     p_ts->p_buffer[9]  = ( i_pcr >> 1  )&0xff;
     p_ts->p_buffer[10] = ( i_pcr << 7  )&0x80;
-    p_ts->p_buffer[10] |= 0x7e;
-    p_ts->p_buffer[11] = 0; /* we don't set PCR extension */
+    p_ts->p_buffer[10] |= 0x7e | ( i_ext >> 8 );
+    p_ts->p_buffer[11] = i_ext & 0xff;
 }
 
 void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c )
@@ -33,6 +33,7 @@
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_block.h>
+#include <vlc_atomic.h>
 
 /*****************************************************************************
  * Module descriptor
@@ -68,12 +69,25 @@ struct sout_stream_sys_t
 
     int             i_nb_select;
     char            **ppsz_select;
+
+    /* destinations receiving blocks shared by reference, that they must not
+     * modify; the others receive private copies */
+    int             i_nb_share;
+    bool            *pb_share;
+    bool            b_share;
+
+    /* statistics */
+    uint64_t        i_shared;
+    uint64_t        i_shared_bytes;
+    uint64_t        i_copied;
 };
 
 struct sout_stream_id_sys_t
 {
     int                 i_nb_ids;
     void                **pp_ids;
+
+    bool                b_share; /* sent to a destination sharing blocks */
 };
 
 static bool ESSelected( const es_format_t *fmt, char *psz_select );
@@ -96,6 +110,9 @@ static int Open( vlc_object_t *p_this )
     TAB_INIT( p_sys->i_nb_streams, p_sys->pp_streams );
     TAB_INIT( p_sys->i_nb_last_streams, p_sys->pp_last_streams );
     TAB_INIT( p_sys->i_nb_select, p_sys->ppsz_select );
+    TAB_INIT( p_sys->i_nb_share, p_sys->pb_share );
+    p_sys->b_share = false;
+    p_sys->i_shared = p_sys->i_shared_bytes = p_sys->i_copied = 0;
 
     for( p_cfg = p_stream->p_cfg; p_cfg != NULL; p_cfg = p_cfg->p_next )
     {
@@ -113,6 +130,16 @@ static int Open( vlc_object_t *p_this )
                 TAB_APPEND( p_sys->i_nb_last_streams, p_sys->pp_last_streams,
                     p_last );
                 TAB_APPEND( p_sys->i_nb_select,  p_sys->ppsz_select, NULL );
+                TAB_APPEND( p_sys->i_nb_share, p_sys->pb_share, false );
+            }
+        }
+        else if( !strcmp( p_cfg->psz_name, "share" ) )
+        {
+            if( p_sys->i_nb_share > 0 )
+            {
+                msg_Dbg( p_stream, " * share blocks" );
+                p_sys->pb_share[p_sys->i_nb_share - 1] = true;
+                p_sys->b_share = true;
             }
         }
         else if( !strncmp( p_cfg->psz_name, "select", strlen( "select" ) ) )
@@ -176,6 +203,12 @@ static void Close( vlc_object_t * p_this )
     free( p_sys->pp_streams );
     free( p_sys->pp_last_streams );
     free( p_sys->ppsz_select );
+    free( p_sys->pb_share );
+
+    if( p_sys->b_share )
+        msg_Dbg( p_stream, "%"PRIu64" blocks (%"PRIu64" bytes) shared, "
+                 "%"PRIu64" copied", p_sys->i_shared, p_sys->i_shared_bytes,
+                 p_sys->i_copied );
 
     free( p_sys );
 }
@@ -194,6 +227,7 @@ static sout_stream_id_sys_t * Add( sout_stream_t *p_stream, const es_format_t *p
         return NULL;
 
     TAB_INIT( id->i_nb_ids, id->pp_ids );
+    id->b_share = false;
 
     msg_Dbg( p_stream, "duplicated a new stream codec=%4.4s (es=%d group=%d)",
              (char*)&p_fmt->i_codec, p_fmt->i_id, p_fmt->i_group );
@@ -211,6 +245,8 @@ static sout_stream_id_sys_t * Add( sout_stream_t *p_stream, const es_format_t *p
             {
                 msg_Dbg( p_stream, "    - added for output %d", i_stream );
                 i_valid_streams++;
+                if( p_sys->pb_share[i_stream] )
+                    id->b_share = true;
             }
             else
             {
@@ -257,6 +293,133 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     free( id );
 }
 
+/*****************************************************************************
+ * Shared blocks:
+ *****************************************************************************
+ * The destinations marked with "share" receive blocks pointing to the data of
+ * a single block, which is released with the last of them. That is the
+ * original block, unless it goes to a destination not sharing. They have no
+ * room before nor after the data, so that growing them with block_Realloc()
+ * copies the data instead of writing next to it.
+ *****************************************************************************/
+typedef struct
+{
+    atomic_uint refs;
+    block_t     *p_block;
+} shared_data_t;
+
+typedef struct
+{
+    block_t       self;
+    shared_data_t *p_data;
+} shared_block_t;
+
+static void SharedDataRelease( shared_data_t *p_data )
+{
+    if( atomic_fetch_sub( &p_data->refs, 1 ) == 1 )
+    {
+        block_Release( p_data->p_block );
+        free( p_data );
+    }
+}
+
+static void SharedRelease( block_t *p_block )
+{
+    shared_block_t *p_shared = (shared_block_t *)p_block;
+
+    SharedDataRelease( p_shared->p_data );
+    free( p_shared );
+}
+
+static block_t *SharedNew( shared_data_t *p_data )
+{
+    const block_t *p_block = p_data->p_block;
+    shared_block_t *p_shared = malloc( sizeof( *p_shared ) );
+    if( unlikely(p_shared == NULL) )
+        return NULL;
+
+    block_t *p_ref = &p_shared->self;
+    block_Init( p_ref, p_block->p_buffer, p_block->i_buffer );
+    p_ref->i_flags      = p_block->i_flags;
+    p_ref->i_nb_samples = p_block->i_nb_samples;
+    p_ref->i_pts        = p_block->i_pts;
+    p_ref->i_dts        = p_block->i_dts;
+    p_ref->i_length     = p_block->i_length;
+    p_ref->pf_release   = SharedRelease;
+
+    p_shared->p_data = p_data;
+    atomic_fetch_add( &p_data->refs, 1 );
+    return p_ref;
+}
+
+static void SendShared( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
+                        block_t *p_buffer )
+{
+    sout_stream_sys_t *p_sys = p_stream->p_sys;
+    int i_last = -1;
+
+    /* As without sharing, the last private destination gets the original */
+    for( int i = 0; i < p_sys->i_nb_streams; i++ )
+        if( id->pp_ids[i] && !p_sys->pb_share[i] )
+            i_last = i;
+
+    /* Copies are made first, before any destination may modify the data */
+    block_t *pp_out[p_sys->i_nb_streams];
+    for( int i = 0; i < p_sys->i_nb_streams; i++ )
+    {
+        pp_out[i] = NULL;
+        if( !id->pp_ids[i] || p_sys->pb_share[i] || i == i_last )
+            continue;
+        pp_out[i] = block_Duplicate( p_buffer );
+        if( pp_out[i] )
+            p_sys->i_copied++;
+    }
+
+    /* The shared data is held until every destination is done with it */
+    shared_data_t *p_data = malloc( sizeof( *p_data ) );
+    if( likely(p_data != NULL) )
+    {
+        atomic_init( &p_data->refs, 1 );
+        p_data->p_block = p_buffer;
+        if( i_last >= 0 )
+        {
+            p_data->p_block = block_Duplicate( p_buffer );
+            if( p_data->p_block != NULL )
+                p_sys->i_copied++;
+        }
+        if( p_data->p_block == NULL )
+        {
+            free( p_data );
+            p_data = NULL;
+        }
+    }
+
+    if( p_data != NULL )
+        for( int i = 0; i < p_sys->i_nb_streams; i++ )
+        {
+            if( !id->pp_ids[i] || !p_sys->pb_share[i] )
+                continue;
+            pp_out[i] = SharedNew( p_data );
+            if( pp_out[i] )
+            {
+                p_sys->i_shared++;
+                p_sys->i_shared_bytes += p_buffer->i_buffer;
+            }
+        }
+
+    if( i_last >= 0 )
+        pp_out[i_last] = p_buffer;
+    else if( p_data == NULL )
+        block_Release( p_buffer );
+
+    for( int i = 0; i < p_sys->i_nb_streams; i++ )
+        if( pp_out[i] )
+            sout_StreamIdSend( p_sys->pp_streams[i], id->pp_ids[i], pp_out[i] );
+
+    if( p_data != NULL )
+        SharedDataRelease( p_data );
+}
+
 /*****************************************************************************
  * Send:
  *****************************************************************************/
@@ -274,6 +437,13 @@ static int Send( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
 
         p_buffer->p_next = NULL;
 
+        if( id->b_share )
+        {
+            SendShared( p_stream, id, p_buffer );
+            p_buffer = p_next;
+            continue;
+        }
+
         for( i_stream = 0; i_stream < p_sys->i_nb_streams - 1; i_stream++ )
         {
             p_dup_stream = p_sys->pp_streams[i_stream];
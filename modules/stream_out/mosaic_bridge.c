@@ -60,6 +60,10 @@ struct sout_stream_sys_t
     int i_chroma; /* force image format chroma */
 
     filter_chain_t *p_vf2;
+
+    /* statistics */
+    unsigned i_shared; /* decoded pictures bridged without a copy */
+    unsigned i_copied;
 };
 
 struct decoder_owner_sys_t
@@ -186,6 +190,7 @@ static int Open( vlc_object_t *p_this )
 
     p_stream->p_sys = p_sys;
     p_sys->b_inited = false;
+    p_sys->i_shared = p_sys->i_copied = 0;
 
     p_sys->psz_id = var_CreateGetString( p_stream, CFG_PREFIX "id" );
 
@@ -443,6 +448,9 @@ static void Del( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     if( p_sys->p_vf2 )
         filter_chain_Delete( p_sys->p_vf2 );
 
+    msg_Dbg( p_stream, "%u pictures bridged without a copy, %u copied",
+             p_sys->i_shared, p_sys->i_copied );
+
     vlc_global_lock( VLC_MOSAIC_MUTEX );
 
     p_bridge = GetBridge( p_stream );
@@ -545,10 +553,19 @@ static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic,
             return -1;
         }
     }
+    else if( !p_sys->p_vf2 )
+    {
+        /* The mosaic only reads the pictures: the decoded one is bridged
+         * as is, even if the decoder still references it */
+        p_new_pic = p_pic;
+        p_sys->i_shared++;
+        goto bridge;
+    }
     else
     {
         /* TODO: chroma conversion if needed */
 
+        /* The filters may modify the picture in place */
         p_new_pic = picture_New( p_pic->format.i_chroma,
                                  p_pic->format.i_width, p_pic->format.i_height,
                                  p_sys->p_decoder->fmt_out.video.i_sar_num,
@@ -561,12 +578,14 @@ static int decoder_queue_video( decoder_t *p_dec, picture_t *p_pic,
         }
 
         picture_Copy( p_new_pic, p_pic );
+        p_sys->i_copied++;
     }
     picture_Release( p_pic );
 
     if( p_sys->p_vf2 )
         p_new_pic = filter_chain_VideoFilter( p_sys->p_vf2, p_new_pic );
 
+bridge:
     /* push the picture in the mosaic-struct structure */
     bridged_es_t *p_es = p_sys->p_es;
     vlc_global_lock( VLC_MOSAIC_MUTEX );
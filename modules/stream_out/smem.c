@@ -60,11 +60,15 @@
 
 #define T_VIDEO_PRERENDER_CALLBACK N_( "Video prerender callback" )
 #define LT_VIDEO_PRERENDER_CALLBACK N_( "Address of the video prerender callback function. " \
-                                "This function will set the buffer where render will be done." )
+                                "This function will set the buffer where render will be done. " \
+                                "Without it, the postrender callback gets the buffer of VLC, " \
+                                "valid until it returns." )
 
 #define T_AUDIO_PRERENDER_CALLBACK N_( "Audio prerender callback" )
 #define LT_AUDIO_PRERENDER_CALLBACK N_( "Address of the audio prerender callback function. " \
-                                        "This function will set the buffer where render will be done." )
+                                        "This function will set the buffer where render will be done. " \
+                                        "Without it, the postrender callback gets the buffer of VLC, " \
+                                        "valid until it returns." )
 
 #define T_VIDEO_POSTRENDER_CALLBACK N_( "Video postrender callback" )
 #define LT_VIDEO_POSTRENDER_CALLBACK N_( "Address of the video postrender callback function. " \
@@ -155,8 +159,6 @@ struct sout_stream_sys_t
     bool time_sync;
 };
 
-void VideoPrerenderDefaultCallback( void* p_video_data, uint8_t** pp_pixel_buffer, size_t size );
-void AudioPrerenderDefaultCallback( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size );
 void VideoPostrenderDefaultCallback( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height,
                                      int pixel_pitch, size_t size, mtime_t pts );
 void AudioPostrenderDefaultCallback( void* p_audio_data, uint8_t* p_pcm_buffer, unsigned int channels,
@@ -167,16 +169,6 @@ void AudioPostrenderDefaultCallback( void* p_audio_data, uint8_t* p_pcm_buffer,
  * Default empty callbacks
  *****************************************************************************/
 
-void VideoPrerenderDefaultCallback( void* p_video_data, uint8_t** pp_pixel_buffer, size_t size )
-{
-    VLC_UNUSED( p_video_data ); VLC_UNUSED( pp_pixel_buffer ); VLC_UNUSED( size );
-}
-
-void AudioPrerenderDefaultCallback( void* p_audio_data, uint8_t** pp_pcm_buffer, size_t size )
-{
-    VLC_UNUSED( p_audio_data ); VLC_UNUSED( pp_pcm_buffer ); VLC_UNUSED( size );
-}
-
 void VideoPostrenderDefaultCallback( void* p_video_data, uint8_t* p_pixel_buffer, int width, int height,
                                      int pixel_pitch, size_t size, mtime_t pts )
 {
@@ -216,14 +208,10 @@ static int Open( vlc_object_t *p_this )
     psz_tmp = var_GetString( p_stream, SOUT_PREFIX_VIDEO "prerender-callback" );
     p_sys->pf_video_prerender_callback = (void (*) (void *, uint8_t**, size_t))(intptr_t)atoll( psz_tmp );
     free( psz_tmp );
-    if (p_sys->pf_video_prerender_callback == NULL)
-        p_sys->pf_video_prerender_callback = VideoPrerenderDefaultCallback;
 
     psz_tmp = var_GetString( p_stream, SOUT_PREFIX_AUDIO "prerender-callback" );
     p_sys->pf_audio_prerender_callback = (void (*) (void* , uint8_t**, size_t))(intptr_t)atoll( psz_tmp );
     free( psz_tmp );
-    if (p_sys->pf_audio_prerender_callback == NULL)
-        p_sys->pf_audio_prerender_callback = AudioPrerenderDefaultCallback;
 
     psz_tmp = var_GetString( p_stream, SOUT_PREFIX_VIDEO "postrender-callback" );
     p_sys->pf_video_postrender_callback = (void (*) (void*, uint8_t*, int, int, int, size_t, mtime_t))(intptr_t)atoll( psz_tmp );
@@ -366,18 +354,24 @@ static int SendVideo( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     size_t i_size = p_buffer->i_buffer;
     uint8_t* p_pixels = NULL;
 
-    /* Calling the prerender callback to get user buffer */
-    p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
-
-    if (!p_pixels)
+    if( p_sys->pf_video_prerender_callback == NULL )
+        /* Lending our own buffer for the postrender callback */
+        p_pixels = p_buffer->p_buffer;
+    else
     {
-        msg_Err( p_stream, "No buffer given!" );
-        block_ChainRelease( p_buffer );
-        return VLC_EGENERIC;
+        /* Calling the prerender callback to get user buffer */
+        p_sys->pf_video_prerender_callback( id->p_data, &p_pixels, i_size );
+
+        if (!p_pixels)
+        {
+            msg_Err( p_stream, "No buffer given!" );
+            block_ChainRelease( p_buffer );
+            return VLC_EGENERIC;
+        }
+
+        /* Copying data into user buffer */
+        memcpy( p_pixels, p_buffer->p_buffer, i_size );
     }
-
-    /* Copying data into user buffer */
-    memcpy( p_pixels, p_buffer->p_buffer, i_size );
     /* Calling the postrender callback to tell the user his buffer is ready */
     p_sys->pf_video_postrender_callback( id->p_data, p_pixels,
                                          id->format->video.i_width, id->format->video.i_height,
@@ -403,17 +397,23 @@ static int SendAudio( sout_stream_t *p_stream, sout_stream_id_sys_t *id,
     }
 
     i_samples = i_size / ( ( id->format->audio.i_bitspersample / 8 ) * id->format->audio.i_channels );
-    /* Calling the prerender callback to get user buffer */
-    p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
-    if (!p_pcm_buffer)
+    if( p_sys->pf_audio_prerender_callback == NULL )
+        /* Lending our own buffer for the postrender callback */
+        p_pcm_buffer = p_buffer->p_buffer;
+    else
     {
-        msg_Err( p_stream, "No buffer given!" );
-        block_ChainRelease( p_buffer );
-        return VLC_EGENERIC;
+        /* Calling the prerender callback to get user buffer */
+        p_sys->pf_audio_prerender_callback( id->p_data, &p_pcm_buffer, i_size );
+        if (!p_pcm_buffer)
+        {
+            msg_Err( p_stream, "No buffer given!" );
+            block_ChainRelease( p_buffer );
+            return VLC_EGENERIC;
+        }
+
+        /* Copying data into user buffer */
+        memcpy( p_pcm_buffer, p_buffer->p_buffer, i_size );
     }
-
-    /* Copying data into user buffer */
-    memcpy( p_pcm_buffer, p_buffer->p_buffer, i_size );
     /* Calling the postrender callback to tell the user his buffer is ready */
     p_sys->pf_audio_postrender_callback( id->p_data, p_pcm_buffer,
                                          id->format->audio.i_channels, id->format->audio.i_rate, i_samples,
@@ -34,15 +34,25 @@
 #include <vlc_meta.h>
 #include <vlc_spu.h>
 #include <vlc_modules.h>
+#include <vlc_picture_pool.h>
 
 #define ENC_FRAMERATE (25 * 1000)
 #define ENC_FRAMERATE_BASE 1000
 
+/* Number of recycled decoded pictures. The decoder references, the filters
+ * and the encoder queue may hold more, which are then allocated on the fly. */
+#define DECODER_POOL_SIZE 8
+
 struct decoder_owner_sys_t
 {
     sout_stream_sys_t *p_sys;
     sout_stream_t *p_stream;
     sout_stream_id_sys_t *id;
+
+    /* Decoded pictures pool, the decoder may allocate from several threads */
+    vlc_mutex_t     pool_lock;
+    picture_pool_t *p_pool;
+    video_format_t  pool_fmt;
 };
 
 static int video_update_format_decoder( decoder_t *p_dec )
@@ -79,7 +89,34 @@ static int video_update_format_decoder( decoder_t *p_dec )
 
 static picture_t *video_new_buffer_decoder( decoder_t *p_dec )
 {
-    return picture_NewFromFormat( &p_dec->fmt_out.video );
+    decoder_owner_sys_t *owner = p_dec->p_owner;
+    const video_format_t *fmt = &p_dec->fmt_out.video;
+    picture_t *p_pic = NULL;
+
+    /* Palettes are referenced, not copied, by the pictures */
+    if( fmt->p_palette == NULL )
+    {
+        vlc_mutex_lock( &owner->pool_lock );
+        if( owner->p_pool != NULL &&
+            !video_format_IsSamePool( &owner->pool_fmt, fmt ) )
+        {
+            /* Pictures still in use remain valid */
+            picture_pool_Release( owner->p_pool );
+            owner->p_pool = NULL;
+        }
+        if( owner->p_pool == NULL )
+        {
+            owner->p_pool = picture_pool_NewFromFormat( fmt, DECODER_POOL_SIZE );
+            owner->pool_fmt = *fmt;
+        }
+        if( owner->p_pool != NULL )
+            p_pic = picture_pool_Get( owner->p_pool );
+        vlc_mutex_unlock( &owner->pool_lock );
+    }
+
+    if( p_pic == NULL )
+        p_pic = picture_NewFromFormat( fmt );
+    return p_pic;
 }
 
 static picture_t *video_new_buffer_encoder( encoder_t *p_enc )
@@ -94,6 +131,14 @@ static picture_t *transcode_video_filter_buffer_new( filter_t *p_filter )
     return picture_NewFromFormat( &p_filter->fmt_out.video );
 }
 
+static void video_owner_delete( decoder_owner_sys_t *owner )
+{
+    if( owner->p_pool != NULL )
+        picture_pool_Release( owner->p_pool );
+    vlc_mutex_destroy( &owner->pool_lock );
+    free( owner );
+}
+
 static void* EncoderThread( void *obj )
 {
     sout_stream_sys_t *p_sys = (sout_stream_sys_t*)obj;
@@ -199,6 +244,8 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     id->p_decoder->p_owner->p_sys = p_sys;
     id->p_decoder->p_owner->p_stream = p_stream;
     id->p_decoder->p_owner->id = id;
+    vlc_mutex_init( &id->p_decoder->p_owner->pool_lock );
+    id->p_decoder->p_owner->p_pool = NULL;
 
     id->p_decoder->p_module =
         module_need( id->p_decoder, "decoder", "$codec", false );
@@ -206,7 +253,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
     if( !id->p_decoder->p_module )
     {
         msg_Err( p_stream, "cannot find video decoder" );
-        free( id->p_decoder->p_owner );
+        video_owner_delete( id->p_decoder->p_owner );
         return VLC_EGENERIC;
     }
 
@@ -257,7 +304,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
                  (char *)&p_sys->i_vcodec );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = 0;
-        free( id->p_decoder->p_owner );
+        video_owner_delete( id->p_decoder->p_owner );
         return VLC_EGENERIC;
     }
 
@@ -284,7 +331,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         msg_Err( p_stream, "cannot create picture fifo" );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
-        free( id->p_decoder->p_owner );
+        video_owner_delete( id->p_decoder->p_owner );
         return VLC_ENOMEM;
     }
 
@@ -301,7 +348,7 @@ int transcode_video_new( sout_stream_t *p_stream, sout_stream_id_sys_t *id )
         picture_fifo_Delete( p_sys->pp_pics );
         module_unneed( id->p_decoder, id->p_decoder->p_module );
         id->p_decoder->p_module = NULL;
-        free( id->p_decoder->p_owner );
+        video_owner_delete( id->p_decoder->p_owner );
         return VLC_EGENERIC;
     }
     return VLC_SUCCESS;
@@ -693,7 +740,7 @@ void transcode_video_close( sout_stream_t *p_stream,
     if( id->p_decoder->p_description )
         vlc_meta_Delete( id->p_decoder->p_description );
 
-    free( id->p_decoder->p_owner );
+    video_owner_delete( id->p_decoder->p_owner );
 
     /* Close encoder */
     if( id->p_encoder->p_module )
@@ -1231,6 +1231,8 @@ static int Create( vlc_object_t *p_this )
     vlc_dictionary_init( &p_sys->family_map, 50 );
     vlc_dictionary_init( &p_sys->fallback_map, 20 );
 
+    p_sys->p_glyph_cache = GlyphCacheNew();
+
     p_sys->i_scale = 100;
 
     /* default style to apply to uncomplete segmeents styles */
@@ -1349,6 +1351,9 @@ static void Destroy( vlc_object_t *p_this )
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
 
+    /* Glyphs reference the faces */
+    GlyphCacheDelete( p_filter, p_sys->p_glyph_cache );
+
     /* Fonts dicts */
     vlc_dictionary_clear( &p_sys->fallback_map, FreeFamilies, p_filter );
     vlc_dictionary_clear( &p_sys->face_map, FreeFace, p_filter );
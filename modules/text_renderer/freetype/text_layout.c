@@ -115,6 +115,61 @@ typedef struct run_desc_t
 
 } run_desc_t;
 
+/**
+ * Glyph cache. Loaded glyphs, with synthetic styles applied and their
+ * stroked outline, are kept per face (and thus size), glyph index and
+ * style, together with the bitmaps they were rendered to at a few
+ * sub-pixel pen positions. Least recently used entries are only evicted
+ * when a layout starts, so entries remain valid during a layout.
+ */
+#define GLYPH_CACHE_BUCKETS  1024
+#define GLYPH_CACHE_BITMAPS  4
+#define GLYPH_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+#define GLYPH_SYNTHETIC_BOLD    0x01
+#define GLYPH_SYNTHETIC_ITALIC  0x02
+
+typedef struct glyph_cache_entry_t glyph_cache_entry_t;
+struct glyph_cache_entry_t
+{
+    glyph_cache_entry_t *p_hash_next;
+    glyph_cache_entry_t *p_lru_prev;    /* more recently used */
+    glyph_cache_entry_t *p_lru_next;    /* less recently used */
+
+    FT_Face     p_face;
+    FT_UInt     i_glyph_index;
+    int         i_flags;                /* GLYPH_SYNTHETIC_* */
+    FT_Fixed    i_radius;               /* outline radius, -1 if none */
+
+    FT_Glyph    p_glyph;
+    FT_Glyph    p_outline;
+    FT_Vector   advance;
+
+    struct
+    {
+        FT_Glyph p_bitmap;
+        bool     b_outline;
+        FT_Pos   i_x;                   /* sub-pixel pen position */
+        FT_Pos   i_y;
+    } bitmaps[GLYPH_CACHE_BITMAPS];
+    unsigned    i_next_bitmap;
+
+    size_t      i_size;
+};
+
+struct glyph_cache_t
+{
+    glyph_cache_entry_t *pp_buckets[GLYPH_CACHE_BUCKETS];
+    glyph_cache_entry_t *p_lru_first;
+    glyph_cache_entry_t *p_lru_last;
+    size_t               i_size;
+
+    uint64_t             i_hits;
+    uint64_t             i_misses;
+    uint64_t             i_bitmap_hits;
+    uint64_t             i_bitmap_misses;
+};
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -123,6 +178,7 @@ typedef struct glyph_bitmaps_t
     FT_Glyph p_glyph;
     FT_Glyph p_outline;
     FT_Glyph p_shadow;
+    glyph_cache_entry_t *p_cache_entry;
     FT_BBox  glyph_bbox;
     FT_BBox  outline_bbox;
     FT_BBox  shadow_bbox;
@@ -159,6 +215,268 @@ typedef struct paragraph_t
 
 } paragraph_t;
 
+static size_t GlyphSize( FT_Glyph glyph )
+{
+    if( !glyph )
+        return 0;
+
+    if( glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &( ( FT_BitmapGlyph ) glyph )->bitmap;
+        return sizeof( FT_BitmapGlyphRec ) +
+               (size_t) abs( p_bitmap->pitch ) * p_bitmap->rows;
+    }
+    else if( glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &( ( FT_OutlineGlyph ) glyph )->outline;
+        return sizeof( FT_OutlineGlyphRec ) +
+               p_outline->n_points * ( sizeof( FT_Vector ) + 1 ) +
+               p_outline->n_contours * sizeof( short );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+static unsigned GlyphCacheHash( FT_Face p_face, FT_UInt i_glyph_index,
+                                int i_flags, FT_Fixed i_radius )
+{
+    uintptr_t i_hash = ( uintptr_t ) p_face >> 4;
+    i_hash = i_hash * 31 + i_glyph_index;
+    i_hash = i_hash * 31 + i_flags;
+    i_hash = i_hash * 31 + ( uintptr_t ) i_radius;
+    return i_hash % GLYPH_CACHE_BUCKETS;
+}
+
+glyph_cache_t *GlyphCacheNew( void )
+{
+    return calloc( 1, sizeof( glyph_cache_t ) );
+}
+
+static void GlyphCacheUnlink( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry )
+{
+    glyph_cache_entry_t **pp = &p_cache->pp_buckets[
+            GlyphCacheHash( p_entry->p_face, p_entry->i_glyph_index,
+                            p_entry->i_flags, p_entry->i_radius ) ];
+    while( *pp != p_entry )
+        pp = &( *pp )->p_hash_next;
+    *pp = p_entry->p_hash_next;
+
+    if( p_entry->p_lru_prev )
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+    else
+        p_cache->p_lru_first = p_entry->p_lru_next;
+    if( p_entry->p_lru_next )
+        p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+    else
+        p_cache->p_lru_last = p_entry->p_lru_prev;
+
+    p_cache->i_size -= p_entry->i_size;
+}
+
+static void GlyphCacheEntryDelete( glyph_cache_entry_t *p_entry )
+{
+    FT_Done_Glyph( p_entry->p_glyph );
+    if( p_entry->p_outline )
+        FT_Done_Glyph( p_entry->p_outline );
+    for( int i = 0; i < GLYPH_CACHE_BITMAPS; i++ )
+        if( p_entry->bitmaps[i].p_bitmap )
+            FT_Done_Glyph( p_entry->bitmaps[i].p_bitmap );
+    free( p_entry );
+}
+
+static void GlyphCacheTrim( glyph_cache_t *p_cache, size_t i_max_size )
+{
+    if( !p_cache )
+        return;
+
+    while( p_cache->p_lru_last && p_cache->i_size > i_max_size )
+    {
+        glyph_cache_entry_t *p_entry = p_cache->p_lru_last;
+        GlyphCacheUnlink( p_cache, p_entry );
+        GlyphCacheEntryDelete( p_entry );
+    }
+}
+
+void GlyphCacheDelete( filter_t *p_filter, glyph_cache_t *p_cache )
+{
+    if( !p_cache )
+        return;
+
+    msg_Dbg( p_filter, "glyph cache: %"PRIu64" hits, %"PRIu64" misses, "
+             "bitmaps: %"PRIu64" hits, %"PRIu64" misses",
+             p_cache->i_hits, p_cache->i_misses,
+             p_cache->i_bitmap_hits, p_cache->i_bitmap_misses );
+
+    GlyphCacheTrim( p_cache, 0 );
+    free( p_cache );
+}
+
+static glyph_cache_entry_t *GlyphCacheGet( glyph_cache_t *p_cache,
+                                           FT_Face p_face, FT_UInt i_glyph_index,
+                                           int i_flags, FT_Fixed i_radius )
+{
+    if( !p_cache )
+        return NULL;
+
+    glyph_cache_entry_t *p_entry =
+        p_cache->pp_buckets[ GlyphCacheHash( p_face, i_glyph_index,
+                                             i_flags, i_radius ) ];
+    for( ; p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->p_face == p_face &&
+            p_entry->i_glyph_index == i_glyph_index &&
+            p_entry->i_flags == i_flags && p_entry->i_radius == i_radius )
+            break;
+    }
+
+    if( !p_entry )
+    {
+        p_cache->i_misses++;
+        return NULL;
+    }
+    p_cache->i_hits++;
+
+    /* Move to front */
+    if( p_entry->p_lru_prev )
+    {
+        p_entry->p_lru_prev->p_lru_next = p_entry->p_lru_next;
+        if( p_entry->p_lru_next )
+            p_entry->p_lru_next->p_lru_prev = p_entry->p_lru_prev;
+        else
+            p_cache->p_lru_last = p_entry->p_lru_prev;
+
+        p_entry->p_lru_prev = NULL;
+        p_entry->p_lru_next = p_cache->p_lru_first;
+        p_cache->p_lru_first->p_lru_prev = p_entry;
+        p_cache->p_lru_first = p_entry;
+    }
+    return p_entry;
+}
+
+static glyph_cache_entry_t *GlyphCacheAdd( glyph_cache_t *p_cache,
+                                           FT_Face p_face, FT_UInt i_glyph_index,
+                                           int i_flags, FT_Fixed i_radius,
+                                           FT_Glyph p_glyph, FT_Glyph p_outline,
+                                           const FT_Vector *p_advance )
+{
+    if( !p_cache )
+        return NULL;
+
+    glyph_cache_entry_t *p_entry = calloc( 1, sizeof( *p_entry ) );
+    if( !p_entry )
+        return NULL;
+
+    if( FT_Glyph_Copy( p_glyph, &p_entry->p_glyph ) )
+    {
+        free( p_entry );
+        return NULL;
+    }
+    if( p_outline && FT_Glyph_Copy( p_outline, &p_entry->p_outline ) )
+    {
+        FT_Done_Glyph( p_entry->p_glyph );
+        free( p_entry );
+        return NULL;
+    }
+
+    p_entry->p_face = p_face;
+    p_entry->i_glyph_index = i_glyph_index;
+    p_entry->i_flags = i_flags;
+    p_entry->i_radius = i_radius;
+    p_entry->advance = *p_advance;
+    p_entry->i_size = sizeof( *p_entry ) + GlyphSize( p_entry->p_glyph )
+                    + GlyphSize( p_entry->p_outline );
+
+    glyph_cache_entry_t **pp_bucket = &p_cache->pp_buckets[
+            GlyphCacheHash( p_face, i_glyph_index, i_flags, i_radius ) ];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+
+    p_entry->p_lru_next = p_cache->p_lru_first;
+    if( p_cache->p_lru_first )
+        p_cache->p_lru_first->p_lru_prev = p_entry;
+    else
+        p_cache->p_lru_last = p_entry;
+    p_cache->p_lru_first = p_entry;
+
+    p_cache->i_size += p_entry->i_size;
+    return p_entry;
+}
+
+/**
+ * Render a glyph to a bitmap at the given pen position. With a cache entry,
+ * the bitmap is rendered once per sub-pixel position then copied and moved.
+ * As with FT_Glyph_To_Bitmap(), the source glyph is only destroyed on success.
+ */
+static FT_Error RenderGlyph( glyph_cache_t *p_cache, glyph_cache_entry_t *p_entry,
+                             bool b_outline, FT_Glyph *pp_glyph,
+                             FT_Vector *p_pen, bool b_destroy )
+{
+    if( !p_entry )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   p_pen, b_destroy );
+
+    FT_Vector frac = { .x = p_pen->x & 63, .y = p_pen->y & 63 };
+    FT_Glyph p_bitmap = NULL;
+    FT_Error error;
+
+    for( int i = 0; i < GLYPH_CACHE_BITMAPS; i++ )
+    {
+        if( p_entry->bitmaps[i].p_bitmap &&
+            p_entry->bitmaps[i].b_outline == b_outline &&
+            p_entry->bitmaps[i].i_x == frac.x &&
+            p_entry->bitmaps[i].i_y == frac.y )
+        {
+            p_bitmap = p_entry->bitmaps[i].p_bitmap;
+            p_cache->i_bitmap_hits++;
+            break;
+        }
+    }
+
+    if( !p_bitmap )
+    {
+        error = FT_Glyph_Copy( b_outline ? p_entry->p_outline : p_entry->p_glyph,
+                               &p_bitmap );
+        if( error )
+            return error;
+        error = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL, &frac, 1 );
+        if( error )
+        {
+            FT_Done_Glyph( p_bitmap );
+            return error;
+        }
+        p_cache->i_bitmap_misses++;
+
+        unsigned i_slot = p_entry->i_next_bitmap;
+        p_entry->i_next_bitmap = ( i_slot + 1 ) % GLYPH_CACHE_BITMAPS;
+        if( p_entry->bitmaps[i_slot].p_bitmap )
+        {
+            const size_t i_size = GlyphSize( p_entry->bitmaps[i_slot].p_bitmap );
+            p_entry->i_size -= i_size;
+            p_cache->i_size -= i_size;
+            FT_Done_Glyph( p_entry->bitmaps[i_slot].p_bitmap );
+        }
+        p_entry->bitmaps[i_slot].p_bitmap = p_bitmap;
+        p_entry->bitmaps[i_slot].b_outline = b_outline;
+        p_entry->bitmaps[i_slot].i_x = frac.x;
+        p_entry->bitmaps[i_slot].i_y = frac.y;
+        p_entry->i_size += GlyphSize( p_bitmap );
+        p_cache->i_size += GlyphSize( p_bitmap );
+    }
+
+    FT_Glyph p_copy;
+    error = FT_Glyph_Copy( p_bitmap, &p_copy );
+    if( error )
+        return error;
+
+    /* Whole pixels translation of the sub-pixel rendering */
+    ( ( FT_BitmapGlyph ) p_copy )->left += ( p_pen->x - frac.x ) / 64;
+    ( ( FT_BitmapGlyph ) p_copy )->top  += ( p_pen->y - frac.y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_copy;
+    return 0;
+}
+
 static void FreeLine( line_desc_t *p_line )
 {
     for( int i = 0; i < p_line->i_character_count; i++ )
@@ -955,18 +1273,27 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        FT_Fixed i_radius = -1;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
                 var_InheritInteger( p_filter, "freetype-outline-thickness" ) / 100.0;
             f_outline_thickness = VLC_CLIP( f_outline_thickness, 0.0, 0.5 );
-            int i_radius = ( i_live_size << 6 ) * f_outline_thickness;
+            i_radius = ( i_live_size << 6 ) * f_outline_thickness;
             FT_Stroker_Set( p_sys->p_stroker,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
         }
 
+        int i_synthetic_flags = 0;
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_synthetic_flags |= GLYPH_SYNTHETIC_BOLD;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_synthetic_flags |= GLYPH_SYNTHETIC_ITALIC;
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -983,6 +1310,7 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         p_bitmaps->p_glyph = 0; \
         p_bitmaps->p_outline = 0; \
         p_bitmaps->p_shadow = 0; \
+        p_bitmaps->p_cache_entry = NULL; \
         p_bitmaps->i_x_advance = 0; \
         p_bitmaps->i_y_advance = 0; \
         continue; \
@@ -1017,30 +1345,58 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            FT_Vector advance;
+            glyph_cache_entry_t *p_entry =
+                GlyphCacheGet( p_sys->p_glyph_cache, p_face, i_glyph_index,
+                               i_synthetic_flags, i_radius );
+            if( p_entry )
+            {
+                if( FT_Glyph_Copy( p_entry->p_glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                p_bitmaps->p_outline = 0;
+                if( p_entry->p_outline
+                 && FT_Glyph_Copy( p_entry->p_outline, &p_bitmaps->p_outline ) )
+                    p_bitmaps->p_outline = 0;
+
+                advance = p_entry->advance;
+            }
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                if( i_synthetic_flags & GLYPH_SYNTHETIC_BOLD )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( i_synthetic_flags & GLYPH_SYNTHETIC_ITALIC )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
+
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                if( i_radius >= 0 )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+                advance = p_face->glyph->advance;
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+                /* Bitmap fonts can't be moved by sub-pixel rendering */
+                if( p_bitmaps->p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+                    p_entry = GlyphCacheAdd( p_sys->p_glyph_cache, p_face,
+                                             i_glyph_index, i_synthetic_flags,
+                                             i_radius, p_bitmaps->p_glyph,
+                                             p_bitmaps->p_outline, &advance );
+            }
 
 #undef SKIP_GLYPH
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_filter->p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
-            }
+            p_bitmaps->p_cache_entry = p_entry;
 
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
@@ -1048,8 +1404,8 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
         }
 
@@ -1152,8 +1508,9 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            if( RenderGlyph( p_sys->p_glyph_cache, p_bitmaps->p_cache_entry,
+                             p_bitmaps->p_shadow == p_bitmaps->p_outline,
+                             &p_bitmaps->p_shadow, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1161,8 +1518,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys->p_glyph_cache, p_bitmaps->p_cache_entry,
+                             false, &p_bitmaps->p_glyph, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1178,8 +1535,8 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys->p_glyph_cache, p_bitmaps->p_cache_entry,
+                             true, &p_bitmaps->p_outline, &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -1439,6 +1796,8 @@ int LayoutText( filter_t *p_filter, line_desc_t **pp_lines,
     int i_max_height = 0;
     int i_max_advance_x = 0;
 
+    GlyphCacheTrim( p_filter->p_sys->p_glyph_cache, GLYPH_CACHE_MAX_SIZE );
+
     for( int i = 0; i <= i_len; ++i )
     {
         if( i == i_len || psz_text[ i ] == '\n' )
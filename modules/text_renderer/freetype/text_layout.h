@@ -62,6 +62,17 @@ struct line_desc_t
 void FreeLines( line_desc_t *p_lines );
 line_desc_t *NewLine( int i_count );
 
+/**
+ * Create the cache of loaded glyphs and rendered bitmaps kept across
+ * LayoutText() calls.
+ */
+glyph_cache_t *GlyphCacheNew( void );
+
+/**
+ * Release the glyph cache. This must happen before releasing the faces.
+ */
+void GlyphCacheDelete( filter_t *p_filter, glyph_cache_t *p_cache );
+
 /**
  * Layout the text with shaping, bidirectional support, and font fallback if available.
  *
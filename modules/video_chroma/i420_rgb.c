@@ -39,23 +39,15 @@
 #include <vlc_cpu.h>
 
 #include "i420_rgb.h"
+#include "slices.h"
 #ifdef PLAIN
 # include "i420_rgb_c.h"
-static picture_t *I420_RGB8_Filter( filter_t *, picture_t * );
-static picture_t *I420_RGB16_Filter( filter_t *, picture_t * );
-static picture_t *I420_RGB32_Filter( filter_t *, picture_t * );
 
 static void SetGammaTable( int *pi_table, double f_gamma );
 static void SetYUV( filter_t * );
 static void Set8bppPalette( filter_t *, uint8_t * );
-#else
-static picture_t *I420_R5G5B5_Filter( filter_t *, picture_t * );
-static picture_t *I420_R5G6B5_Filter( filter_t *, picture_t * );
-static picture_t *I420_A8R8G8B8_Filter( filter_t *, picture_t * );
-static picture_t *I420_R8G8B8A8_Filter( filter_t *, picture_t * );
-static picture_t *I420_B8G8R8A8_Filter( filter_t *, picture_t * );
-static picture_t *I420_A8B8G8R8_Filter( filter_t *, picture_t * );
 #endif
+static picture_t *Filter( filter_t *, picture_t * );
 
 /*****************************************************************************
  * RGB2PIXEL: assemble RGB components to a pixel value, returns a uint32_t
@@ -102,6 +94,7 @@ vlc_module_end ()
 static int Activate( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
+    void (*pf_convert)( filter_t *, picture_t *, picture_t * );
 #ifdef PLAIN
     size_t i_tables_size;
 #endif
@@ -135,7 +128,7 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* R5G5B6 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is R5G5B5");
-                        p_filter->pf_video_filter = I420_R5G5B5_Filter;
+                        pf_convert = I420_R5G5B5;
                     }
                     else if( ( p_filter->fmt_out.video.i_rmask == 0xf800
                             && p_filter->fmt_out.video.i_gmask == 0x07e0
@@ -143,7 +136,7 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* R5G6B5 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is R5G6B5");
-                        p_filter->pf_video_filter = I420_R5G6B5_Filter;
+                        pf_convert = I420_R5G6B5;
                     }
                     else
                         return VLC_EGENERIC;
@@ -156,7 +149,7 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* A8R8G8B8 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is A8R8G8B8");
-                        p_filter->pf_video_filter = I420_A8R8G8B8_Filter;
+                        pf_convert = I420_A8R8G8B8;
                     }
                     else if( p_filter->fmt_out.video.i_rmask == 0xff000000
                           && p_filter->fmt_out.video.i_gmask == 0x00ff0000
@@ -164,7 +157,7 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* R8G8B8A8 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is R8G8B8A8");
-                        p_filter->pf_video_filter = I420_R8G8B8A8_Filter;
+                        pf_convert = I420_R8G8B8A8;
                     }
                     else if( p_filter->fmt_out.video.i_rmask == 0x0000ff00
                           && p_filter->fmt_out.video.i_gmask == 0x00ff0000
@@ -172,7 +165,7 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* B8G8R8A8 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is B8G8R8A8");
-                        p_filter->pf_video_filter = I420_B8G8R8A8_Filter;
+                        pf_convert = I420_B8G8R8A8;
                     }
                     else if( p_filter->fmt_out.video.i_rmask == 0x000000ff
                           && p_filter->fmt_out.video.i_gmask == 0x0000ff00
@@ -180,21 +173,21 @@ static int Activate( vlc_object_t *p_this )
                     {
                         /* A8B8G8R8 pixel format */
                         msg_Dbg(p_this, "RGB pixel format is A8B8G8R8");
-                        p_filter->pf_video_filter = I420_A8B8G8R8_Filter;
+                        pf_convert = I420_A8B8G8R8;
                     }
                     else
                         return VLC_EGENERIC;
                     break;
 #else
                 case VLC_CODEC_RGB8:
-                    p_filter->pf_video_filter = I420_RGB8_Filter;
+                    pf_convert = I420_RGB8;
                     break;
                 case VLC_CODEC_RGB15:
                 case VLC_CODEC_RGB16:
-                    p_filter->pf_video_filter = I420_RGB16_Filter;
+                    pf_convert = I420_RGB16;
                     break;
                 case VLC_CODEC_RGB32:
-                    p_filter->pf_video_filter = I420_RGB32_Filter;
+                    pf_convert = I420_RGB32;
                     break;
 #endif
                 default:
@@ -276,6 +269,22 @@ static int Activate( vlc_object_t *p_this )
     SetYUV( p_filter );
 #endif
 
+    p_filter->p_sys->pf_convert = pf_convert;
+
+    /* Without scaling, the lines are converted independently */
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+    if( p_fmti->i_x_offset + p_fmti->i_visible_width
+            == p_fmto->i_x_offset + p_fmto->i_visible_width
+     && p_fmti->i_y_offset + p_fmti->i_visible_height
+            == p_fmto->i_y_offset + p_fmto->i_visible_height )
+        p_filter->p_sys->p_slices =
+            SlicePoolNew( p_this, p_fmto->i_x_offset + p_fmto->i_visible_width,
+                          p_fmto->i_y_offset + p_fmto->i_visible_height );
+    else
+        p_filter->p_sys->p_slices = NULL;
+
+    p_filter->pf_video_filter = Filter;
     return 0;
 }
 
@@ -288,6 +297,8 @@ static void Deactivate( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    if( p_filter->p_sys->p_slices != NULL )
+        SlicePoolDelete( p_filter->p_sys->p_slices );
 #ifdef PLAIN
     free( p_filter->p_sys->p_base );
 #endif
@@ -296,18 +307,70 @@ static void Deactivate( vlc_object_t *p_this )
     free( p_filter->p_sys );
 }
 
-#ifndef PLAIN
-VIDEO_FILTER_WRAPPER( I420_R5G5B5 )
-VIDEO_FILTER_WRAPPER( I420_R5G6B5 )
-VIDEO_FILTER_WRAPPER( I420_A8R8G8B8 )
-VIDEO_FILTER_WRAPPER( I420_R8G8B8A8 )
-VIDEO_FILTER_WRAPPER( I420_B8G8R8A8 )
-VIDEO_FILTER_WRAPPER( I420_A8B8G8R8 )
-#else
-VIDEO_FILTER_WRAPPER( I420_RGB8 )
-VIDEO_FILTER_WRAPPER( I420_RGB16 )
-VIDEO_FILTER_WRAPPER( I420_RGB32 )
+typedef struct
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dst;
+} slice_t;
+
+/*****************************************************************************
+ * ConvertSlice: convert a band of lines
+ *****************************************************************************
+ * The conversion functions go through the whole pictures as described by the
+ * filter formats, so they are given the band as pictures of its own.
+ *****************************************************************************/
+static void ConvertSlice( void *opaque, unsigned i_slice,
+                          unsigned i_first, unsigned i_count )
+{
+    const slice_t *p_slice = opaque;
+    filter_t band = *p_slice->p_filter;
+    picture_t src = *p_slice->p_src;
+    picture_t dst = *p_slice->p_dst;
+
+    (void) i_slice;
+    band.fmt_in.video.i_y_offset = band.fmt_out.video.i_y_offset = 0;
+    band.fmt_in.video.i_visible_height = band.fmt_in.video.i_height = i_count;
+    band.fmt_out.video.i_visible_height = band.fmt_out.video.i_height = i_count;
+
+    for( int i = 0; i < src.i_planes; i++ )
+    {
+        /* 4:2:0 chroma planes have half the lines */
+        const unsigned i_shift = i == Y_PLANE ? 0 : 1;
+        src.p[i].p_pixels += (i_first >> i_shift) * src.p[i].i_pitch;
+        src.p[i].i_lines = src.p[i].i_visible_lines = i_count >> i_shift;
+    }
+    dst.p->p_pixels += i_first * dst.p->i_pitch;
+    dst.p->i_lines = dst.p->i_visible_lines = i_count;
+
+    p_slice->p_filter->p_sys->pf_convert( &band, &src, &dst );
+}
+
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_outpic = filter_NewPicture( p_filter );
+
+    if( p_outpic )
+    {
+        if( p_sys->p_slices != NULL )
+        {
+            /* Bands start on a line multiple of 4, for the chroma lines and
+             * the 8 bpp dithering matrix */
+            slice_t slice = { p_filter, p_pic, p_outpic };
+            SlicePoolRun( p_sys->p_slices, p_filter->fmt_in.video.i_y_offset
+                                       + p_filter->fmt_in.video.i_visible_height,
+                          4, ConvertSlice, &slice );
+        }
+        else
+            p_sys->pf_convert( p_filter, p_pic, p_outpic );
+        picture_CopyProperties( p_outpic, p_pic );
+    }
+    picture_Release( p_pic );
+    return p_outpic;
+}
 
+#ifdef PLAIN
 /*****************************************************************************
  * SetGammaTable: return intensity table transformed by gamma curve.
  *****************************************************************************
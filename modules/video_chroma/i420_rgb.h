@@ -39,6 +39,10 @@ struct filter_sys_t
     uint8_t  *p_buffer;
     int *p_offset;
 
+    /**< Conversion function, and threads converting bands of lines */
+    void (*pf_convert)( filter_t *, picture_t *, picture_t * );
+    struct slice_pool_t *p_slices;
+
 #ifdef PLAIN
     /**< Pre-calculated conversion tables */
     void *p_base;                      /**< base for all conversion tables */
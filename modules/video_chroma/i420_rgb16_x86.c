@@ -34,6 +34,7 @@
 #include "i420_rgb.h"
 #ifdef SSE2
 # include "i420_rgb_sse2.h"
+# include "i420_rgb_avx2.h"
 # define VLC_TARGET VLC_SSE
 #else
 # include "i420_rgb_mmx.h"
@@ -609,6 +610,12 @@ void I420_A8R8G8B8( filter_t *p_filter, picture_t *p_src,
                (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height),
                &b_hscale, &i_vscale, p_offset_start );
 
+#if defined (SSE2) && defined (CAN_COMPILE_AVX2_INTRINSICS)
+    if( !b_hscale && i_vscale == 0 && vlc_CPU_AVX2()
+     && AVX2_I420_RGB32( p_filter, p_src, p_dest, AVX2_ORDER_ARGB ) )
+        return;
+#endif
+
     /*
      * Perform conversion
      */
@@ -839,6 +846,12 @@ void I420_R8G8B8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height),
                &b_hscale, &i_vscale, p_offset_start );
 
+#if defined (SSE2) && defined (CAN_COMPILE_AVX2_INTRINSICS)
+    if( !b_hscale && i_vscale == 0 && vlc_CPU_AVX2()
+     && AVX2_I420_RGB32( p_filter, p_src, p_dest, AVX2_ORDER_RGBA ) )
+        return;
+#endif
+
     /*
      * Perform conversion
      */
@@ -1069,6 +1082,12 @@ void I420_B8G8R8A8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height),
                &b_hscale, &i_vscale, p_offset_start );
 
+#if defined (SSE2) && defined (CAN_COMPILE_AVX2_INTRINSICS)
+    if( !b_hscale && i_vscale == 0 && vlc_CPU_AVX2()
+     && AVX2_I420_RGB32( p_filter, p_src, p_dest, AVX2_ORDER_BGRA ) )
+        return;
+#endif
+
     /*
      * Perform conversion
      */
@@ -1296,6 +1315,12 @@ void I420_A8B8G8R8( filter_t *p_filter, picture_t *p_src, picture_t *p_dest )
                (p_filter->fmt_out.video.i_y_offset + p_filter->fmt_out.video.i_visible_height),
                &b_hscale, &i_vscale, p_offset_start );
 
+#if defined (SSE2) && defined (CAN_COMPILE_AVX2_INTRINSICS)
+    if( !b_hscale && i_vscale == 0 && vlc_CPU_AVX2()
+     && AVX2_I420_RGB32( p_filter, p_src, p_dest, AVX2_ORDER_ABGR ) )
+        return;
+#endif
+
     /*
      * Perform conversion
      */
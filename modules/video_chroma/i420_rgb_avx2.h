@@ -0,0 +1,154 @@
+/*****************************************************************************
+ * i420_rgb_avx2.h: AVX2 YUV transformation
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* The same computations as i420_rgb_sse2.h on 32 pixels at once, for the
+ * conversions to 32 bits RGB without scaling. The 256 bits registers are
+ * made of two 128 bits lanes: the first one holds the pixels 0 to 15, the
+ * second one the pixels 16 to 31. */
+
+#if defined(HAVE_SSE2_INTRINSICS) && (defined(__clang__) || VLC_GCC_VERSION(4, 9))
+
+#include <immintrin.h>
+
+#define CAN_COMPILE_AVX2_INTRINSICS 1
+
+/* Byte order in memory of the 32 bits pixels, alpha being 0 */
+enum
+{
+    AVX2_ORDER_ARGB, /* B G R A */
+    AVX2_ORDER_RGBA, /* A B G R */
+    AVX2_ORDER_BGRA, /* A R G B */
+    AVX2_ORDER_ABGR, /* R G B A */
+};
+
+VLC_AVX2
+static inline void AVX2_Convert32( const uint8_t *p_y, const uint8_t *p_u,
+                                   const uint8_t *p_v, uint32_t *p_buffer,
+                                   int i_order )
+{
+    /* Chroma: 16 U and V, one per 16 bits element */
+    __m256i u = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)p_u ) );
+    __m256i v = _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i *)p_v ) );
+    const __m256i c128 = _mm256_set1_epi16( 0x0080 );
+
+    u = _mm256_slli_epi16( _mm256_subs_epi16( u, c128 ), 3 );
+    v = _mm256_slli_epi16( _mm256_subs_epi16( v, c128 ), 3 );
+
+    __m256i cb = _mm256_mulhi_epi16( u, _mm256_set1_epi16( 0x4093 ) );
+    __m256i cr = _mm256_mulhi_epi16( v, _mm256_set1_epi16( 0x3312 ) );
+    __m256i cg = _mm256_adds_epi16(
+        _mm256_mulhi_epi16( u, _mm256_set1_epi16( (short)0xf37d ) ),
+        _mm256_mulhi_epi16( v, _mm256_set1_epi16( (short)0xe5fc ) ) );
+
+    /* Luma: 32 Y, split into the even and odd pixels */
+    __m256i y = _mm256_loadu_si256( (const __m256i *)p_y );
+    y = _mm256_subs_epu8( y, _mm256_set1_epi8( 0x10 ) );
+
+    const __m256i coef_y = _mm256_set1_epi16( 0x253f );
+    __m256i y_even = _mm256_and_si256( y, _mm256_set1_epi16( 0x00ff ) );
+    __m256i y_odd = _mm256_srli_epi16( y, 8 );
+    y_even = _mm256_mulhi_epi16( _mm256_slli_epi16( y_even, 3 ), coef_y );
+    y_odd = _mm256_mulhi_epi16( _mm256_slli_epi16( y_odd, 3 ), coef_y );
+
+    /* Components limited to 0..255, back in the pixels order */
+#define AVX2_COMPONENT( c ) \
+    _mm256_unpacklo_epi8( \
+        _mm256_packus_epi16( _mm256_adds_epi16( c, y_even ), \
+                             _mm256_adds_epi16( c, y_even ) ), \
+        _mm256_packus_epi16( _mm256_adds_epi16( c, y_odd ), \
+                             _mm256_adds_epi16( c, y_odd ) ) )
+    const __m256i b = AVX2_COMPONENT( cb );
+    const __m256i g = AVX2_COMPONENT( cg );
+    const __m256i r = AVX2_COMPONENT( cr );
+#undef AVX2_COMPONENT
+    const __m256i z = _mm256_setzero_si256();
+
+    __m256i p0, p1, p2, p3;
+    switch( i_order )
+    {
+        case AVX2_ORDER_ARGB: p0 = b; p1 = g; p2 = r; p3 = z; break;
+        case AVX2_ORDER_RGBA: p0 = z; p1 = b; p2 = g; p3 = r; break;
+        case AVX2_ORDER_BGRA: p0 = z; p1 = r; p2 = g; p3 = b; break;
+        default:              p0 = r; p1 = g; p2 = b; p3 = z; break;
+    }
+
+    const __m256i lo01 = _mm256_unpacklo_epi8( p0, p1 );
+    const __m256i hi01 = _mm256_unpackhi_epi8( p0, p1 );
+    const __m256i lo23 = _mm256_unpacklo_epi8( p2, p3 );
+    const __m256i hi23 = _mm256_unpackhi_epi8( p2, p3 );
+
+    /* pixels 0-3 and 16-19, 4-7 and 20-23, 8-11 and 24-27, 12-15 and 28-31 */
+    const __m256i q0 = _mm256_unpacklo_epi16( lo01, lo23 );
+    const __m256i q1 = _mm256_unpackhi_epi16( lo01, lo23 );
+    const __m256i q2 = _mm256_unpacklo_epi16( hi01, hi23 );
+    const __m256i q3 = _mm256_unpackhi_epi16( hi01, hi23 );
+
+    _mm256_storeu_si256( (__m256i *)(p_buffer),
+                         _mm256_permute2x128_si256( q0, q1, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 8),
+                         _mm256_permute2x128_si256( q2, q3, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 16),
+                         _mm256_permute2x128_si256( q0, q1, 0x31 ) );
+    _mm256_storeu_si256( (__m256i *)(p_buffer + 24),
+                         _mm256_permute2x128_si256( q2, q3, 0x31 ) );
+}
+
+/*****************************************************************************
+ * AVX2_I420_RGB32: convert a picture without scaling
+ *****************************************************************************
+ * Returns false if the picture is too narrow, the SSE2 code being used then.
+ *****************************************************************************/
+VLC_AVX2
+static inline bool AVX2_I420_RGB32( filter_t *p_filter, picture_t *p_src,
+                                    picture_t *p_dest, int i_order )
+{
+    const unsigned i_width = p_filter->fmt_in.video.i_x_offset
+                           + p_filter->fmt_in.video.i_visible_width;
+    const unsigned i_height = p_filter->fmt_in.video.i_y_offset
+                            + p_filter->fmt_in.video.i_visible_height;
+
+    if( i_width < 32 || (i_width & 1) )
+        return false;
+
+    for( unsigned i_y = 0; i_y < i_height; i_y++ )
+    {
+        const uint8_t *p_y = p_src->Y_PIXELS + i_y * p_src->p[Y_PLANE].i_pitch;
+        const uint8_t *p_u = p_src->U_PIXELS + i_y / 2 * p_src->p[U_PLANE].i_pitch;
+        const uint8_t *p_v = p_src->V_PIXELS + i_y / 2 * p_src->p[V_PLANE].i_pitch;
+        uint32_t *p_pic = (uint32_t *)(p_dest->p->p_pixels
+                                       + i_y * p_dest->p->i_pitch);
+        unsigned i_x;
+
+        for( i_x = 0; i_x + 32 <= i_width; i_x += 32 )
+            AVX2_Convert32( p_y + i_x, p_u + i_x / 2, p_v + i_x / 2,
+                            p_pic + i_x, i_order );
+
+        /* The last pixels are converted again with the previous ones */
+        if( i_x < i_width )
+        {
+            i_x = i_width - 32;
+            AVX2_Convert32( p_y + i_x, p_u + i_x / 2, p_v + i_x / 2,
+                            p_pic + i_x, i_order );
+        }
+    }
+    return true;
+}
+
+#endif
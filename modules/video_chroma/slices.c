@@ -0,0 +1,247 @@
+/*****************************************************************************
+ * slices.c: Slice threading of picture conversions
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <assert.h>
+
+#include "slices.h"
+
+/* Pictures smaller than this are converted by a single thread */
+#define SLICE_MIN_PIXELS (1280 * 720)
+/* Minimum number of lines of a slice */
+#define SLICE_MIN_LINES  64
+
+struct slice_pool_t
+{
+    vlc_object_t *obj;
+    unsigned      i_reserved; /* threads reserved from the CPU budget */
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait_work;
+    vlc_cond_t    wait_done;
+    bool          b_quit;
+
+    /* current job */
+    slice_job_cb_t cb;
+    void         *opaque;
+    unsigned      i_next;     /* next slice to run */
+    unsigned      i_pending;  /* slices not run yet */
+
+    unsigned      i_slices;
+    vlc_thread_t  threads[];  /* i_slices - 1 workers */
+};
+
+/* Runs slices until none is left, with the lock held */
+static void Work(slice_pool_t *pool)
+{
+    while (pool->i_next < pool->i_slices)
+    {
+        const unsigned i_slice = pool->i_next++;
+
+        vlc_mutex_unlock(&pool->lock);
+        pool->cb(pool->opaque, i_slice);
+        vlc_mutex_lock(&pool->lock);
+
+        assert(pool->i_pending > 0);
+        if (--pool->i_pending == 0)
+            vlc_cond_signal(&pool->wait_done);
+    }
+}
+
+static void *Thread(void *data)
+{
+    slice_pool_t *pool = data;
+
+    vlc_mutex_lock(&pool->lock);
+    for (;;)
+    {
+        while (!pool->b_quit && pool->i_next >= pool->i_slices)
+            vlc_cond_wait(&pool->wait_work, &pool->lock);
+        if (pool->b_quit)
+            break;
+        Work(pool);
+    }
+    vlc_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+slice_pool_t *SlicePoolStart(vlc_object_t *obj, unsigned i_slices,
+                             unsigned i_reserved, int i_priority)
+{
+    if (i_slices <= 1)
+        goto error;
+
+    slice_pool_t *pool = malloc(sizeof (*pool)
+                                + (i_slices - 1) * sizeof (vlc_thread_t));
+    if (unlikely(pool == NULL))
+        goto error;
+
+    pool->obj = obj;
+    pool->i_reserved = i_reserved;
+    vlc_mutex_init(&pool->lock);
+    vlc_cond_init(&pool->wait_work);
+    vlc_cond_init(&pool->wait_done);
+    pool->b_quit = false;
+    pool->i_next = pool->i_slices = i_slices;
+    pool->i_pending = 0;
+
+    for (unsigned i = 0; i < i_slices - 1; i++)
+    {
+        if (vlc_clone(&pool->threads[i], Thread, pool, i_priority))
+        {
+            /* Keep the workers already running */
+            vlc_mutex_lock(&pool->lock);
+            pool->i_slices = pool->i_next = i + 1;
+            vlc_mutex_unlock(&pool->lock);
+            break;
+        }
+    }
+    if (pool->i_slices <= 1)
+    {
+        SlicePoolDelete(pool);
+        return NULL;
+    }
+    return pool;
+
+error:
+    if (i_reserved > 0)
+        vlc_ReleaseCPUs(obj, i_reserved);
+    return NULL;
+}
+
+slice_pool_t *SlicePoolNew(vlc_object_t *obj, unsigned width, unsigned height)
+{
+    int i_threads = var_InheritInteger(obj, "chroma-threads");
+    unsigned i_reserved = 0;
+
+    if (i_threads <= 0)
+    {
+        /* Automatic: only for large pictures, within the CPU budget */
+        if ((uint64_t)width * height < SLICE_MIN_PIXELS)
+            return NULL;
+
+        unsigned i_wanted = __MIN(vlc_GetCPUCount(), height / SLICE_MIN_LINES);
+        if (i_wanted <= 1)
+            return NULL;
+        i_threads = i_reserved = vlc_ReserveCPUs(obj, i_wanted);
+    }
+    if ((unsigned)i_threads > height / 2)
+        i_threads = height / 2;
+
+    slice_pool_t *pool = SlicePoolStart(obj, i_threads, i_reserved,
+                                        VLC_THREAD_PRIORITY_VIDEO);
+    if (pool != NULL)
+        msg_Dbg(obj, "converting %ux%u pictures in %u slices",
+                width, height, pool->i_slices);
+    return pool;
+}
+
+void SlicePoolDelete(slice_pool_t *pool)
+{
+    vlc_mutex_lock(&pool->lock);
+    pool->b_quit = true;
+    vlc_cond_broadcast(&pool->wait_work);
+    vlc_mutex_unlock(&pool->lock);
+
+    for (unsigned i = 0; i < pool->i_slices - 1; i++)
+        vlc_join(pool->threads[i], NULL);
+
+    if (pool->i_reserved > 0)
+        vlc_ReleaseCPUs(pool->obj, pool->i_reserved);
+    vlc_cond_destroy(&pool->wait_done);
+    vlc_cond_destroy(&pool->wait_work);
+    vlc_mutex_destroy(&pool->lock);
+    free(pool);
+}
+
+unsigned SlicePoolCount(const slice_pool_t *pool)
+{
+    return pool->i_slices;
+}
+
+void SlicePoolRunJob(slice_pool_t *pool, slice_job_cb_t cb, void *opaque)
+{
+    vlc_mutex_lock(&pool->lock);
+    assert(pool->i_pending == 0);
+    pool->cb = cb;
+    pool->opaque = opaque;
+    pool->i_next = 0;
+    pool->i_pending = pool->i_slices;
+    vlc_cond_broadcast(&pool->wait_work);
+
+    /* The calling thread runs slices too */
+    Work(pool);
+    while (pool->i_pending > 0)
+        vlc_cond_wait(&pool->wait_done, &pool->lock);
+    vlc_mutex_unlock(&pool->lock);
+}
+
+void SlicePoolGetBand(const slice_pool_t *pool, unsigned i_slice,
+                      unsigned i_lines, unsigned i_align,
+                      unsigned *pi_first, unsigned *pi_count)
+{
+    unsigned i_band = (i_lines + pool->i_slices - 1) / pool->i_slices;
+    i_band = (i_band + i_align - 1) / i_align * i_align;
+
+    unsigned i_first = i_slice * i_band;
+    if (i_first > i_lines)
+        i_first = i_lines;
+    *pi_first = i_first;
+    *pi_count = __MIN(i_band, i_lines - i_first);
+}
+
+struct slice_bands
+{
+    const slice_pool_t *pool;
+    unsigned i_lines;
+    unsigned i_align;
+    slice_cb_t cb;
+    void *opaque;
+};
+
+static void RunBand(void *data, unsigned i_slice)
+{
+    const struct slice_bands *bands = data;
+    unsigned i_first, i_count;
+
+    SlicePoolGetBand(bands->pool, i_slice, bands->i_lines, bands->i_align,
+                     &i_first, &i_count);
+    if (i_count > 0)
+        bands->cb(bands->opaque, i_slice, i_first, i_count);
+}
+
+void SlicePoolRun(slice_pool_t *pool, unsigned i_lines, unsigned i_align,
+                  slice_cb_t cb, void *opaque)
+{
+    struct slice_bands bands = {
+        .pool = pool,
+        .i_lines = i_lines,
+        .i_align = i_align > 0 ? i_align : 1,
+        .cb = cb,
+        .opaque = opaque,
+    };
+
+    SlicePoolRunJob(pool, RunBand, &bands);
+}
@@ -0,0 +1,62 @@
+/*****************************************************************************
+ * slices.h: Slice threading of picture conversions
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_VIDEOCHROMA_SLICES_H_
+#define VLC_VIDEOCHROMA_SLICES_H_
+
+typedef struct slice_pool_t slice_pool_t;
+
+/* Runs slice i_slice of the current job */
+typedef void (*slice_job_cb_t)(void *opaque, unsigned i_slice);
+
+/* Converts the lines [i_first, i_first + i_count) of slice i_slice */
+typedef void (*slice_cb_t)(void *opaque, unsigned i_slice,
+                           unsigned i_first, unsigned i_count);
+
+/* Starts the i_slices - 1 threads running slices with the calling thread.
+ * The i_reserved threads reserved with vlc_ReserveCPUs() are released with
+ * the pool, or on failure. Returns NULL if fewer than two slices can be
+ * run. */
+slice_pool_t *SlicePoolStart(vlc_object_t *obj, unsigned i_slices,
+                             unsigned i_reserved, int i_priority);
+
+/* Creates the threads converting pictures of the given size, according to
+ * the "chroma-threads" option. Returns NULL if a single thread is to be
+ * used. */
+slice_pool_t *SlicePoolNew(vlc_object_t *obj, unsigned width, unsigned height);
+void SlicePoolDelete(slice_pool_t *pool);
+
+/* Number of slices, including the one of the calling thread */
+unsigned SlicePoolCount(const slice_pool_t *pool);
+
+/* Runs all the slices in parallel, returning once all of them are done */
+void SlicePoolRunJob(slice_pool_t *pool, slice_job_cb_t cb, void *opaque);
+
+/* Splits i_lines in bands of a multiple of i_align lines, and converts them
+ * in parallel, returning once all of them are done */
+void SlicePoolRun(slice_pool_t *pool, unsigned i_lines, unsigned i_align,
+                  slice_cb_t cb, void *opaque);
+
+/* Gets the band of slice i_slice, as SlicePoolRun() splits the lines */
+void SlicePoolGetBand(const slice_pool_t *pool, unsigned i_slice,
+                      unsigned i_lines, unsigned i_align,
+                      unsigned *pi_first, unsigned *pi_count);
+
+#endif
@@ -44,6 +44,7 @@
 #endif
 
 #include "../codec/avcodec/chroma.h" // Chroma Avutil <-> VLC conversion
+#include "slices.h"
 
 /* Gruikkkkkkkkkk!!!!! */
 #undef AVPALETTE_SIZE
@@ -106,6 +107,11 @@ struct filter_sys_t
     bool b_copy;
     bool b_swap_uvi;
     bool b_swap_uvo;
+
+    /* Threads converting bands of lines, each with its own context */
+    slice_pool_t *p_slices;
+    struct SwsContext **pp_slice_ctx;
+    unsigned i_slice_align;
 };
 
 static picture_t *Filter( filter_t *, picture_t * );
@@ -131,6 +137,9 @@ static int GetParameters( ScalerConfiguration *,
 
 static int GetSwsCpuMask(void);
 
+static void InitSlices( filter_t *, const ScalerConfiguration * );
+static void CleanSlices( filter_sys_t * );
+
 /* SwScaler point resize quality seems really bad, let our scale module do it
  * (change it to true to try) */
 #define ALLOW_YUVP (false)
@@ -436,6 +445,12 @@ static int Init( filter_t *p_filter )
         return VLC_EGENERIC;
     }
 
+    /* Without vertical scaling, the bands of lines can be converted
+     * independently, starting on a line of every plane */
+    if( !cfg.b_has_a && !cfg.b_copy && p_sys->i_extend_factor == 1 &&
+        p_fmti->i_visible_height == p_fmto->i_visible_height )
+        InitSlices( p_filter, &cfg );
+
     if (p_filter->b_allow_fmt_out_change)
     {
         /*
@@ -466,10 +481,79 @@ static int Init( filter_t *p_filter )
     return VLC_SUCCESS;
 }
 
+static void CleanSlices( filter_sys_t *p_sys )
+{
+    if( !p_sys->p_slices )
+        return;
+
+    for( unsigned i = 0; i < SlicePoolCount( p_sys->p_slices ); i++ )
+        if( p_sys->pp_slice_ctx[i] )
+            sws_freeContext( p_sys->pp_slice_ctx[i] );
+    free( p_sys->pp_slice_ctx );
+    SlicePoolDelete( p_sys->p_slices );
+    p_sys->pp_slice_ctx = NULL;
+    p_sys->p_slices = NULL;
+}
+
+static void InitSlices( filter_t *p_filter, const ScalerConfiguration *p_cfg )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const video_format_t *p_fmti = &p_filter->fmt_in.video;
+    const video_format_t *p_fmto = &p_filter->fmt_out.video;
+
+    p_sys->p_slices = SlicePoolNew( VLC_OBJECT(p_filter),
+                                    p_fmto->i_visible_width,
+                                    p_fmto->i_visible_height );
+    if( !p_sys->p_slices )
+        return;
+
+    const unsigned i_count = SlicePoolCount( p_sys->p_slices );
+    p_sys->pp_slice_ctx = calloc( i_count, sizeof(*p_sys->pp_slice_ctx) );
+    if( !p_sys->pp_slice_ctx )
+    {
+        SlicePoolDelete( p_sys->p_slices );
+        p_sys->p_slices = NULL;
+        return;
+    }
+
+    /* Bands start on a line of every plane of both formats */
+    p_sys->i_slice_align = 1;
+    for( unsigned i = 0; i < p_sys->desc_in->plane_count; i++ )
+        p_sys->i_slice_align = __MAX( p_sys->i_slice_align,
+            p_sys->desc_in->p[i].h.den / p_sys->desc_in->p[i].h.num );
+    for( unsigned i = 0; i < p_sys->desc_out->plane_count; i++ )
+        p_sys->i_slice_align = __MAX( p_sys->i_slice_align,
+            p_sys->desc_out->p[i].h.den / p_sys->desc_out->p[i].h.num );
+
+    for( unsigned i = 0; i < i_count; i++ )
+    {
+        unsigned i_first, i_lines;
+
+        SlicePoolGetBand( p_sys->p_slices, i, p_fmti->i_visible_height,
+                          p_sys->i_slice_align, &i_first, &i_lines );
+        if( i_lines == 0 )
+            continue;
+
+        p_sys->pp_slice_ctx[i] =
+            sws_getContext( p_fmti->i_visible_width, i_lines, p_cfg->i_fmti,
+                            p_fmto->i_visible_width, i_lines, p_cfg->i_fmto,
+                            p_cfg->i_sws_flags | p_sys->i_cpu_mask,
+                            p_sys->p_filter, NULL, 0 );
+        if( !p_sys->pp_slice_ctx[i] )
+        {
+            msg_Warn( p_filter, "cannot convert by slices" );
+            CleanSlices( p_sys );
+            return;
+        }
+    }
+}
+
 static void Clean( filter_t *p_filter )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
 
+    CleanSlices( p_sys );
+
     if( p_sys->p_src_e )
         picture_Release( p_sys->p_src_e );
     if( p_sys->p_dst_e )
@@ -499,7 +583,7 @@ static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
                        const vlc_chroma_description_t *desc,
                        const video_format_t *fmt,
                        const picture_t *p_picture, unsigned planes,
-                       bool b_swap_uv )
+                       bool b_swap_uv, unsigned i_first_line )
 {
     unsigned i = 0;
 
@@ -516,8 +600,8 @@ static void GetPixels( uint8_t *pp_pixel[4], int pi_pitch[4],
         pp_pixel[i] = p->p_pixels
             + (((fmt->i_x_offset * desc->p[i].w.num) / desc->p[i].w.den)
                 * p->i_pixel_pitch)
-            + (((fmt->i_y_offset * desc->p[i].h.num) / desc->p[i].h.den)
-                * p->i_pitch);
+            + ((((fmt->i_y_offset + i_first_line) * desc->p[i].h.num)
+                / desc->p[i].h.den) * p->i_pitch);
         pi_pitch[i] = p->i_pitch;
     }
 
@@ -583,7 +667,8 @@ static void SwapUV( picture_t *p_dst, const picture_t *p_src )
 }
 
 static void Convert( filter_t *p_filter, struct SwsContext *ctx,
-                     picture_t *p_dst, picture_t *p_src, int i_height,
+                     picture_t *p_dst, picture_t *p_src,
+                     unsigned i_first, int i_height,
                      int i_plane_count, bool b_swap_uvi, bool b_swap_uvo )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
@@ -592,7 +677,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     uint8_t *dst[4]; int dst_stride[4];
 
     GetPixels( src, src_stride, p_sys->desc_in, &p_filter->fmt_in.video,
-               p_src, i_plane_count, b_swap_uvi );
+               p_src, i_plane_count, b_swap_uvi, i_first );
     if( p_filter->fmt_in.video.i_chroma == VLC_CODEC_RGBP )
     {
         memset( palette, 0, sizeof(palette) );
@@ -604,7 +689,7 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
     }
 
     GetPixels( dst, dst_stride, p_sys->desc_out, &p_filter->fmt_out.video,
-               p_dst, i_plane_count, b_swap_uvo );
+               p_dst, i_plane_count, b_swap_uvo, i_first );
 
 #if LIBSWSCALE_VERSION_INT  >= ((0<<16)+(5<<8)+0)
     sws_scale( ctx, src, src_stride, 0, i_height,
@@ -615,6 +700,26 @@ static void Convert( filter_t *p_filter, struct SwsContext *ctx,
 #endif
 }
 
+typedef struct
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dst;
+    int        i_planes;
+} slice_t;
+
+static void ConvertSlice( void *opaque, unsigned i_slice,
+                          unsigned i_first, unsigned i_count )
+{
+    const slice_t *p_slice = opaque;
+    filter_t *p_filter = p_slice->p_filter;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    Convert( p_filter, p_sys->pp_slice_ctx[i_slice],
+             p_slice->p_dst, p_slice->p_src, i_first, i_count,
+             p_slice->i_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+}
+
 /****************************************************************************
  * Filter: the whole thing
  ****************************************************************************
@@ -662,8 +767,16 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         /* Even if alpha is unused, swscale expects the pointer to be set */
         const int n_planes = !p_sys->ctxA && (p_src->i_planes == 4 ||
                              p_dst->i_planes == 4) ? 4 : 3;
-        Convert( p_filter, p_sys->ctx, p_dst, p_src, p_fmti->i_visible_height,
-                 n_planes, p_sys->b_swap_uvi, p_sys->b_swap_uvo );
+        if( p_sys->p_slices )
+        {
+            slice_t slice = { p_filter, p_src, p_dst, n_planes };
+            SlicePoolRun( p_sys->p_slices, p_fmti->i_visible_height,
+                          p_sys->i_slice_align, ConvertSlice, &slice );
+        }
+        else
+            Convert( p_filter, p_sys->ctx, p_dst, p_src, 0,
+                     p_fmti->i_visible_height, n_planes,
+                     p_sys->b_swap_uvi, p_sys->b_swap_uvo );
     }
     if( p_sys->ctxA )
     {
@@ -676,7 +789,7 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             plane_CopyPixels( p_sys->p_src_a->p, p_src->p+A_PLANE );
 
         Convert( p_filter, p_sys->ctxA, p_sys->p_dst_a, p_sys->p_src_a,
-                 p_fmti->i_visible_height, 1, false, false );
+                 0, p_fmti->i_visible_height, 1, false, false );
         if( p_fmto->i_chroma == VLC_CODEC_RGBA || p_fmto->i_chroma == VLC_CODEC_BGRA )
             InjectA( p_dst, p_sys->p_dst_a, OFFSET_A );
         else if( p_fmto->i_chroma == VLC_CODEC_ARGB )
@@ -35,19 +35,27 @@
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 
+#include "../video_chroma/slices.h"
+
 /****************************************************************************
  * Local prototypes
  ****************************************************************************/
 static int  OpenFilter ( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 static picture_t *Filter( filter_t *, picture_t * );
 
+struct filter_sys_t
+{
+    slice_pool_t *p_slices;
+};
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 vlc_module_begin ()
     set_description( N_("Video scaling filter") )
     set_capability( "video converter", 10 )
-    set_callbacks( OpenFilter, NULL )
+    set_callbacks( OpenFilter, CloseFilter )
 vlc_module_end ()
 
 /*****************************************************************************
@@ -74,6 +82,13 @@ static int OpenFilter( vlc_object_t *p_this )
 
 #warning Converter cannot (really) change output format.
     video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+
+    filter_sys_t *p_sys = malloc( sizeof( *p_sys ) );
+    if( !p_sys )
+        return VLC_ENOMEM;
+    p_sys->p_slices = SlicePoolNew( p_this, p_filter->fmt_out.video.i_width,
+                                    p_filter->fmt_out.video.i_height );
+    p_filter->p_sys = p_sys;
     p_filter->pf_video_filter = Filter;
 
     msg_Dbg( p_filter, "%ix%i -> %ix%i", p_filter->fmt_in.video.i_width,
@@ -83,25 +98,40 @@ static int OpenFilter( vlc_object_t *p_this )
     return VLC_SUCCESS;
 }
 
-/****************************************************************************
- * Filter: the whole thing
- ****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+/*****************************************************************************
+ * CloseFilter: clean up the filter
+ *****************************************************************************/
+static void CloseFilter( vlc_object_t *p_this )
 {
-    picture_t *p_pic_dst;
+    filter_t *p_filter = (filter_t*)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
-    if( !p_pic ) return NULL;
+    if( p_sys->p_slices )
+        SlicePoolDelete( p_sys->p_slices );
+    free( p_sys );
+}
 
-#warning Converter cannot (really) change output format.
-    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+typedef struct
+{
+    filter_t  *p_filter;
+    picture_t *p_src;
+    picture_t *p_dst;
+} slice_t;
 
-    /* Request output picture */
-    p_pic_dst = filter_NewPicture( p_filter );
-    if( !p_pic_dst )
-    {
-        picture_Release( p_pic );
-        return NULL;
-    }
+/****************************************************************************
+ * Scale: scale the lines [i_first, i_first + i_count) of the output, the
+ * planes with less lines being scaled in proportion
+ ****************************************************************************/
+static void Scale( void *opaque, unsigned i_slice,
+                   unsigned i_first, unsigned i_count )
+{
+    const slice_t *p_slice = opaque;
+    filter_t *p_filter = p_slice->p_filter;
+    picture_t *p_pic = p_slice->p_src;
+    picture_t *p_pic_dst = p_slice->p_dst;
+    const int i_lines = p_pic_dst->p[0].i_visible_lines;
+
+    (void) i_slice;
 
     if( p_filter->fmt_in.video.i_chroma != VLC_CODEC_RGBA &&
         p_filter->fmt_in.video.i_chroma != VLC_CODEC_ARGB &&
@@ -128,15 +158,22 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             const int i_src_height_1 = i_src_height - 1;
             const int i_src_width_1  = i_src_width - 1;
 
+            const int i_first_line = i_first * i_dst_visible_lines / i_lines;
+            const int i_end_line = (i_first + i_count) * i_dst_visible_lines
+                                 / i_lines;
+
             uint8_t *p_src = p_pic->p[i_plane].p_pixels;
-            uint8_t *p_dst = p_pic_dst->p[i_plane].p_pixels;
+            uint8_t *p_dst = p_pic_dst->p[i_plane].p_pixels
+                           + i_first_line * i_dst_pitch;
             uint8_t *p_dstendline = p_dst + i_dst_visible_pitch;
-            const uint8_t *p_dstend = p_dst + i_dst_visible_lines*i_dst_pitch;
+            const uint8_t *p_dstend = p_pic_dst->p[i_plane].p_pixels
+                                    + i_end_line * i_dst_pitch;
 
             const int i_shift_height = i_dst_height / i_src_height;
             const int i_shift_width = i_dst_width / i_src_width;
 
-            int l = 1<<(SHIFT_SIZE-i_shift_height);
+            int l = (1<<(SHIFT_SIZE-i_shift_height))
+                  + i_first_line * i_height_coef;
             for( ; p_dst < p_dstend;
                  p_dst += i_dst_hidden_pitch,
                  p_dstendline += i_dst_pitch, l += i_height_coef )
@@ -160,8 +197,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_src_width    = p_filter->fmt_in.video.i_width;
         const int i_dst_height   = p_filter->fmt_out.video.i_height;
         const int i_dst_width    = p_filter->fmt_out.video.i_width;
-        const int i_dst_visible_lines =
-                                   p_pic_dst->p->i_visible_lines;
         const int i_dst_visible_pitch =
                                    p_pic_dst->p->i_visible_pitch;
         const int i_dst_hidden_pitch  = i_dst_pitch - i_dst_visible_pitch;
@@ -173,14 +208,15 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         const int i_src_width_1  = i_src_width - 1;
 
         uint32_t *p_src = (uint32_t*)p_pic->p->p_pixels;
-        uint32_t *p_dst = (uint32_t*)p_pic_dst->p->p_pixels;
+        uint32_t *p_dst = (uint32_t*)p_pic_dst->p->p_pixels
+                        + i_first*(i_dst_pitch>>2);
         uint32_t *p_dstendline = p_dst + (i_dst_visible_pitch>>2);
-        const uint32_t *p_dstend = p_dst + i_dst_visible_lines*(i_dst_pitch>>2);
+        const uint32_t *p_dstend = p_dst + i_count*(i_dst_pitch>>2);
 
         const int i_shift_height = i_dst_height / i_src_height;
         const int i_shift_width = i_dst_width / i_src_width;
 
-        int l = 1<<(SHIFT_SIZE-i_shift_height);
+        int l = (1<<(SHIFT_SIZE-i_shift_height)) + i_first * i_height_coef;
         for( ; p_dst < p_dstend;
              p_dst += (i_dst_hidden_pitch>>2),
              p_dstendline += (i_dst_pitch>>2),
@@ -195,6 +231,35 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
             }
         }
     }
+}
+
+/****************************************************************************
+ * Filter: the whole thing
+ ****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    picture_t *p_pic_dst;
+
+    if( !p_pic ) return NULL;
+
+#warning Converter cannot (really) change output format.
+    video_format_ScaleCropAr( &p_filter->fmt_out.video, &p_filter->fmt_in.video );
+
+    /* Request output picture */
+    p_pic_dst = filter_NewPicture( p_filter );
+    if( !p_pic_dst )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
+
+    slice_t slice = { p_filter, p_pic, p_pic_dst };
+    if( p_sys->p_slices )
+        SlicePoolRun( p_sys->p_slices, p_pic_dst->p[0].i_visible_lines, 1,
+                      Scale, &slice );
+    else
+        Scale( &slice, 0, 0, p_pic_dst->p[0].i_visible_lines );
 
     picture_CopyProperties( p_pic_dst, p_pic );
     picture_Release( p_pic );
@@ -48,6 +48,10 @@
 #define T_PITCH N_("Pitch")
 #define LT_PITCH N_("Video memory buffer pitch in bytes.")
 
+#define T_POOL N_("Buffer pool")
+#define LT_POOL N_("Number of application buffers to render into directly " \
+                   "(0 to copy each picture into the locked buffer).")
+
 #define T_CHROMA N_("Chroma")
 #define LT_CHROMA N_("Output chroma for the memory image as a 4-character " \
                       "string, eg. \"RV32\".")
@@ -71,6 +75,8 @@ vlc_module_begin()
         change_private()
     add_string("vmem-chroma", "RV16", T_CHROMA, LT_CHROMA, true)
         change_private()
+    add_integer("vmem-pool", 0, T_POOL, LT_POOL, true)
+        change_private()
     add_obsolete_string("vmem-lock") /* obsoleted since 1.1.1 */
     add_obsolete_string("vmem-unlock") /* obsoleted since 1.1.1 */
     add_obsolete_string("vmem-data") /* obsoleted since 1.1.1 */
@@ -82,12 +88,16 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 struct picture_sys_t {
+    vout_display_t *vd;
     void *id;
+    void *planes[PICTURE_PLANE_MAX];
 };
 
 /* NOTE: the callback prototypes must match those of LibVLC */
 struct vout_display_sys_t {
     picture_pool_t *pool;
+    unsigned pool_count; /* application buffers, if rendered into directly */
+    picture_t *shown;    /* buffer held for the application */
 
     void *opaque;
     void *pic_opaque;
@@ -134,6 +144,8 @@ static int Open(vlc_object_t *object)
     sys->cleanup = var_InheritAddress(vd, "vmem-cleanup");
     sys->opaque = var_InheritAddress(vd, "vmem-data");
     sys->pool = NULL;
+    sys->pool_count = var_InheritInteger(vd, "vmem-pool");
+    sys->shown = NULL;
 
     /* Define the video format */
     video_format_t fmt;
@@ -147,12 +159,15 @@ static int Open(vlc_object_t *object)
         memset(sys->pitches, 0, sizeof(sys->pitches));
         memset(sys->lines, 0, sizeof(sys->lines));
 
-        if (setup(&sys->opaque, chroma, &fmt.i_width, &fmt.i_height,
-                           sys->pitches, sys->lines) == 0) {
+        unsigned count = setup(&sys->opaque, chroma, &fmt.i_width,
+                               &fmt.i_height, sys->pitches, sys->lines);
+        if (count == 0) {
             msg_Err(vd, "video format setup failure (no pictures)");
             free(sys);
             return VLC_EGENERIC;
         }
+        if (sys->pool_count > 0)
+            sys->pool_count = count;
         fmt.i_chroma = vlc_fourcc_GetCodecFromString(VIDEO_ES, chroma);
 
     } else {
@@ -232,19 +247,134 @@ static void Close(vlc_object_t *object)
     vout_display_t *vd = (vout_display_t *)object;
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->cleanup)
-        sys->cleanup(sys->opaque);
+    if (sys->shown != NULL)
+        picture_Release(sys->shown); /* unlocks the buffer */
     if (sys->pool)
         picture_pool_Release(sys->pool);
+    if (sys->cleanup)
+        sys->cleanup(sys->opaque);
     free(sys);
 }
 
+/* Locks an application buffer, each time a pool picture gets used */
+static int LockDirectPicture(picture_t *pic)
+{
+    picture_sys_t *picsys = pic->p_sys;
+    vout_display_sys_t *sys = picsys->vd->sys;
+
+    memset(picsys->planes, 0, sizeof (picsys->planes));
+    picsys->id = sys->lock(sys->opaque, picsys->planes);
+
+    for (int i = 0; i < pic->i_planes; i++) {
+        if ((uintptr_t)picsys->planes[i] & 31) {
+            msg_Warn(picsys->vd, "buffer plane %d not aligned", i);
+            if (sys->unlock != NULL)
+                sys->unlock(sys->opaque, picsys->id, picsys->planes);
+            return VLC_EGENERIC;
+        }
+        pic->p[i].p_pixels = picsys->planes[i];
+    }
+    return VLC_SUCCESS;
+}
+
+/* Unlocks the application buffer, once the pool picture is released */
+static void UnlockDirectPicture(picture_t *pic)
+{
+    picture_sys_t *picsys = pic->p_sys;
+    vout_display_sys_t *sys = picsys->vd->sys;
+
+    if (sys->unlock != NULL)
+        sys->unlock(sys->opaque, picsys->id, picsys->planes);
+}
+
+/* Allocates a picture for application buffers, if they fit the format */
+static picture_t *NewDirectPicture(vout_display_t *vd)
+{
+    vout_display_sys_t *sys = vd->sys;
+    picture_sys_t *picsys = malloc(sizeof (*picsys));
+    if (unlikely(picsys == NULL))
+        return NULL;
+
+    picsys->vd = vd;
+    picsys->id = NULL;
+    memset(picsys->planes, 0, sizeof (picsys->planes));
+
+    picture_resource_t rsc = { .p_sys = picsys };
+    for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
+        rsc.p[i].i_lines  = sys->lines[i];
+        rsc.p[i].i_pitch  = sys->pitches[i];
+    }
+
+    picture_t *pic = picture_NewFromResource(&vd->fmt, &rsc);
+    if (pic == NULL) {
+        free(picsys);
+        return NULL;
+    }
+
+    for (int i = 0; i < pic->i_planes; i++) {
+        const plane_t *p = &pic->p[i];
+
+        if ((p->i_pitch & 31) || p->i_pitch < p->i_visible_pitch
+         || p->i_lines < p->i_visible_lines) {
+            msg_Warn(vd, "buffer plane %d not aligned or too small", i);
+            picture_Release(pic);
+            return NULL;
+        }
+    }
+    return pic;
+}
+
 static picture_pool_t *Pool(vout_display_t *vd, unsigned count)
 {
     vout_display_sys_t *sys = vd->sys;
 
-    if (sys->pool == NULL)
-        sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
+    if (sys->pool != NULL)
+        return sys->pool;
+
+    /* Render into the application buffers: the pictures are not copied */
+    if (sys->pool_count > 0) {
+        picture_t **pics = malloc(sys->pool_count * sizeof (*pics));
+        unsigned n = 0, locked = 0;
+
+        if (unlikely(pics == NULL))
+            return NULL;
+
+        for (; n < sys->pool_count; n++) {
+            pics[n] = NewDirectPicture(vd);
+            if (pics[n] == NULL)
+                break;
+        }
+
+        /* Check that the application can lend all its buffers at once */
+        if (n == sys->pool_count)
+            while (locked < n && LockDirectPicture(pics[locked]) == VLC_SUCCESS)
+                locked++;
+        for (unsigned i = 0; i < locked; i++)
+            UnlockDirectPicture(pics[i]);
+
+        if (locked == sys->pool_count) {
+            picture_pool_configuration_t cfg = {
+                .picture_count = n,
+                .picture = pics,
+                .lock = LockDirectPicture,
+                .unlock = UnlockDirectPicture,
+            };
+
+            sys->pool = picture_pool_NewExtended(&cfg);
+            if (sys->pool != NULL) {
+                msg_Dbg(vd, "rendering into %u application buffers", n);
+                free(pics);
+                return sys->pool;
+            }
+        }
+        while (n > 0)
+            picture_Release(pics[--n]);
+        free(pics);
+        msg_Warn(vd, "copying the pictures into the application buffers");
+        sys->pool_count = 0;
+    }
+
+    sys->pool = picture_pool_NewFromFormat(&vd->fmt, count);
     return sys->pool;
 }
 
@@ -254,6 +384,9 @@ static void Prepare(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
     picture_resource_t rsc = { .p_sys = NULL };
     void *planes[PICTURE_PLANE_MAX];
 
+    if (pic->p_sys != NULL) /* already in an application buffer */
+        return;
+
     sys->pic_opaque = sys->lock(sys->opaque, planes);
 
     for (unsigned i = 0; i < PICTURE_PLANE_MAX; i++) {
@@ -278,6 +411,17 @@ static void Display(vout_display_t *vd, picture_t *pic, subpicture_t *subpic)
 {
     vout_display_sys_t *sys = vd->sys;
 
+    if (pic->p_sys != NULL) {
+        /* Keep the buffer for the application until the next one is shown */
+        if (sys->display != NULL)
+            sys->display(sys->opaque, pic->p_sys->id);
+        if (sys->shown != NULL)
+            picture_Release(sys->shown); /* unlocks the buffer */
+        sys->shown = pic;
+        VLC_UNUSED(subpic);
+        return;
+    }
+
     if (sys->display != NULL)
         sys->display(sys->opaque, sys->pic_opaque);
 
@@ -79,6 +79,9 @@ struct decoder_owner_sys_t
     sout_packetizer_input_t *p_sout_input;
 
     vlc_thread_t     thread;
+    /* Packetizer run by the input thread, without a thread of its own: the
+     * fifo then only holds the packets while buffering */
+    bool             b_direct;
 
     void (*pf_update_stat)( decoder_owner_sys_t *, unsigned decoded, unsigned lost );
 
@@ -140,6 +143,11 @@ struct decoder_owner_sys_t
 
     /* Delay */
     mtime_t i_ts_delay;
+
+    /* Low delay: latency budget, 0 if disabled */
+    mtime_t i_low_delay;
+    /* DTS of the last block taken from the fifo (fifo lock) */
+    mtime_t i_dequeued_dts;
 };
 
 /* Pictures which are DECODER_BOGUS_VIDEO_DELAY or more in advance probably have
@@ -769,6 +777,14 @@ static int DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
     assert( p_owner->p_clock );
     assert( !p_sout_block->p_next );
 
+    bool b_paused = false;
+    if( p_owner->b_direct )
+    {
+        vlc_fifo_Lock( p_owner->p_fifo );
+        b_paused = p_owner->paused;
+        vlc_fifo_Unlock( p_owner->p_fifo );
+    }
+
     vlc_mutex_lock( &p_owner->lock );
 
     if( p_owner->b_waiting )
@@ -777,7 +793,19 @@ static int DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
         vlc_cond_signal( &p_owner->wait_acknowledge );
     }
 
-    DecoderWaitUnblock( p_dec );
+    if( p_owner->b_direct )
+    {
+        /* The input thread cannot wait for itself: keep the packet until
+         * input_DecoderStopWait() or input_DecoderChangePause() */
+        if( p_owner->b_waiting || b_paused )
+        {
+            block_FifoPut( p_owner->p_fifo, p_sout_block );
+            vlc_mutex_unlock( &p_owner->lock );
+            return VLC_SUCCESS;
+        }
+    }
+    else
+        DecoderWaitUnblock( p_dec );
     DecoderFixTs( p_dec, &p_sout_block->i_dts, &p_sout_block->i_pts,
                   &p_sout_block->i_length, NULL, INT64_MAX );
 
@@ -787,6 +815,34 @@ static int DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
     return sout_InputSendBuffer( p_owner->p_sout_input, p_sout_block );
 }
 
+/* Sends the packets kept while buffering or paused by a direct packetizer */
+static void DecoderPlaySoutHeld( decoder_t *p_dec )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    block_t *p_chain;
+
+    vlc_fifo_Lock( p_owner->p_fifo );
+    p_chain = vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo );
+    vlc_fifo_Unlock( p_owner->p_fifo );
+
+    while( p_chain != NULL )
+    {
+        block_t *p_next = p_chain->p_next;
+
+        p_chain->p_next = NULL;
+        if( p_owner->error
+         || DecoderPlaySout( p_dec, p_chain ) == VLC_EGENERIC )
+        {
+            if( !p_owner->error )
+                msg_Err( p_dec, "cannot continue streaming due to errors" );
+            p_owner->error = true;
+            block_ChainRelease( p_next );
+            break;
+        }
+        p_chain = p_next;
+    }
+}
+
 /* This function process a block for sout
  */
 static void DecoderProcessSout( decoder_t *p_dec, block_t *p_block )
@@ -982,6 +1038,9 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     /* FIXME: The *input* FIFO should not be locked here. This will not work
      * properly if/when pictures are queued asynchronously. */
     vlc_fifo_Lock( p_owner->p_fifo );
+    /* The pictures shown while paused or stepping frame by frame are not
+     * late, whatever the clock says */
+    const bool b_paused = p_owner->paused;
     if( unlikely(p_owner->paused) && likely(p_owner->frames_countdown > 0) )
         p_owner->frames_countdown--;
     vlc_fifo_Unlock( p_owner->p_fifo );
@@ -990,6 +1049,10 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
     if( p_vout == NULL )
         goto discard;
 
+    if( p_owner->i_low_delay > 0 && !p_picture->b_force && !b_paused
+     && p_picture->date > VLC_TS_INVALID && p_picture->date < mdate() )
+        goto discard; /* too late for the latency budget */
+
     if( p_picture->b_force || p_picture->date > VLC_TS_INVALID )
         /* FIXME: VLC_TS_INVALID -- verify video_output */
     {
@@ -999,6 +1062,12 @@ static int DecoderPlayVideo( decoder_t *p_dec, picture_t *p_picture,
             vout_Flush( p_vout, p_picture->date );
             p_owner->i_last_rate = i_rate;
         }
+        if( p_owner->p_input != NULL )
+        {
+            mtime_t i_delay = p_picture->date - mdate();
+            stats_Update( input_priv(p_owner->p_input)->counters.p_display_latency,
+                          __MAX( i_delay, 0 ), NULL );
+        }
         vout_PutPicture( p_vout, p_picture );
     }
     else
@@ -1035,11 +1104,9 @@ static void DecoderUpdateStatVideo( decoder_owner_sys_t *p_owner,
         lost += vout_lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
     stats_Update( input_priv(p_input)->counters.p_decoded_video, decoded, NULL );
     stats_Update( input_priv(p_input)->counters.p_lost_pictures, lost , NULL);
     stats_Update( input_priv(p_input)->counters.p_displayed_pictures, displayed, NULL);
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
 }
 
 static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic,
@@ -1109,8 +1176,11 @@ static int DecoderPlayAudio( decoder_t *p_dec, block_t *p_audio,
     vlc_mutex_unlock( &p_owner->lock );
 
     audio_output_t *p_aout = p_owner->p_aout;
+    /* Too late for the latency budget */
+    const bool b_late = p_owner->i_low_delay > 0
+                     && p_audio->i_pts + p_audio->i_length < mdate();
 
-    if( p_aout != NULL && p_audio->i_pts > VLC_TS_INVALID
+    if( p_aout != NULL && p_audio->i_pts > VLC_TS_INVALID && !b_late
      && i_rate >= INPUT_RATE_DEFAULT/AOUT_MAX_INPUT_RATE
      && i_rate <= INPUT_RATE_DEFAULT*AOUT_MAX_INPUT_RATE
      && !DecoderTimedWait( p_dec, p_audio->i_pts - AOUT_MAX_PREPARE_TIME ) )
@@ -1156,11 +1226,9 @@ static void DecoderUpdateStatAudio( decoder_owner_sys_t *p_owner,
         lost += aout_lost;
     }
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
     stats_Update( input_priv(p_input)->counters.p_lost_abuffers, lost, NULL );
     stats_Update( input_priv(p_input)->counters.p_played_abuffers, played, NULL );
     stats_Update( input_priv(p_input)->counters.p_decoded_audio, decoded, NULL );
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
 }
 
 static int DecoderQueueAudio( decoder_t *p_dec, block_t *p_aout_buf )
@@ -1226,9 +1294,7 @@ static int DecoderQueueSpu( decoder_t *p_dec, subpicture_t *p_spu )
 
     if( p_input != NULL )
     {
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
         stats_Update( input_priv(p_input)->counters.p_decoded_sub, 1, NULL );
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
     }
 
     int i_ret = -1;
@@ -1264,8 +1330,13 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block );
 static void DecoderDecode( decoder_t *p_dec, block_t *p_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
+    const mtime_t i_start = mdate();
 
     int ret = p_dec->pf_decode( p_dec, p_block );
+
+    if( p_owner->p_input != NULL && p_dec->fmt_in.i_cat != SPU_ES )
+        stats_Update( input_priv(p_owner->p_input)->counters.p_decode_latency,
+                      mdate() - i_start, NULL );
     switch( ret )
     {
         case VLCDEC_SUCCESS:
@@ -1515,6 +1586,8 @@ static void *DecoderThread( void *p_data )
         vlc_testcancel(); /* forced expedited cancellation in case of stop */
 
         block_t *p_block = vlc_fifo_DequeueUnlocked( p_owner->p_fifo );
+        if( p_block != NULL && p_block->i_dts > VLC_TS_INVALID )
+            p_owner->i_dequeued_dts = p_block->i_dts;
         if( p_block == NULL )
         {
             if( likely(!p_owner->b_draining) )
@@ -1595,6 +1668,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
     p_owner->p_packetizer = NULL;
+    p_owner->b_direct = false;
 
     p_owner->b_fmt_description = false;
     p_owner->p_description = NULL;
@@ -1719,6 +1793,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
         p_owner->cc.pp_decoder[i] = NULL;
     }
     p_owner->i_ts_delay = 0;
+    p_owner->i_low_delay = INT64_C(1000) * var_InheritInteger( p_dec, "low-delay" );
+    p_owner->i_dequeued_dts = VLC_TS_INVALID;
     return p_dec;
 }
 
@@ -1852,6 +1928,17 @@ static decoder_t *decoder_New( vlc_object_t *p_parent, input_thread_t *p_input,
     p_dec->p_owner->p_clock = p_clock;
     assert( p_dec->fmt_out.i_cat != UNKNOWN_ES );
 
+#ifdef ENABLE_SOUT
+    /* Remuxed ES: packetize and send to the stream output straight from the
+     * input thread */
+    if( p_sout != NULL && p_input != NULL
+     && var_InheritBool( p_input, "sout-direct" ) )
+    {
+        p_dec->p_owner->b_direct = true;
+        return p_dec;
+    }
+#endif
+
     if( p_dec->fmt_out.i_cat == AUDIO_ES )
         i_priority = VLC_THREAD_PRIORITY_AUDIO;
     else
@@ -1905,6 +1992,12 @@ void input_DecoderDelete( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    if( p_owner->b_direct )
+    {
+        DeleteDecoder( p_dec );
+        return;
+    }
+
     vlc_cancel( p_owner->thread );
 
     vlc_fifo_Lock( p_owner->p_fifo );
@@ -1953,7 +2046,36 @@ void input_DecoderDecode( decoder_t *p_dec, block_t *p_block, bool b_do_pace )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    if( p_owner->b_direct )
+    {
+        DecoderProcess( p_dec, p_block );
+        return;
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
+
+    /* The stream duration queued in front of the block is the time it
+     * waits in the fifo, as long as the decoder keeps up */
+    mtime_t i_queued = 0;
+    if( vlc_fifo_GetCount( p_owner->p_fifo ) > 0
+     && p_block->i_dts > VLC_TS_INVALID
+     && p_owner->i_dequeued_dts > VLC_TS_INVALID )
+        i_queued = __MAX( p_block->i_dts - p_owner->i_dequeued_dts, 0 );
+
+    if( p_owner->p_input != NULL )
+        stats_Update( input_priv(p_owner->p_input)->counters.p_queue_latency,
+                      i_queued, NULL );
+
+    /* A live input cannot wait for the decoder: its queued data is late */
+    if( !b_do_pace && !p_owner->b_waiting && p_owner->i_low_delay > 0
+     && i_queued > p_owner->i_low_delay && p_owner->p_input != NULL
+     && !input_priv(p_owner->p_input)->b_can_pace_control )
+    {
+        msg_Warn( p_dec, "decoder late by more than the latency budget "
+                  "(%"PRId64" ms queued), resetting fifo!", i_queued / 1000 );
+        block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    }
+
     if( !b_do_pace )
     {
         /* FIXME: ideally we would check the time amount of data
@@ -2019,6 +2141,13 @@ void input_DecoderDrain( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    if( p_owner->b_direct )
+    {
+        DecoderProcess( p_dec, NULL );
+        atomic_store( &p_owner->drained, true );
+        return;
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
     p_owner->b_draining = true;
     vlc_fifo_Signal( p_owner->p_fifo );
@@ -2033,10 +2162,20 @@ void input_DecoderFlush( decoder_t *p_dec )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
 
+    if( p_owner->b_direct )
+    {
+        vlc_fifo_Lock( p_owner->p_fifo );
+        block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+        vlc_fifo_Unlock( p_owner->p_fifo );
+        DecoderProcessFlush( p_dec );
+        return;
+    }
+
     vlc_fifo_Lock( p_owner->p_fifo );
 
     /* Empty the fifo */
     block_ChainRelease( vlc_fifo_DequeueAllUnlocked( p_owner->p_fifo ) );
+    p_owner->i_dequeued_dts = VLC_TS_INVALID;
 
     /* Don't need to wait for the DecoderThread to flush. Indeed, if called a
      * second time, this function will clear the FIFO again before anything was
@@ -2151,6 +2290,11 @@ void input_DecoderChangePause( decoder_t *p_dec, bool b_paused, mtime_t i_date )
     p_owner->frames_countdown = 0;
     vlc_fifo_Signal( p_owner->p_fifo );
     vlc_fifo_Unlock( p_owner->p_fifo );
+
+#ifdef ENABLE_SOUT
+    if( p_owner->b_direct && !b_paused )
+        DecoderPlaySoutHeld( p_dec );
+#endif
 }
 
 void input_DecoderChangeDelay( decoder_t *p_dec, mtime_t i_delay )
@@ -2186,6 +2330,11 @@ void input_DecoderStopWait( decoder_t *p_dec )
     p_owner->b_waiting = false;
     vlc_cond_signal( &p_owner->wait_request );
     vlc_mutex_unlock( &p_owner->lock );
+
+#ifdef ENABLE_SOUT
+    if( p_owner->b_direct )
+        DecoderPlaySoutHeld( p_dec );
+#endif
 }
 
 void input_DecoderWait( decoder_t *p_dec )
@@ -2194,6 +2343,10 @@ void input_DecoderWait( decoder_t *p_dec )
 
     assert( p_owner->b_waiting );
 
+    /* The packets were already processed by the input thread */
+    if( p_owner->b_direct )
+        return;
+
     vlc_mutex_lock( &p_owner->lock );
     while( !p_owner->b_has_data )
     {
@@ -1969,7 +1969,6 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
     {
         uint64_t i_total;
 
-        vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock );
         stats_Update( input_priv(p_input)->counters.p_demux_read,
                       p_block->i_buffer, &i_total );
         stats_Update( input_priv(p_input)->counters.p_demux_bitrate, i_total, NULL );
@@ -1984,7 +1983,6 @@ static int EsOutSend( es_out_t *out, es_out_id_t *es, block_t *p_block )
         {
             stats_Update( input_priv(p_input)->counters.p_demux_discontinuity, 1, NULL );
         }
-        vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock );
     }
 
     vlc_mutex_lock( &p_sys->lock );
@@ -2403,9 +2401,14 @@ static int EsOutControlLocked( es_out_t *out, int i_query, va_list args )
                 const mtime_t i_pts_delay_base = p_sys->i_pts_delay - p_sys->i_pts_jitter;
                 mtime_t i_pts_delay = input_clock_GetJitter( p_pgrm->p_clock );
 
-                /* Avoid dangerously high value */
+                /* Avoid dangerously high value, and stay within the latency
+                 * budget */
                 const mtime_t i_jitter_max = INT64_C(1000) * var_InheritInteger( p_sys->p_input, "clock-jitter" );
-                if( i_pts_delay > __MIN( i_pts_delay_base + i_jitter_max, INPUT_PTS_DELAY_MAX ) )
+                const mtime_t i_low_delay = INT64_C(1000) * var_InheritInteger( p_sys->p_input, "low-delay" );
+                mtime_t i_pts_delay_max = __MIN( i_pts_delay_base + i_jitter_max, INPUT_PTS_DELAY_MAX );
+                if( i_low_delay > 0 && i_pts_delay_max > i_low_delay )
+                    i_pts_delay_max = i_low_delay;
+                if( i_pts_delay > i_pts_delay_max )
                 {
                     msg_Err( p_sys->p_input,
                              "ES_OUT_SET_(GROUP_)PCR  is called too late (jitter of %d ms ignored)",
@@ -60,6 +60,7 @@
  *****************************************************************************/
 static  void *Run( void * );
 static  void *Preparse( void * );
+static mtime_t RunStep( void * );
 
 static input_thread_t * Create  ( vlc_object_t *, input_item_t *,
                                   const char *, bool, input_resource_t * );
@@ -176,6 +177,19 @@ int input_Start( input_thread_t *p_input )
         func = Preparse;
 
     assert( !priv->is_running );
+
+    /* Let the pool threads run the input */
+    if( !priv->b_preparsing && var_InheritBool( p_input, "input-pooled" ) )
+    {
+        priv->pool = input_pool_Get( p_input->obj.libvlc );
+        if( priv->pool != NULL )
+        {
+            priv->is_pooled = priv->is_running = true;
+            input_pool_Start( priv->pool, &priv->pool_task, RunStep, priv );
+            return VLC_SUCCESS;
+        }
+    }
+
     /* Create thread and wait for its readiness. */
     priv->is_running = !vlc_clone( &priv->thread, func, priv,
                                    VLC_THREAD_PRIORITY_INPUT );
@@ -209,6 +223,8 @@ void input_Stop( input_thread_t *p_input )
     vlc_cond_signal( &sys->wait_control );
     vlc_mutex_unlock( &sys->lock_control );
     vlc_interrupt_kill( &sys->interrupt );
+    if( sys->is_pooled )
+        input_pool_Wake( sys->pool, &sys->pool_task );
 }
 
 /**
@@ -218,9 +234,13 @@ void input_Stop( input_thread_t *p_input )
  */
 void input_Close( input_thread_t *p_input )
 {
-    if( input_priv(p_input)->is_running )
-        vlc_join( input_priv(p_input)->thread, NULL );
-    vlc_interrupt_deinit( &input_priv(p_input)->interrupt );
+    input_thread_private_t *priv = input_priv(p_input);
+
+    if( priv->is_pooled )
+        input_pool_Wait( priv->pool, &priv->pool_task );
+    else if( priv->is_running )
+        vlc_join( priv->thread, NULL );
+    vlc_interrupt_deinit( &priv->interrupt );
     vlc_object_release( p_input );
 }
 
@@ -247,7 +267,6 @@ static void input_Destructor( vlc_object_t *obj )
 
     vlc_gc_decref( priv->p_item );
 
-    vlc_mutex_destroy( &priv->counters.counters_lock );
 
     for( int i = 0; i < priv->i_control; i++ )
     {
@@ -311,6 +330,8 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
     priv->i_title_offset = input_priv(p_input)->i_seekpoint_offset = 0;
     priv->i_state = INIT_S;
     priv->is_running = false;
+    priv->is_pooled = false;
+    priv->is_pool_init = false;
     priv->is_stopped = false;
     priv->b_recording = false;
     priv->i_rate = INPUT_RATE_DEFAULT;
@@ -460,7 +481,6 @@ static input_thread_t *Create( vlc_object_t *p_parent, input_item_t *p_item,
 
     /* */
     memset( &priv->counters, 0, sizeof( priv->counters ) );
-    vlc_mutex_init( &priv->counters.counters_lock );
 
     priv->p_es_out_display = input_EsOutNew( p_input, priv->i_rate );
     priv->p_es_out = NULL;
@@ -667,131 +687,213 @@ static void MainLoopStatistics( input_thread_t *p_input )
 }
 
 /**
- * MainLoop
- * The main input loop.
+ * MainLoopStart
+ * Initializes the state of the main input loop.
  */
-static void MainLoop( input_thread_t *p_input, bool b_interactive )
+static void MainLoopStart( input_thread_t *p_input, input_loop_t *loop,
+                           bool b_interactive )
 {
-    mtime_t i_intf_update = 0;
-    mtime_t i_last_seek_mdate = 0;
+    loop->b_interactive = b_interactive;
+    loop->i_intf_update = 0;
+    loop->i_last_seek_mdate = 0;
+    loop->i_wakeup = -1;
 
     if( b_interactive && var_InheritBool( p_input, "start-paused" ) )
         ControlPause( p_input, mdate() );
 
-    bool b_pause_after_eof = b_interactive &&
-                           var_InheritBool( p_input, "play-and-pause" );
-    bool b_paused_at_eof = false;
+    loop->b_pause_after_eof = b_interactive &&
+                              var_InheritBool( p_input, "play-and-pause" );
+    loop->b_paused_at_eof = false;
 
     demux_t *p_demux = input_priv(p_input)->master->p_demux;
-    const bool b_can_demux = p_demux->pf_demux != NULL;
+    loop->b_can_demux = p_demux->pf_demux != NULL;
+}
 
-    while( !input_Stopped( p_input ) && input_priv(p_input)->i_state != ERROR_S )
+/**
+ * MainLoopDemuxStep
+ * Demuxes once, and updates the interface and statistics.
+ * Returns false if the input is over.
+ */
+static bool MainLoopDemuxStep( input_thread_t *p_input, input_loop_t *loop )
+{
+    bool b_paused = input_priv(p_input)->i_state == PAUSE_S;
+
+    loop->i_wakeup = -1;
+    /* FIXME if input_priv(p_input)->i_state == PAUSE_S the access/access_demux
+     * is paused -> this may cause problem with some of them
+     * The same problem can be seen when seeking while paused */
+    if( b_paused )
+        b_paused = !es_out_GetBuffering( input_priv(p_input)->p_es_out )
+                || input_priv(p_input)->master->b_eof;
+
+    if( b_paused )
+        return true;
+
+    if( !input_priv(p_input)->master->b_eof )
     {
-        mtime_t i_wakeup = -1;
-        bool b_paused = input_priv(p_input)->i_state == PAUSE_S;
-        /* FIXME if input_priv(p_input)->i_state == PAUSE_S the access/access_demux
-         * is paused -> this may cause problem with some of them
-         * The same problem can be seen when seeking while paused */
-        if( b_paused )
-            b_paused = !es_out_GetBuffering( input_priv(p_input)->p_es_out )
-                    || input_priv(p_input)->master->b_eof;
+        bool b_force_update = false;
 
-        if( !b_paused )
-        {
-            if( !input_priv(p_input)->master->b_eof )
-            {
-                bool b_force_update = false;
+        MainLoopDemux( p_input, &b_force_update );
 
-                MainLoopDemux( p_input, &b_force_update );
+        if( loop->b_can_demux )
+            loop->i_wakeup = es_out_GetWakeup( input_priv(p_input)->p_es_out );
+        if( b_force_update )
+            loop->i_intf_update = 0;
 
-                if( b_can_demux )
-                    i_wakeup = es_out_GetWakeup( input_priv(p_input)->p_es_out );
-                if( b_force_update )
-                    i_intf_update = 0;
+        loop->b_paused_at_eof = false;
+    }
+    else if( !es_out_GetEmpty( input_priv(p_input)->p_es_out ) )
+    {
+        msg_Dbg( p_input, "waiting decoder fifos to empty" );
+        loop->i_wakeup = mdate() + INPUT_IDLE_SLEEP;
+    }
+    /* Pause after eof only if the input is pausable.
+     * This way we won't trigger timeshifting for nothing */
+    else if( loop->b_pause_after_eof && input_priv(p_input)->b_can_pause )
+    {
+        if( loop->b_paused_at_eof )
+            return false;
 
-                b_paused_at_eof = false;
-            }
-            else if( !es_out_GetEmpty( input_priv(p_input)->p_es_out ) )
-            {
-                msg_Dbg( p_input, "waiting decoder fifos to empty" );
-                i_wakeup = mdate() + INPUT_IDLE_SLEEP;
-            }
-            /* Pause after eof only if the input is pausable.
-             * This way we won't trigger timeshifting for nothing */
-            else if( b_pause_after_eof && input_priv(p_input)->b_can_pause )
-            {
-                if( b_paused_at_eof )
-                    break;
+        vlc_value_t val = { .i_int = PAUSE_S };
 
-                vlc_value_t val = { .i_int = PAUSE_S };
+        msg_Dbg( p_input, "pausing at EOF (pause after each)");
+        Control( p_input, INPUT_CONTROL_SET_STATE, val );
 
-                msg_Dbg( p_input, "pausing at EOF (pause after each)");
-                Control( p_input, INPUT_CONTROL_SET_STATE, val );
+        loop->b_paused_at_eof = true;
+    }
+    else
+    {
+        if( MainLoopTryRepeat( p_input ) )
+            return false;
+    }
 
-                b_paused = true;
-                b_paused_at_eof = true;
-            }
-            else
-            {
-                if( MainLoopTryRepeat( p_input ) )
-                    break;
-            }
+    /* Update interface and statistics */
+    mtime_t now = mdate();
+    if( now >= loop->i_intf_update )
+    {
+        MainLoopStatistics( p_input );
+        loop->i_intf_update = now + INT64_C(250000);
+    }
+    return true;
+}
+
+/**
+ * MainLoopControl
+ * Handles the pending controls. If b_wait is true, it waits for controls
+ * until the next demux date, otherwise it returns that date immediately
+ * (negative if the input waits for a control).
+ */
+static mtime_t MainLoopControl( input_thread_t *p_input, input_loop_t *loop,
+                                bool b_wait )
+{
+    for( ;; )
+    {
+        mtime_t i_deadline = loop->i_wakeup;
 
-            /* Update interface and statistics */
+        /* Postpone seeking until ES buffering is complete or at most
+         * 125 ms. */
+        bool b_postpone = es_out_GetBuffering( input_priv(p_input)->p_es_out )
+                        && !input_priv(p_input)->master->b_eof;
+        if( b_postpone )
+        {
             mtime_t now = mdate();
-            if( now >= i_intf_update )
-            {
-                MainLoopStatistics( p_input );
-                i_intf_update = now + INT64_C(250000);
-            }
+
+            /* Recheck ES buffer level every 20 ms when seeking */
+            if( now < loop->i_last_seek_mdate + INT64_C(125000)
+             && (i_deadline < 0 || i_deadline > now + INT64_C(20000)) )
+                i_deadline = now + INT64_C(20000);
+            else
+                b_postpone = false;
         }
 
-        /* Handle control */
-        for( ;; )
+        int i_type;
+        vlc_value_t val;
+
+        if( ControlPop( p_input, &i_type, &val, b_wait ? i_deadline : 0,
+                        b_postpone ) )
         {
-            mtime_t i_deadline = i_wakeup;
+            if( b_postpone && b_wait )
+                continue;
+            return i_deadline; /* Wake-up time reached */
+        }
 
-            /* Postpone seeking until ES buffering is complete or at most
-             * 125 ms. */
-            bool b_postpone = es_out_GetBuffering( input_priv(p_input)->p_es_out )
-                            && !input_priv(p_input)->master->b_eof;
-            if( b_postpone )
-            {
-                mtime_t now = mdate();
+#ifndef NDEBUG
+        msg_Dbg( p_input, "control type=%d", i_type );
+#endif
+        if( Control( p_input, i_type, val ) )
+        {
+            if( ControlIsSeekRequest( i_type ) )
+                loop->i_last_seek_mdate = mdate();
+            loop->i_intf_update = 0;
+        }
 
-                /* Recheck ES buffer level every 20 ms when seeking */
-                if( now < i_last_seek_mdate + INT64_C(125000)
-                 && (i_deadline < 0 || i_deadline > now + INT64_C(20000)) )
-                    i_deadline = now + INT64_C(20000);
-                else
-                    b_postpone = false;
-            }
+        /* Update the wakeup time */
+        if( loop->i_wakeup != 0 )
+            loop->i_wakeup = es_out_GetWakeup( input_priv(p_input)->p_es_out );
+    }
+}
 
-            int i_type;
-            vlc_value_t val;
+/**
+ * MainLoop
+ * The main input loop.
+ */
+static void MainLoop( input_thread_t *p_input, bool b_interactive )
+{
+    input_loop_t loop;
 
-            if( ControlPop( p_input, &i_type, &val, i_deadline, b_postpone ) )
-            {
-                if( b_postpone )
-                    continue;
-                break; /* Wake-up time reached */
-            }
+    MainLoopStart( p_input, &loop, b_interactive );
 
-#ifndef NDEBUG
-            msg_Dbg( p_input, "control type=%d", i_type );
-#endif
-            if( Control( p_input, i_type, val ) )
-            {
-                if( ControlIsSeekRequest( i_type ) )
-                    i_last_seek_mdate = mdate();
-                i_intf_update = 0;
-            }
+    while( !input_Stopped( p_input ) && input_priv(p_input)->i_state != ERROR_S )
+    {
+        if( !MainLoopDemuxStep( p_input, &loop ) )
+            break;
 
-            /* Update the wakeup time */
-            if( i_wakeup != 0 )
-                i_wakeup = es_out_GetWakeup( input_priv(p_input)->p_es_out );
+        /* Handle control */
+        MainLoopControl( p_input, &loop, true );
+    }
+}
+
+/**
+ * RunStep
+ * Runs one step of a pooled input, from one of the pool threads.
+ * Returns the date of the next step, INPUT_POOL_IDLE to wait for a control,
+ * or INPUT_POOL_DONE once the input is over.
+ */
+static mtime_t RunStep( void *data )
+{
+    input_thread_private_t *priv = data;
+    input_thread_t *p_input = &priv->input;
+    vlc_interrupt_t *oldctx = vlc_interrupt_set( &priv->interrupt );
+    mtime_t i_next;
+
+    if( !priv->is_pool_init )
+    {
+        if( Init( p_input ) )
+        {
+            input_SendEventDead( p_input );
+            i_next = INPUT_POOL_DONE;
+            goto out;
         }
+        MainLoopStart( p_input, &priv->pool_loop, true );
+        priv->is_pool_init = true;
+    }
+
+    if( input_Stopped( p_input ) || priv->i_state == ERROR_S
+     || !MainLoopDemuxStep( p_input, &priv->pool_loop ) )
+    {
+        End( p_input );
+        input_SendEventDead( p_input );
+        i_next = INPUT_POOL_DONE;
+    }
+    else
+    {
+        i_next = MainLoopControl( p_input, &priv->pool_loop, false );
+        if( i_next < 0 )
+            i_next = INPUT_POOL_IDLE; /* waiting for a control */
     }
+out:
+    vlc_interrupt_set( oldctx );
+    return i_next;
 }
 
 static void InitStatistics( input_thread_t *p_input )
@@ -819,6 +921,9 @@ static void InitStatistics( input_thread_t *p_input )
         INIT_COUNTER( decoded_audio, COUNTER );
         INIT_COUNTER( decoded_video, COUNTER );
         INIT_COUNTER( decoded_sub, COUNTER );
+        INIT_COUNTER( queue_latency, HISTOGRAM );
+        INIT_COUNTER( decode_latency, HISTOGRAM );
+        INIT_COUNTER( display_latency, HISTOGRAM );
         priv->counters.p_sout_send_bitrate = NULL;
         priv->counters.p_sout_sent_packets = NULL;
         priv->counters.p_sout_sent_bytes = NULL;
@@ -1198,6 +1303,11 @@ static void UpdatePtsDelay( input_thread_t *p_input )
     if( i_pts_delay < 0 )
         i_pts_delay = 0;
 
+    /* Keep the caching within the latency budget */
+    const mtime_t i_low_delay = INT64_C(1000) * var_InheritInteger( p_input, "low-delay" );
+    if( i_low_delay > 0 && i_pts_delay > i_low_delay )
+        i_pts_delay = i_low_delay;
+
     /* Take care of audio/spu delay */
     const mtime_t i_audio_delay = var_GetInteger( p_input, "audio-delay" );
     const mtime_t i_spu_delay   = var_GetInteger( p_input, "spu-delay" );
@@ -1406,6 +1516,9 @@ error:
         EXIT_COUNTER( decoded_audio );
         EXIT_COUNTER( decoded_video );
         EXIT_COUNTER( decoded_sub );
+        EXIT_COUNTER( queue_latency );
+        EXIT_COUNTER( decode_latency );
+        EXIT_COUNTER( display_latency );
 
         if( input_priv(p_input)->p_sout )
         {
@@ -1482,6 +1595,9 @@ do { \
             CL_CO( decoded_audio) ;
             CL_CO( decoded_video );
             CL_CO( decoded_sub) ;
+            CL_CO( queue_latency );
+            CL_CO( decode_latency );
+            CL_CO( display_latency );
         }
 
         /* Close optional stream output instance */
@@ -1547,6 +1663,9 @@ void input_ControlPush( input_thread_t *p_input,
         vlc_cond_signal( &sys->wait_control );
     }
     vlc_mutex_unlock( &sys->lock_control );
+
+    if( sys->is_pooled )
+        input_pool_Wake( sys->pool, &sys->pool_task );
 }
 
 static int ControlGetReducedIndexLocked( input_thread_t *p_input )
@@ -3211,7 +3330,6 @@ void input_UpdateStatistic( input_thread_t *p_input,
 {
     assert( input_priv(p_input)->i_state != INIT_S );
 
-    vlc_mutex_lock( &input_priv(p_input)->counters.counters_lock);
     switch( i_type )
     {
 #define I(c) stats_Update( input_priv(p_input)->counters.c, i_delta, NULL )
@@ -3240,7 +3358,6 @@ void input_UpdateStatistic( input_thread_t *p_input,
         msg_Err( p_input, "Invalid statistic type %d (internal error)", i_type );
         break;
     }
-    vlc_mutex_unlock( &input_priv(p_input)->counters.counters_lock);
 }
 
 /**/
@@ -69,6 +69,13 @@ void input_resource_TerminateSout( input_resource_t *p_resource );
  */
 bool input_resource_HasVout( input_resource_t *p_resource );
 
+/* pool.c */
+
+/**
+ * Stops the threads running the pooled inputs, once all of them are closed.
+ */
+void input_pool_Delete( struct input_pool_t * );
+
 /* input.c */
 
 /* */
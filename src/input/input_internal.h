@@ -82,6 +82,33 @@ typedef struct
 } input_control_t;
 
 /** Private input fields */
+/* A task run by the input pool threads */
+typedef struct input_pool_task_t
+{
+    struct input_pool_task_t *p_next;
+    mtime_t (*pf_run)( void * ); /* returns the date of the next run */
+    void    *opaque;
+    mtime_t  i_deadline;
+    bool     b_queued;
+    bool     b_running;
+    bool     b_woken;  /* woken up while running */
+    bool     b_done;
+} input_pool_task_t;
+
+typedef struct input_pool_t input_pool_t;
+
+/* State of the main loop between its steps */
+typedef struct
+{
+    bool    b_interactive;
+    bool    b_pause_after_eof;
+    bool    b_paused_at_eof;
+    bool    b_can_demux;
+    mtime_t i_intf_update;
+    mtime_t i_last_seek_mdate;
+    mtime_t i_wakeup;
+} input_loop_t;
+
 typedef struct input_thread_private_t
 {
     struct input_thread_t input;
@@ -163,7 +190,9 @@ typedef struct input_thread_private_t
         counter_t *p_lost_abuffers;
         counter_t *p_displayed_pictures;
         counter_t *p_lost_pictures;
-        vlc_mutex_t counters_lock;
+        counter_t *p_queue_latency;
+        counter_t *p_decode_latency;
+        counter_t *p_display_latency;
     } counters;
 
     /* Buffer of pending actions */
@@ -174,6 +203,13 @@ typedef struct input_thread_private_t
 
     vlc_thread_t thread;
     vlc_interrupt_t interrupt;
+
+    /* Pooled execution, instead of the thread (see pool.c) */
+    bool        is_pooled;
+    bool        is_pool_init;
+    input_pool_t      *pool;
+    input_pool_task_t  pool_task;
+    input_loop_t       pool_loop;
 } input_thread_private_t;
 
 static inline input_thread_private_t *input_priv(input_thread_t *input)
@@ -241,6 +277,20 @@ void input_ControlPush( input_thread_t *, int i_type, vlc_value_t * );
 
 bool input_Stopped( input_thread_t * );
 
+/* pool.c */
+
+/* The task waits for input_pool_Wake() */
+#define INPUT_POOL_IDLE INT64_C(-1)
+/* The task is over, see input_pool_Wait() */
+#define INPUT_POOL_DONE INT64_MIN
+
+input_pool_t *input_pool_Get( libvlc_int_t * );
+void input_pool_Start( input_pool_t *, input_pool_task_t *,
+                       mtime_t (*)( void * ), void * );
+/* Runs the task as soon as possible */
+void input_pool_Wake( input_pool_t *, input_pool_task_t * );
+void input_pool_Wait( input_pool_t *, input_pool_task_t * );
+
 /* Bound pts_delay */
 #define INPUT_PTS_DELAY_MAX INT64_C(60000000)
 
@@ -0,0 +1,223 @@
+/*****************************************************************************
+ * pool.c: Input threads pool
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include "input/input_internal.h"
+
+/*
+ * The pooled inputs do not have a thread of their own: each step of their
+ * main loop is run by one of the pool threads, which then schedules the next
+ * step at the deadline returned by the step (normally the es_out wake-up
+ * date), or when a control is pushed.
+ */
+struct input_pool_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;      /* tasks to run */
+    vlc_cond_t  wait_done; /* tasks completed */
+    bool        b_quit;
+
+    input_pool_task_t *first; /* queued tasks, by deadline */
+
+    unsigned     i_threads;
+    vlc_thread_t threads[];
+};
+
+static vlc_mutex_t pool_lock = VLC_STATIC_MUTEX;
+
+/* Queues the task after those of an earlier or equal deadline, with the
+ * pool lock held, so that the ready tasks run in turn */
+static void Enqueue( input_pool_t *pool, input_pool_task_t *task,
+                     mtime_t i_deadline )
+{
+    input_pool_task_t **pp = &pool->first;
+
+    assert( !task->b_queued );
+    while( *pp != NULL && (*pp)->i_deadline <= i_deadline )
+        pp = &(*pp)->p_next;
+
+    task->i_deadline = i_deadline;
+    task->p_next = *pp;
+    task->b_queued = true;
+    *pp = task;
+    vlc_cond_signal( &pool->wait );
+}
+
+static void Dequeue( input_pool_t *pool, input_pool_task_t *task )
+{
+    input_pool_task_t **pp = &pool->first;
+
+    while( *pp != task )
+        pp = &(*pp)->p_next;
+    *pp = task->p_next;
+    task->b_queued = false;
+}
+
+static void *Thread( void *data )
+{
+    input_pool_t *pool = data;
+
+    vlc_mutex_lock( &pool->lock );
+    while( !pool->b_quit )
+    {
+        input_pool_task_t *task = pool->first;
+
+        if( task == NULL )
+        {
+            vlc_cond_wait( &pool->wait, &pool->lock );
+            continue;
+        }
+        if( task->i_deadline > mdate() )
+        {
+            vlc_cond_timedwait( &pool->wait, &pool->lock, task->i_deadline );
+            continue;
+        }
+
+        Dequeue( pool, task );
+        task->b_running = true;
+        task->b_woken = false;
+        vlc_mutex_unlock( &pool->lock );
+
+        mtime_t i_next = task->pf_run( task->opaque );
+
+        vlc_mutex_lock( &pool->lock );
+        task->b_running = false;
+        if( i_next == INPUT_POOL_DONE )
+        {
+            task->b_done = true;
+            vlc_cond_broadcast( &pool->wait_done );
+            continue;
+        }
+        if( task->b_woken )
+            i_next = 0;
+        if( i_next != INPUT_POOL_IDLE )
+        {
+            assert( i_next >= 0 );
+            Enqueue( pool, task, i_next );
+        }
+    }
+    vlc_mutex_unlock( &pool->lock );
+    return NULL;
+}
+
+static input_pool_t *input_pool_New( vlc_object_t *obj )
+{
+    int i_threads = var_InheritInteger( obj, "input-pool-threads" );
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount();
+
+    input_pool_t *pool = malloc( sizeof (*pool)
+                                 + i_threads * sizeof (vlc_thread_t) );
+    if( unlikely(pool == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &pool->lock );
+    vlc_cond_init( &pool->wait );
+    vlc_cond_init( &pool->wait_done );
+    pool->b_quit = false;
+    pool->first = NULL;
+    pool->i_threads = 0;
+
+    for( int i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &pool->threads[i], Thread, pool,
+                       VLC_THREAD_PRIORITY_INPUT ) )
+            break;
+        pool->i_threads++;
+    }
+    if( pool->i_threads == 0 )
+    {
+        input_pool_Delete( pool );
+        return NULL;
+    }
+
+    msg_Dbg( obj, "running the pooled inputs on %u threads",
+             pool->i_threads );
+    return pool;
+}
+
+input_pool_t *input_pool_Get( libvlc_int_t *libvlc )
+{
+    libvlc_priv_t *priv = libvlc_priv( libvlc );
+
+    vlc_mutex_lock( &pool_lock );
+    if( priv->input_pool == NULL )
+        priv->input_pool = input_pool_New( VLC_OBJECT(libvlc) );
+    vlc_mutex_unlock( &pool_lock );
+    return priv->input_pool;
+}
+
+void input_pool_Delete( input_pool_t *pool )
+{
+    vlc_mutex_lock( &pool->lock );
+    assert( pool->first == NULL );
+    pool->b_quit = true;
+    vlc_cond_broadcast( &pool->wait );
+    vlc_mutex_unlock( &pool->lock );
+
+    for( unsigned i = 0; i < pool->i_threads; i++ )
+        vlc_join( pool->threads[i], NULL );
+
+    vlc_cond_destroy( &pool->wait_done );
+    vlc_cond_destroy( &pool->wait );
+    vlc_mutex_destroy( &pool->lock );
+    free( pool );
+}
+
+void input_pool_Start( input_pool_t *pool, input_pool_task_t *task,
+                       mtime_t (*pf_run)( void * ), void *opaque )
+{
+    task->pf_run = pf_run;
+    task->opaque = opaque;
+    task->b_queued = task->b_running = task->b_woken = task->b_done = false;
+
+    vlc_mutex_lock( &pool->lock );
+    Enqueue( pool, task, 0 );
+    vlc_mutex_unlock( &pool->lock );
+}
+
+void input_pool_Wake( input_pool_t *pool, input_pool_task_t *task )
+{
+    vlc_mutex_lock( &pool->lock );
+    if( task->b_running )
+        task->b_woken = true;
+    else if( !task->b_done )
+    {
+        if( task->b_queued )
+            Dequeue( pool, task );
+        Enqueue( pool, task, 0 );
+    }
+    vlc_mutex_unlock( &pool->lock );
+}
+
+void input_pool_Wait( input_pool_t *pool, input_pool_task_t *task )
+{
+    vlc_mutex_lock( &pool->lock );
+    while( !task->b_done )
+        vlc_cond_wait( &pool->wait_done, &pool->lock );
+    vlc_mutex_unlock( &pool->lock );
+}
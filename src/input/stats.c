@@ -26,14 +26,37 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_atomic.h>
 #include "input/input_internal.h"
 
+typedef struct counter_sample_t
+{
+    uint64_t value;
+    mtime_t  date;
+} counter_sample_t;
+
+/* Counters are updated by any thread without locking: only the derivative
+ * ones take their lock, when sampled at most once per second. */
+struct counter_t
+{
+    int                  i_compute_type;
+    atomic_uint_fast64_t value; /* STATS_COUNTER total */
+
+    /* STATS_DERIVATIVE: the last two samples, the most recent first */
+    vlc_mutex_t          lock;
+    int                  i_samples;
+    counter_sample_t     samples[2];
+    atomic_int_fast64_t  last_update;
+
+    /* STATS_HISTOGRAM: occurrences of each duration range */
+    atomic_uint_fast64_t buckets[INPUT_STATS_LATENCY_BUCKETS];
+};
+
 /**
  * Create a statistics counter
- * \param i_compute_type the aggregation type. One of STATS_LAST (always
- * keep the last value), STATS_COUNTER (increment by the passed value),
- * STATS_MAX (keep the maximum passed value), STATS_MIN, or STATS_DERIVATIVE
- * (keep a time derivative of the value)
+ * \param i_compute_type the aggregation type. One of STATS_COUNTER
+ * (increment by the passed value), STATS_DERIVATIVE (keep a time derivative
+ * of the value) or STATS_HISTOGRAM (count the passed durations per range)
  */
 counter_t * stats_CounterCreate( int i_compute_type )
 {
@@ -41,28 +64,46 @@ counter_t * stats_CounterCreate( int i_compute_type )
 
     if( !p_counter ) return NULL;
     p_counter->i_compute_type = i_compute_type;
+    atomic_init( &p_counter->value, 0 );
+
+    vlc_mutex_init( &p_counter->lock );
     p_counter->i_samples = 0;
-    p_counter->pp_samples = NULL;
+    atomic_init( &p_counter->last_update, 0 );
 
-    p_counter->last_update = 0;
+    for( int i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++ )
+        atomic_init( &p_counter->buckets[i], 0 );
 
     return p_counter;
 }
 
-static inline int64_t stats_GetTotal(const counter_t *counter)
+static inline int64_t stats_GetTotal(counter_t *counter)
 {
-    if (counter == NULL || counter->i_samples == 0)
+    if (counter == NULL)
         return 0;
-    return counter->pp_samples[0]->value;
+    return atomic_load_explicit(&counter->value, memory_order_relaxed);
 }
 
-static inline float stats_GetRate(const counter_t *counter)
+static inline float stats_GetRate(counter_t *counter)
 {
-    if (counter == NULL || counter->i_samples < 2)
-        return 0.;
+    float rate = 0.;
 
-    return (counter->pp_samples[0]->value - counter->pp_samples[1]->value)
-        / (float)(counter->pp_samples[0]->date - counter->pp_samples[1]->date);
+    if (counter == NULL)
+        return rate;
+
+    vlc_mutex_lock(&counter->lock);
+    if (counter->i_samples == 2)
+        rate = (counter->samples[0].value - counter->samples[1].value)
+            / (float)(counter->samples[0].date - counter->samples[1].date);
+    vlc_mutex_unlock(&counter->lock);
+    return rate;
+}
+
+static inline void stats_GetHistogram(counter_t *counter, int64_t *buckets)
+{
+    for (int i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++)
+        buckets[i] = (counter != NULL)
+            ? atomic_load_explicit(&counter->buckets[i], memory_order_relaxed)
+            : 0;
 }
 
 input_stats_t *stats_NewInputStats( input_thread_t *p_input )
@@ -85,7 +126,6 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     if (!libvlc_stats(input))
         return;
 
-    vlc_mutex_lock(&priv->counters.counters_lock);
     vlc_mutex_lock(&st->lock);
 
     /* Input */
@@ -117,8 +157,20 @@ void stats_ComputeInputStats(input_thread_t *input, input_stats_t *st)
     st->i_displayed_pictures = stats_GetTotal(priv->counters.p_displayed_pictures);
     st->i_lost_pictures = stats_GetTotal(priv->counters.p_lost_pictures);
 
+    /* Threads */
+    libvlc_priv_t *libpriv = libvlc_priv(input->obj.libvlc);
+    vlc_mutex_lock(&libpriv->cpus.lock);
+    st->i_reserved_threads = libpriv->cpus.used;
+    st->i_threads_budget = libpriv->cpus.budget;
+    vlc_mutex_unlock(&libpriv->cpus.lock);
+
+    /* Latencies */
+    stats_GetHistogram(priv->counters.p_queue_latency, st->i_queue_latency);
+    stats_GetHistogram(priv->counters.p_decode_latency, st->i_decode_latency);
+    stats_GetHistogram(priv->counters.p_display_latency,
+                       st->i_display_latency);
+
     vlc_mutex_unlock(&st->lock);
-    vlc_mutex_unlock(&priv->counters.counters_lock);
 }
 
 void stats_ReinitInputStats( input_stats_t *p_stats )
@@ -132,8 +184,11 @@ void stats_ReinitInputStats( input_stats_t *p_stats )
     p_stats->i_displayed_pictures = p_stats->i_lost_pictures =
     p_stats->i_played_abuffers = p_stats->i_lost_abuffers =
     p_stats->i_decoded_video = p_stats->i_decoded_audio =
-    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate
-     = 0;
+    p_stats->i_sent_bytes = p_stats->i_sent_packets = p_stats->f_send_bitrate =
+    p_stats->i_reserved_threads = p_stats->i_threads_budget = 0;
+    for( int i = 0; i < INPUT_STATS_LATENCY_BUCKETS; i++ )
+        p_stats->i_queue_latency[i] = p_stats->i_decode_latency[i] =
+        p_stats->i_display_latency[i] = 0;
     vlc_mutex_unlock( &p_stats->lock );
 }
 
@@ -141,14 +196,7 @@ void stats_CounterClean( counter_t *p_c )
 {
     if( p_c )
     {
-        int i = p_c->i_samples - 1 ;
-        while( i >= 0 )
-        {
-            counter_sample_t *p_s = p_c->pp_samples[i];
-            REMOVE_ELEM( p_c->pp_samples, p_c->i_samples, i );
-            free( p_s );
-            i--;
-        }
+        vlc_mutex_destroy( &p_c->lock );
         free( p_c );
     }
 }
@@ -156,9 +204,10 @@ void stats_CounterClean( counter_t *p_c )
 
 /** Update a counter element with new values
  * \param p_counter the counter to update
- * \param val the vlc_value union containing the new value to aggregate. For
- * more information on how data is aggregated, \see stats_Create
- * \param val_new a pointer that will be filled with new data
+ * \param val the new value to aggregate. For more information on how data
+ * is aggregated, \see stats_CounterCreate
+ * \param val_new a pointer that will be filled with the new total of a
+ * STATS_COUNTER counter
  */
 void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
 {
@@ -169,48 +218,47 @@ void stats_Update( counter_t *p_counter, uint64_t val, uint64_t *new_val )
     {
     case STATS_DERIVATIVE:
     {
-        counter_sample_t *p_new, *p_old;
         mtime_t now = mdate();
-        if( now - p_counter->last_update < CLOCK_FREQ )
+        int_fast64_t last = atomic_load_explicit( &p_counter->last_update,
+                                                  memory_order_relaxed );
+        /* Only one thread samples the value each second */
+        if( now - last < CLOCK_FREQ ||
+            !atomic_compare_exchange_strong( &p_counter->last_update,
+                                             &last, now ) )
             return;
-        p_counter->last_update = now;
-        /* Insert the new one at the beginning */
-        p_new = (counter_sample_t*)malloc( sizeof( counter_sample_t ) );
-        if (unlikely(p_new == NULL))
-            return; /* NOTE: Losing sample here */
-
-        p_new->value = val;
-        p_new->date = p_counter->last_update;
-        INSERT_ELEM( p_counter->pp_samples, p_counter->i_samples,
-                     0, p_new );
-
-        if( p_counter->i_samples == 3 )
-        {
-            p_old = p_counter->pp_samples[2];
-            REMOVE_ELEM( p_counter->pp_samples, p_counter->i_samples, 2 );
-            free( p_old );
-        }
+
+        vlc_mutex_lock( &p_counter->lock );
+        p_counter->samples[1] = p_counter->samples[0];
+        p_counter->samples[0].value = val;
+        p_counter->samples[0].date = now;
+        if( p_counter->i_samples < 2 )
+            p_counter->i_samples++;
+        vlc_mutex_unlock( &p_counter->lock );
         break;
     }
     case STATS_COUNTER:
-        if( p_counter->i_samples == 0 )
-        {
-            counter_sample_t *p_new = (counter_sample_t*)malloc(
-                                               sizeof( counter_sample_t ) );
-            if (unlikely(p_new == NULL))
-                return; /* NOTE: Losing sample here */
-
-            p_new->value = 0;
+    {
+        uint64_t total = atomic_fetch_add_explicit( &p_counter->value, val,
+                                                    memory_order_relaxed )
+                       + val;
+        if( new_val )
+            *new_val = total;
+        break;
+    }
+    case STATS_HISTOGRAM:
+    {
+        /* Bucket i > 0 counts durations from 2^(i-1) to 2^i ms */
+        uint64_t ms = val / 1000;
+        int i = 0;
 
-            INSERT_ELEM( p_counter->pp_samples, p_counter->i_samples,
-                         p_counter->i_samples, p_new );
-        }
-        if( p_counter->i_samples == 1 )
+        while( ms > 0 && i < INPUT_STATS_LATENCY_BUCKETS - 1 )
         {
-            p_counter->pp_samples[0]->value += val;
-            if( new_val )
-                *new_val = p_counter->pp_samples[0]->value;
+            ms >>= 1;
+            i++;
         }
+        atomic_fetch_add_explicit( &p_counter->buckets[i], 1,
+                                   memory_order_relaxed );
         break;
     }
+    }
 }
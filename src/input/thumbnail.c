@@ -0,0 +1,653 @@
+/*****************************************************************************
+ * thumbnail.c: thumbnail extraction
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/**
+ * \file
+ * This file contains the extraction of thumbnails: the media is demuxed
+ * without an input thread, only the keyframes are decoded, and the pictures
+ * go through the image handler to be scaled and encoded.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_atomic.h>
+#include <vlc_codec.h>
+#include <vlc_cpu.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_image.h>
+#include <vlc_meta.h>
+#include <vlc_modules.h>
+#include <vlc_picture_fifo.h>
+#include <vlc_thumbnail.h>
+#include "../libvlc.h"
+#include "stream.h"
+
+/* Blocks read for one thumbnail before giving up on it */
+#define THUMBNAIL_MAX_BLOCKS 1000
+
+struct es_out_id_t
+{
+    bool b_video;
+};
+
+typedef struct
+{
+    vlc_object_t   *p_obj;
+    es_out_t        out;
+    demux_t        *p_demux;
+
+    /* the first video ES, the only one decoded */
+    es_out_id_t    *p_video;
+    es_format_t     fmt;
+
+    /* blocks of the video ES not decoded yet */
+    block_t        *p_blocks;
+    block_t       **pp_blocks_last;
+    bool            b_eof;
+
+    decoder_t      *p_packetizer;
+    decoder_t      *p_dec;
+    picture_fifo_t *pictures;
+} thumbnailer_t;
+
+/*****************************************************************************
+ * ES output, keeping the blocks of the first video ES
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *p_fmt )
+{
+    thumbnailer_t *th = (thumbnailer_t *)out->p_sys;
+
+    es_out_id_t *id = malloc( sizeof( *id ) );
+    if( unlikely(id == NULL) )
+        return NULL;
+
+    id->b_video = p_fmt->i_cat == VIDEO_ES && th->p_video == NULL &&
+                  es_format_Copy( &th->fmt, p_fmt ) == VLC_SUCCESS;
+    if( id->b_video )
+        th->p_video = id;
+    return id;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    thumbnailer_t *th = (thumbnailer_t *)out->p_sys;
+
+    if( id == th->p_video )
+        block_ChainLastAppend( &th->pp_blocks_last, p_block );
+    else
+        block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    thumbnailer_t *th = (thumbnailer_t *)out->p_sys;
+
+    if( id == th->p_video )
+        th->p_video = NULL; /* keep its format and blocks */
+    free( id );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    thumbnailer_t *th = (thumbnailer_t *)out->p_sys;
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *id = va_arg( args, es_out_id_t * );
+            bool *pb_enabled = va_arg( args, bool * );
+            *pb_enabled = id == th->p_video;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+
+        case ES_OUT_SET_ES:
+        case ES_OUT_RESTART_ES:
+        case ES_OUT_SET_ES_DEFAULT:
+        case ES_OUT_SET_ES_STATE:
+        case ES_OUT_SET_ES_FMT:
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_GROUP:
+        case ES_OUT_SET_META:
+        case ES_OUT_SET_GROUP_META:
+        case ES_OUT_SET_GROUP_EPG:
+        case ES_OUT_SET_EPG_TIME:
+        case ES_OUT_DEL_GROUP:
+        case ES_OUT_SET_ES_SCRAMBLED_STATE:
+            return VLC_SUCCESS;
+
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+static void EsOutDestroy( es_out_t *out )
+{
+    (void) out;
+}
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+static int DecoderUpdateFormat( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *DecoderNewBuffer( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static int DecoderQueueVideo( decoder_t *p_dec, picture_t *p_pic,
+                              block_t *p_cc, bool p_cc_present[4] )
+{
+    thumbnailer_t *th = p_dec->p_queue_ctx;
+
+    (void) p_cc_present;
+    if( unlikely(p_cc != NULL) )
+        block_Release( p_cc );
+
+    picture_fifo_Push( th->pictures, p_pic );
+    return 0;
+}
+
+static void DecoderDelete( decoder_t *p_dec )
+{
+    if( p_dec->p_module )
+        module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *DecoderNew( thumbnailer_t *th, const es_format_t *p_fmt )
+{
+    decoder_t *p_dec = vlc_custom_create( th->p_obj, sizeof( *p_dec ),
+                                          "thumbnail decoder" );
+    if( unlikely(p_dec == NULL) )
+        return NULL;
+
+    if( es_format_Copy( &p_dec->fmt_in, p_fmt ) )
+    {
+        vlc_object_release( p_dec );
+        return NULL;
+    }
+    es_format_Init( &p_dec->fmt_out, VIDEO_ES, 0 );
+    p_dec->b_frame_drop_allowed = false;
+
+    p_dec->pf_vout_format_update = DecoderUpdateFormat;
+    p_dec->pf_vout_buffer_new = DecoderNewBuffer;
+    p_dec->pf_queue_video = DecoderQueueVideo;
+    p_dec->p_queue_ctx = th;
+
+    /* Only the keyframes are wanted, from a software decoder using a single
+     * thread, as thumbnails are extracted from several media in parallel */
+    var_Create( p_dec, "avcodec-skip-frame", VLC_VAR_INTEGER );
+    var_SetInteger( p_dec, "avcodec-skip-frame", 3 /* non-key */ );
+    var_Create( p_dec, "avcodec-threads", VLC_VAR_INTEGER );
+    var_SetInteger( p_dec, "avcodec-threads", 1 );
+    var_Create( p_dec, "avcodec-hw", VLC_VAR_STRING );
+    var_SetString( p_dec, "avcodec-hw", "none" );
+
+    p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+    if( p_dec->p_module == NULL || p_dec->fmt_out.i_cat != VIDEO_ES )
+    {
+        msg_Err( th->p_obj, "cannot decode video codec '%4.4s'",
+                 (const char *)&p_fmt->i_codec );
+        DecoderDelete( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+/* Decodes a packetized block, or drains the decoder if p_block is NULL */
+static void DecodeBlock( thumbnailer_t *th, block_t *p_block )
+{
+    if( p_block != NULL )
+    {
+        /* Skip the frames known not to be keyframes without decoding */
+        if( p_block->i_flags & (BLOCK_FLAG_TYPE_P | BLOCK_FLAG_TYPE_B) )
+        {
+            block_Release( p_block );
+            return;
+        }
+
+        if( th->p_dec == NULL )
+            th->p_dec = DecoderNew( th, th->p_packetizer != NULL
+                                        ? &th->p_packetizer->fmt_out
+                                        : &th->fmt );
+        if( th->p_dec == NULL )
+        {
+            block_Release( p_block );
+            th->b_eof = true;
+            return;
+        }
+    }
+    else if( th->p_dec == NULL )
+        return;
+
+    th->p_dec->pf_decode( th->p_dec, p_block );
+}
+
+/* Decodes a block from the demuxer, or drains if p_block is NULL */
+static void Decode( thumbnailer_t *th, block_t *p_block )
+{
+    if( th->p_packetizer == NULL )
+    {
+        DecodeBlock( th, p_block );
+        return;
+    }
+
+    block_t **pp_block = p_block != NULL ? &p_block : NULL;
+    block_t *p_packetized;
+
+    while( (p_packetized =
+            th->p_packetizer->pf_packetize( th->p_packetizer, pp_block )) )
+    {
+        while( p_packetized != NULL )
+        {
+            block_t *p_next = p_packetized->p_next;
+            p_packetized->p_next = NULL;
+            DecodeBlock( th, p_packetized );
+            p_packetized = p_next;
+        }
+    }
+
+    if( p_block == NULL )
+        DecodeBlock( th, NULL );
+}
+
+static void Flush( thumbnailer_t *th )
+{
+    block_ChainRelease( th->p_blocks );
+    th->p_blocks = NULL;
+    th->pp_blocks_last = &th->p_blocks;
+
+    if( th->p_packetizer != NULL && th->p_packetizer->pf_flush != NULL )
+        th->p_packetizer->pf_flush( th->p_packetizer );
+    if( th->p_dec != NULL && th->p_dec->pf_flush != NULL )
+        th->p_dec->pf_flush( th->p_dec );
+
+    picture_t *p_pic;
+    while( (p_pic = picture_fifo_Pop( th->pictures )) != NULL )
+        picture_Release( p_pic );
+}
+
+static block_t *NextBlock( thumbnailer_t *th )
+{
+    while( th->p_blocks == NULL )
+    {
+        if( th->b_eof || demux_Demux( th->p_demux ) != VLC_DEMUXER_SUCCESS )
+        {
+            th->b_eof = true;
+            return NULL;
+        }
+    }
+
+    block_t *p_block = th->p_blocks;
+    th->p_blocks = p_block->p_next;
+    if( th->p_blocks == NULL )
+        th->pp_blocks_last = &th->p_blocks;
+    p_block->p_next = NULL;
+    return p_block;
+}
+
+/* Returns the next decoded picture, or NULL */
+static picture_t *NextPicture( thumbnailer_t *th )
+{
+    picture_t *p_pic;
+
+    for( unsigned i = 0; i < THUMBNAIL_MAX_BLOCKS; i++ )
+    {
+        if( (p_pic = picture_fifo_Pop( th->pictures )) != NULL )
+            return p_pic;
+
+        block_t *p_block = NextBlock( th );
+        if( p_block == NULL )
+            break;
+        Decode( th, p_block );
+    }
+
+    /* Get the pictures still held by the decoder */
+    if( (p_pic = picture_fifo_Pop( th->pictures )) == NULL )
+    {
+        Decode( th, NULL );
+        p_pic = picture_fifo_Pop( th->pictures );
+    }
+    return p_pic;
+}
+
+/* Goes to the keyframe before i_time, or reads up to it */
+static void Seek( thumbnailer_t *th, mtime_t i_time, bool b_can_seek )
+{
+    if( b_can_seek )
+    {
+        int64_t i_length;
+
+        if( demux_Control( th->p_demux, DEMUX_SET_TIME, i_time, false )
+         && demux_Control( th->p_demux, DEMUX_GET_LENGTH, &i_length ) == VLC_SUCCESS
+         && i_length > 0 )
+            demux_Control( th->p_demux, DEMUX_SET_POSITION,
+                           (double) i_time / i_length, false );
+        th->b_eof = false;
+        Flush( th );
+        return;
+    }
+
+    /* Without seeking, drop the blocks up to the time, the thumbnail being
+     * the first keyframe after it */
+    int64_t i_demux_time;
+    while( !th->b_eof &&
+           demux_Control( th->p_demux, DEMUX_GET_TIME, &i_demux_time ) == VLC_SUCCESS &&
+           i_demux_time < i_time )
+    {
+        block_t *p_block = NextBlock( th );
+        if( p_block != NULL )
+            block_Release( p_block );
+    }
+}
+
+static block_t *Encode( image_handler_t *p_image, picture_t *p_pic,
+                        const video_format_t *p_fmt )
+{
+    video_format_t fmt_in = p_pic->format;
+    video_format_t fmt_out;
+    unsigned i_sar_num = fmt_in.i_sar_num, i_sar_den = fmt_in.i_sar_den;
+    unsigned i_width = p_fmt->i_width, i_height = p_fmt->i_height;
+
+    if( i_sar_num == 0 || i_sar_den == 0 )
+        i_sar_num = i_sar_den = 1;
+    if( fmt_in.i_visible_width == 0 || fmt_in.i_visible_height == 0 )
+    {
+        fmt_in.i_visible_width = fmt_in.i_width;
+        fmt_in.i_visible_height = fmt_in.i_height;
+    }
+
+    /* The images have square pixels */
+    if( i_width == 0 && i_height == 0 )
+    {
+        i_width = (uint64_t)fmt_in.i_visible_width * i_sar_num / i_sar_den;
+        i_height = fmt_in.i_visible_height;
+    }
+    else if( i_width == 0 )
+        i_width = (uint64_t)i_height * fmt_in.i_visible_width * i_sar_num
+                / ((uint64_t)fmt_in.i_visible_height * i_sar_den);
+    else if( i_height == 0 )
+        i_height = (uint64_t)i_width * fmt_in.i_visible_height * i_sar_den
+                 / ((uint64_t)fmt_in.i_visible_width * i_sar_num);
+
+    video_format_Init( &fmt_out, p_fmt->i_chroma );
+    fmt_out.i_width = fmt_out.i_visible_width = __MAX( i_width, 1 );
+    fmt_out.i_height = fmt_out.i_visible_height = __MAX( i_height, 1 );
+    fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+    return image_Write( p_image, p_pic, &fmt_in, &fmt_out );
+}
+
+typedef struct
+{
+    mtime_t i_time;
+    size_t  i_index;
+} thumbnail_time_t;
+
+static int CompareTimes( const void *a, const void *b )
+{
+    const thumbnail_time_t *ta = a, *tb = b;
+
+    if( ta->i_time != tb->i_time )
+        return ta->i_time < tb->i_time ? -1 : 1;
+    return ta->i_index < tb->i_index ? -1 : ta->i_index > tb->i_index;
+}
+
+static int Extract( vlc_object_t *p_obj, image_handler_t *p_image,
+                    vlc_thumbnail_job_t *p_job, const video_format_t *p_fmt )
+{
+    p_job->i_images = 0;
+    p_job->pp_images = calloc( p_job->i_times, sizeof( *p_job->pp_images ) );
+    if( unlikely(p_job->pp_images == NULL && p_job->i_times > 0) )
+        return VLC_ENOMEM;
+
+    /* Go through the times in order, so that media which cannot seek are
+     * read only once */
+    thumbnail_time_t *p_times = malloc( p_job->i_times * sizeof( *p_times ) );
+    if( unlikely(p_times == NULL && p_job->i_times > 0) )
+    {
+        free( p_job->pp_images );
+        p_job->pp_images = NULL;
+        return VLC_ENOMEM;
+    }
+    for( size_t i = 0; i < p_job->i_times; i++ )
+    {
+        p_times[i].i_time = p_job->pi_times[i];
+        p_times[i].i_index = i;
+    }
+    qsort( p_times, p_job->i_times, sizeof( *p_times ), CompareTimes );
+
+    thumbnailer_t th = {
+        .p_obj = p_obj,
+        .out = {
+            .pf_add = EsOutAdd,
+            .pf_send = EsOutSend,
+            .pf_del = EsOutDel,
+            .pf_control = EsOutControl,
+            .pf_destroy = EsOutDestroy,
+        },
+        .pictures = picture_fifo_New(),
+    };
+    th.out.p_sys = (es_out_sys_t *)&th;
+    th.pp_blocks_last = &th.p_blocks;
+    es_format_Init( &th.fmt, UNKNOWN_ES, 0 );
+
+    int i_ret = VLC_EGENERIC;
+    const char *psz_location = strstr( p_job->psz_url, "://" );
+    psz_location = psz_location != NULL ? psz_location + 3 : p_job->psz_url;
+
+    if( unlikely(th.pictures == NULL) )
+        goto end;
+    stream_t *s = vlc_stream_NewURL( p_obj, p_job->psz_url );
+    if( s == NULL )
+        goto end;
+    s = stream_FilterAutoNew( s );
+
+    th.p_demux = demux_New( p_obj, "any", psz_location, s, &th.out );
+    if( th.p_demux == NULL )
+    {
+        msg_Err( p_obj, "cannot demux %s", p_job->psz_url );
+        vlc_stream_Delete( s );
+        goto end;
+    }
+
+    /* Find the video ES */
+    while( th.fmt.i_cat != VIDEO_ES && !th.b_eof )
+        if( demux_Demux( th.p_demux ) != VLC_DEMUXER_SUCCESS )
+            th.b_eof = true;
+    if( th.fmt.i_cat != VIDEO_ES )
+    {
+        msg_Warn( p_obj, "no video in %s", p_job->psz_url );
+        goto end;
+    }
+
+    if( !th.fmt.b_packetized )
+    {
+        es_format_t fmt;
+        if( es_format_Copy( &fmt, &th.fmt ) == VLC_SUCCESS )
+            th.p_packetizer = demux_PacketizerNew( th.p_demux, &fmt, "thumbnail" );
+        if( th.p_packetizer == NULL )
+            goto end;
+    }
+
+    bool b_can_seek;
+    if( demux_Control( th.p_demux, DEMUX_CAN_SEEK, &b_can_seek ) )
+        b_can_seek = false;
+
+    for( size_t i = 0; i < p_job->i_times; i++ )
+    {
+        Seek( &th, p_times[i].i_time, b_can_seek );
+
+        picture_t *p_pic = NextPicture( &th );
+        if( p_pic == NULL )
+        {
+            msg_Dbg( p_obj, "no thumbnail at %"PRId64" in %s",
+                     p_times[i].i_time, p_job->psz_url );
+            if( !b_can_seek )
+                break;
+            continue;
+        }
+
+        block_t *p_image_block = Encode( p_image, p_pic, p_fmt );
+        picture_Release( p_pic );
+        if( p_image_block != NULL )
+        {
+            p_job->pp_images[p_times[i].i_index] = p_image_block;
+            p_job->i_images++;
+        }
+    }
+    i_ret = VLC_SUCCESS;
+
+end:
+    if( th.p_demux != NULL )
+        demux_Delete( th.p_demux );
+    block_ChainRelease( th.p_blocks );
+    if( th.p_dec != NULL )
+        DecoderDelete( th.p_dec );
+    if( th.p_packetizer != NULL )
+        demux_PacketizerDestroy( th.p_packetizer );
+    if( th.pictures != NULL )
+    {
+        picture_t *p_pic;
+        while( (p_pic = picture_fifo_Pop( th.pictures )) != NULL )
+            picture_Release( p_pic );
+        picture_fifo_Delete( th.pictures );
+    }
+    es_format_Clean( &th.fmt );
+    free( p_times );
+    return i_ret;
+}
+
+#undef vlc_thumbnail_Extract
+int vlc_thumbnail_Extract( vlc_object_t *p_obj, vlc_thumbnail_job_t *p_job,
+                           const video_format_t *p_fmt )
+{
+    image_handler_t *p_image = image_HandlerCreate( p_obj );
+    if( unlikely(p_image == NULL) )
+    {
+        p_job->pp_images = NULL;
+        p_job->i_images = 0;
+        return VLC_ENOMEM;
+    }
+
+    int i_ret = Extract( p_obj, p_image, p_job, p_fmt );
+    image_HandlerDelete( p_image );
+    return i_ret;
+}
+
+/*****************************************************************************
+ * Parallel extraction: each worker takes the next media to process
+ *****************************************************************************/
+typedef struct
+{
+    vlc_object_t         *p_obj;
+    vlc_thumbnail_job_t  *p_jobs;
+    size_t                i_jobs;
+    const video_format_t *p_fmt;
+    atomic_size_t         i_next;
+} thumbnail_pool_t;
+
+static void *Worker( void *data )
+{
+    thumbnail_pool_t *p_pool = data;
+    image_handler_t *p_image = image_HandlerCreate( p_pool->p_obj );
+    size_t i;
+
+    while( (i = atomic_fetch_add( &p_pool->i_next, 1 )) < p_pool->i_jobs )
+    {
+        vlc_thumbnail_job_t *p_job = &p_pool->p_jobs[i];
+
+        if( likely(p_image != NULL) )
+            Extract( p_pool->p_obj, p_image, p_job, p_pool->p_fmt );
+        else
+        {
+            p_job->pp_images = NULL;
+            p_job->i_images = 0;
+        }
+    }
+
+    if( p_image != NULL )
+        image_HandlerDelete( p_image );
+    return NULL;
+}
+
+#undef vlc_thumbnail_ExtractMany
+void vlc_thumbnail_ExtractMany( vlc_object_t *p_obj,
+                                vlc_thumbnail_job_t *p_jobs, size_t i_jobs,
+                                const video_format_t *p_fmt,
+                                unsigned i_workers )
+{
+    thumbnail_pool_t pool = {
+        .p_obj = p_obj,
+        .p_jobs = p_jobs,
+        .i_jobs = i_jobs,
+        .p_fmt = p_fmt,
+    };
+    atomic_init( &pool.i_next, 0 );
+
+    if( i_workers == 0 )
+        i_workers = vlc_GetCPUCount();
+    if( i_workers > i_jobs )
+        i_workers = i_jobs;
+
+    /* The calling thread is one of the workers */
+    vlc_thread_t *p_threads = NULL;
+    unsigned i_threads = 0;
+
+    if( i_workers > 1 )
+        p_threads = malloc( (i_workers - 1) * sizeof( *p_threads ) );
+    if( p_threads != NULL )
+        for( ; i_threads < i_workers - 1; i_threads++ )
+            if( vlc_clone( &p_threads[i_threads], Worker, &pool,
+                           VLC_THREAD_PRIORITY_LOW ) )
+                break;
+
+    Worker( &pool );
+
+    for( unsigned i = 0; i < i_threads; i++ )
+        vlc_join( p_threads[i], NULL );
+    free( p_threads );
+}
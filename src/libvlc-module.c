@@ -85,6 +85,12 @@ static const char *const ppsz_snap_formats[] =
     "This is the verbosity level (0=only errors and " \
     "standard messages, 1=warnings, 2=debug).")
 
+#define LOG_ASYNC_TEXT N_("Asynchronous logging")
+#define LOG_ASYNC_LONGTEXT N_( \
+    "Deliver the messages to the logger from a separate thread, so that " \
+    "logging does not delay the decoding and display threads. Messages " \
+    "may be dropped if they are emitted faster than they are logged.")
+
 #define OPEN_TEXT N_("Default stream")
 #define OPEN_LONGTEXT N_( \
     "This stream will always be opened at VLC startup." )
@@ -199,6 +205,13 @@ static const char *const ppsz_stereo_mode_texts[] = { N_("Unset"),
     "This adds audio post processing filters, to modify " \
     "the sound rendering." )
 
+#define AUDIO_FILTER_THREADS_TEXT N_("Audio filter threads")
+#define AUDIO_FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads running the audio filters that process each channel " \
+    "independently, each one handling a group of channels. " \
+    "0 uses several threads for multichannel audio only, within the " \
+    "decoding and encoding threads budget.")
+
 #define AUDIO_VISUAL_TEXT N_("Audio visualizations")
 #define AUDIO_VISUAL_LONGTEXT N_( \
     "This adds visualization modules (spectrum analyzer, etc.).")
@@ -386,6 +399,13 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define CHROMA_THREADS_TEXT N_("Video conversion threads")
+#define CHROMA_THREADS_LONGTEXT N_( \
+    "Number of threads converting each picture in the chroma conversion " \
+    "and scaling filters, each one handling a band of lines. " \
+    "0 uses several threads for high definition pictures only, within " \
+    "the decoding and encoding threads budget.")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -530,6 +550,13 @@ static const char *const ppsz_pos_descriptions[] =
     "This defines the maximum input delay jitter that the synchronization " \
     "algorithms should try to compensate (in milliseconds)." )
 
+#define LOW_DELAY_TEXT N_("Low delay target (ms)")
+#define LOW_DELAY_LONGTEXT N_( \
+    "Bounds the delay between the input and the display to this duration, " \
+    "in milliseconds: the caching and the clock jitter are limited to it, " \
+    "and the audio and video that would be played later are dropped. " \
+    "0 disables this limit." )
+
 #define NETSYNC_TEXT N_("Network synchronisation" )
 #define NETSYNC_LONGTEXT N_( "This allows you to remotely " \
         "synchronise clocks for server and client. The detailed settings " \
@@ -643,6 +670,16 @@ static const char *const ppsz_prefres[] = {
 #define INPUT_FAST_SEEK_LONGTEXT N_( \
     "Favor speed over precision while seeking" )
 
+#define INPUT_POOLED_TEXT N_("Pooled input threads")
+#define INPUT_POOLED_LONGTEXT N_( \
+    "Run the inputs on a shared pool of threads rather than on a thread " \
+    "each. This scales better when many inputs are played at once." )
+
+#define INPUT_POOL_THREADS_TEXT N_("Input pool threads")
+#define INPUT_POOL_THREADS_LONGTEXT N_( \
+    "Number of threads running the pooled inputs " \
+    "(0 for one per CPU)." )
+
 #define INPUT_RATE_TEXT N_("Playback speed")
 #define INPUT_RATE_LONGTEXT N_( \
     "This defines the playback speed (nominal speed is 1.0)." )
@@ -901,6 +938,12 @@ static const char *const ppsz_prefres[] = {
     "This allows you to select a list of encoders that VLC will use in " \
     "priority.")
 
+#define CPU_BUDGET_TEXT N_("Decoding and encoding threads")
+#define CPU_BUDGET_LONGTEXT N_( \
+    "Number of threads shared by all the decoders and encoders running at " \
+    "the same time. Each one gets a share of them when it starts. " \
+    "0 uses the number of CPUs plus one." )
+
 /*****************************************************************************
  * Sout
  ****************************************************************************/
@@ -945,6 +988,12 @@ static const char *const ppsz_prefres[] = {
     "multiple playlist item (automatically insert the gather stream output " \
     "if not specified)" )
 
+#define SOUT_DIRECT_TEXT N_("Direct stream output")
+#define SOUT_DIRECT_LONGTEXT N_( \
+    "Packetize the streams and send them to the stream output from the " \
+    "input thread, rather than from one thread per stream. This is faster " \
+    "when remuxing, but a slow stream output then delays the input." )
+
 #define SOUT_MUX_CACHING_TEXT N_("Stream output muxer caching (ms)")
 #define SOUT_MUX_CACHING_LONGTEXT N_( \
     "This allow you to configure the initial caching amount for stream output " \
@@ -1503,6 +1552,9 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_AUDIO_AFILTER )
     add_module_list( "audio-filter", "audio filter", NULL,
                      AUDIO_FILTER_TEXT, AUDIO_FILTER_LONGTEXT, false )
+    add_integer( "audio-filter-threads", 0, AUDIO_FILTER_THREADS_TEXT,
+                 AUDIO_FILTER_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
     set_subcategory( SUBCAT_AUDIO_VISUAL )
     add_module( "audio-visual", "visualization", "none", AUDIO_VISUAL_TEXT,
                 AUDIO_VISUAL_LONGTEXT, false )
@@ -1627,6 +1679,9 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list( "video-filter", "video filter", NULL,
                      VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
+    add_integer( "chroma-threads", 0, CHROMA_THREADS_TEXT,
+                 CHROMA_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
 
     set_subcategory( SUBCAT_VIDEO_SPLITTER )
     add_module_list( "video-splitter", "video splitter", NULL,
@@ -1730,6 +1785,12 @@ vlc_module_begin ()
     add_bool( "input-fast-seek", false,
               INPUT_FAST_SEEK_TEXT, INPUT_FAST_SEEK_LONGTEXT, false )
         change_safe ()
+    add_bool( "input-pooled", false,
+              INPUT_POOLED_TEXT, INPUT_POOLED_LONGTEXT, true )
+        change_safe ()
+    add_integer( "input-pool-threads", 0,
+                 INPUT_POOL_THREADS_TEXT, INPUT_POOL_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
     add_float( "rate", 1.,
                INPUT_RATE_TEXT, INPUT_RATE_LONGTEXT, false )
 
@@ -1864,6 +1925,9 @@ vlc_module_begin ()
     add_integer( "clock-jitter", 5 * CLOCK_FREQ/1000, CLOCK_JITTER_TEXT,
               CLOCK_JITTER_LONGTEXT, true )
         change_safe()
+    add_integer_with_range( "low-delay", 0, 0, 60000, LOW_DELAY_TEXT,
+                            LOW_DELAY_LONGTEXT, true )
+        change_safe()
 
     add_bool( "network-synchronisation", false, NETSYNC_TEXT,
               NETSYNC_LONGTEXT, true )
@@ -1887,6 +1951,9 @@ vlc_module_begin ()
                 CODEC_LONGTEXT, true )
     add_string( "encoder",  NULL, ENCODER_TEXT,
                 ENCODER_LONGTEXT, true )
+    add_integer( "cpu-budget", 0, CPU_BUDGET_TEXT,
+                 CPU_BUDGET_LONGTEXT, true )
+        change_integer_range( 0, 1024 )
 
     set_subcategory( SUBCAT_INPUT_ACCESS )
     add_category_hint( N_("Input"), INPUT_CAT_LONGTEXT , false )
@@ -1922,6 +1989,8 @@ vlc_module_begin ()
                                 SOUT_VIDEO_LONGTEXT, true )
     add_bool( "sout-spu", 1, SOUT_SPU_TEXT,
                                 SOUT_SPU_LONGTEXT, true )
+    add_bool( "sout-direct", false, SOUT_DIRECT_TEXT,
+                                SOUT_DIRECT_LONGTEXT, true )
     add_integer( "sout-mux-caching", 1500, SOUT_MUX_CACHING_TEXT,
                                 SOUT_MUX_CACHING_LONGTEXT, true )
 
@@ -2074,6 +2143,7 @@ vlc_module_begin ()
         change_short('v')
         change_volatile ()
     add_obsolete_string( "verbose-objects" ) /* since 2.1.0 */
+    add_bool( "log-async", false, LOG_ASYNC_TEXT, LOG_ASYNC_LONGTEXT, true )
 #if !defined(_WIN32) && !defined(__OS2__)
     add_bool( "daemon", 0, DAEMON_TEXT, DAEMON_LONGTEXT, true )
         change_short('d')
@@ -102,6 +102,11 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->input_pool = NULL;
+    vlc_mutex_init( &priv->cpus.lock );
+    priv->cpus.budget = 0;
+    priv->cpus.used = 0;
+    priv->cpus.users = 0;
 
     vlc_ExitInit( &priv->exit );
 
@@ -354,6 +359,15 @@ dbus_out:
 
     priv->b_stats = var_InheritBool( p_libvlc, "stats" );
 
+    int i_cpu_budget = var_InheritInteger( p_libvlc, "cpu-budget" );
+    if( i_cpu_budget <= 0 )
+    {
+        i_cpu_budget = vlc_GetCPUCount();
+        if( i_cpu_budget > 1 )
+            i_cpu_budget++;
+    }
+    priv->cpus.budget = i_cpu_budget;
+
     /*
      * Initialize hotkey handling
      */
@@ -537,6 +551,9 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
     if (priv->parser != NULL)
         playlist_preparser_Delete(priv->parser);
 
+    if (priv->input_pool != NULL)
+        input_pool_Delete(priv->input_pool);
+
     vlc_DeinitActions( p_libvlc, priv->actions );
 
     /* Save the configuration */
@@ -563,6 +580,7 @@ void libvlc_InternalDestroy( libvlc_int_t *p_libvlc )
     libvlc_priv_t *priv = libvlc_priv( p_libvlc );
 
     vlc_ExitDestroy( &priv->exit );
+    vlc_mutex_destroy( &priv->cpus.lock );
 
     assert( atomic_load(&(vlc_internals(p_libvlc)->refs)) == 1 );
     vlc_object_release( p_libvlc );
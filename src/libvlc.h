@@ -151,6 +151,16 @@ typedef struct libvlc_priv_t
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
     struct vlc_actions *actions; ///< Hotkeys handler
+    struct input_pool_t *input_pool; ///< Threads of the pooled inputs
+
+    /* Decoders and encoders threads budget, see vlc_ReserveCPUs() */
+    struct
+    {
+        vlc_mutex_t    lock;
+        unsigned       budget; ///< Threads to share
+        unsigned       used; ///< Threads reserved
+        unsigned       users; ///< Reservations
+    } cpus;
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -179,22 +189,10 @@ enum
 {
     STATS_COUNTER,
     STATS_DERIVATIVE,
+    STATS_HISTOGRAM,
 };
 
-typedef struct counter_sample_t
-{
-    uint64_t value;
-    mtime_t  date;
-} counter_sample_t;
-
-typedef struct counter_t
-{
-    int                 i_compute_type;
-    int                 i_samples;
-    counter_sample_t ** pp_samples;
-
-    mtime_t             last_update;
-} counter_t;
+typedef struct counter_t counter_t;
 
 enum
 {
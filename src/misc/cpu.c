@@ -172,6 +172,7 @@ void vlc_CPU_init (void)
 
     /* the CPU supports the CPUID instruction - get its level */
     cpuid( 0x00000000 );
+    const unsigned i_max_level = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -210,6 +211,36 @@ void vlc_CPU_init (void)
             i_capabilities |= VLC_CPU_SSE4_1;
         if (i_ecx & 0x00100000)
             i_capabilities |= VLC_CPU_SSE4_2;
+
+        /* AVX needs the OS to save the YMM registers (OSXSAVE and XCR0) */
+        if ((i_ecx & 0x18000000) == 0x18000000)
+        {
+            uint32_t i_xcr0, i_xcr0_hi;
+
+            asm volatile ("xgetbv" : "=a" (i_xcr0), "=d" (i_xcr0_hi) : "c" (0));
+            if ((i_xcr0 & 0x6) == 0x6)
+            {
+                i_capabilities |= VLC_CPU_AVX;
+                if (i_max_level >= 7)
+                {
+# if defined (__i386__) && defined (__PIC__)
+                    asm volatile ("xchgl %%ebx,%1\n\t"
+                                  "cpuid\n\t"
+                                  "xchgl %%ebx,%1\n\t"
+                                  : "=a" (i_eax), "=r" (i_ebx),
+                                    "=c" (i_ecx), "=d" (i_edx)
+                                  : "a" (7), "c" (0) : "cc");
+# else
+                    asm volatile ("cpuid\n\t"
+                                  : "=a" (i_eax), "=b" (i_ebx),
+                                    "=c" (i_ecx), "=d" (i_edx)
+                                  : "a" (7), "c" (0) : "cc");
+# endif
+                    if (i_ebx & 0x00000020)
+                        i_capabilities |= VLC_CPU_AVX2;
+                }
+            }
+        }
     }
 
     /* test for additional capabilities */
@@ -278,6 +309,50 @@ unsigned vlc_CPU (void)
 }
 #endif
 
+#undef vlc_ReserveCPUs
+unsigned vlc_ReserveCPUs (vlc_object_t *obj, unsigned wanted)
+{
+    libvlc_priv_t *priv = libvlc_priv (obj->obj.libvlc);
+    unsigned count;
+
+    vlc_mutex_lock (&priv->cpus.lock);
+    /* Fair share among the current users and the new one, within what is
+     * left of the budget */
+    count = priv->cpus.budget / (priv->cpus.users + 1);
+    if (priv->cpus.used < priv->cpus.budget)
+    {
+        if (count > priv->cpus.budget - priv->cpus.used)
+            count = priv->cpus.budget - priv->cpus.used;
+    }
+    else
+        count = 0;
+    if (count > wanted)
+        count = wanted;
+    if (count < 1)
+        count = 1;
+    priv->cpus.used += count;
+    priv->cpus.users++;
+    msg_Dbg (obj, "reserved %u of %u wanted thread(s), "
+             "%u/%u thread(s) used by %u user(s)", count, wanted,
+             priv->cpus.used, priv->cpus.budget, priv->cpus.users);
+    vlc_mutex_unlock (&priv->cpus.lock);
+    return count;
+}
+
+#undef vlc_ReleaseCPUs
+void vlc_ReleaseCPUs (vlc_object_t *obj, unsigned count)
+{
+    libvlc_priv_t *priv = libvlc_priv (obj->obj.libvlc);
+
+    vlc_mutex_lock (&priv->cpus.lock);
+    assert (priv->cpus.users > 0 && priv->cpus.used >= count);
+    priv->cpus.used -= count;
+    priv->cpus.users--;
+    msg_Dbg (obj, "released %u thread(s), %u/%u thread(s) used by %u user(s)",
+             count, priv->cpus.used, priv->cpus.budget, priv->cpus.users);
+    vlc_mutex_unlock (&priv->cpus.lock);
+}
+
 void vlc_CPU_dump (vlc_object_t *obj)
 {
     struct vlc_memstream stream;
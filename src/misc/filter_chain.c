@@ -28,6 +28,7 @@
 #include <vlc_filter.h>
 #include <vlc_modules.h>
 #include <vlc_mouse.h>
+#include <vlc_picture_pool.h>
 #include <vlc_spu.h>
 #include <libvlc.h>
 #include <assert.h>
@@ -40,8 +41,15 @@ typedef struct chained_filter_t
     struct chained_filter_t *prev, *next;
     vlc_mouse_t *mouse;
     picture_t *pending;
+    picture_pool_t *pool; /**< Output pictures of intermediate filters */
+    video_format_t pool_fmt; /**< Format of the pooled pictures */
 } chained_filter_t;
 
+/* Number of recycled output pictures per intermediate filter. The next
+ * filter may hold a few of them (e.g. deinterlacing history); more are
+ * allocated on the fly if all of them are in use. */
+#define CHAINED_POOL_SIZE 4
+
 /* Only use this with filter objects from _this_ C module */
 static inline chained_filter_t *chained (filter_t *filter)
 {
@@ -107,12 +115,40 @@ filter_chain_t *filter_chain_New( vlc_object_t *obj, const char *cap )
     return filter_chain_NewInner( &callbacks, cap, NULL, false, NULL );
 }
 
+/** Gets a recycled output picture, (re)creating the pool on format change */
+static picture_t *ChainedPoolGet( chained_filter_t *chained )
+{
+    const video_format_t *fmt = &chained->filter.fmt_out.video;
+
+    /* Palettes are referenced, not copied, by the pictures */
+    if( fmt->p_palette != NULL )
+        return NULL;
+
+    if( chained->pool != NULL && !video_format_IsSamePool( &chained->pool_fmt, fmt ) )
+    {
+        picture_pool_Release( chained->pool );
+        chained->pool = NULL;
+    }
+
+    if( chained->pool == NULL )
+    {
+        chained->pool = picture_pool_NewFromFormat( fmt, CHAINED_POOL_SIZE );
+        if( chained->pool == NULL )
+            return NULL;
+        chained->pool_fmt = *fmt;
+    }
+
+    return picture_pool_Get( chained->pool );
+}
+
 /** Chained filter picture allocator function */
 static picture_t *filter_chain_VideoBufferNew( filter_t *filter )
 {
     if( chained(filter)->next != NULL )
     {
-        picture_t *pic = picture_NewFromFormat( &filter->fmt_out.video );
+        picture_t *pic = ChainedPoolGet( chained(filter) );
+        if( pic == NULL ) /* all pooled pictures in use */
+            pic = picture_NewFromFormat( &filter->fmt_out.video );
         if( pic == NULL )
             msg_Err( filter, "Failed to allocate picture" );
         return pic;
@@ -238,6 +274,7 @@ static filter_t *filter_chain_AppendInner( filter_chain_t *chain,
         vlc_mouse_Init( mouse );
     chained->mouse = mouse;
     chained->pending = NULL;
+    chained->pool = NULL;
 
     msg_Dbg( parent, "Filter '%s' (%p) appended to chain",
              (name != NULL) ? name : module_get_name(filter->p_module, false),
@@ -299,6 +336,8 @@ void filter_chain_DeleteFilter( filter_chain_t *chain, filter_t *filter )
 
     msg_Dbg( obj, "Filter %p removed from chain", (void *)filter );
     FilterDeletePictures( chained->pending );
+    if( chained->pool != NULL )
+        picture_pool_Release( chained->pool );
 
     free( chained->mouse );
     es_format_Clean( &filter->fmt_out );
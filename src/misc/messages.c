@@ -41,8 +41,11 @@
 #include <vlc_interface.h>
 #include <vlc_charset.h>
 #include <vlc_modules.h>
+#include <vlc_atomic.h>
 #include "../libvlc.h"
 
+typedef struct vlc_log_ring_t vlc_log_ring_t;
+
 struct vlc_logger_t
 {
     VLC_COMMON_MEMBERS
@@ -50,21 +53,51 @@ struct vlc_logger_t
     vlc_log_cb log;
     void *sys;
     module_t *module;
+    atomic_uintptr_t ring; /* asynchronous delivery (vlc_log_ring_t *) */
+    atomic_uint ring_users; /* emitting threads that may push in the ring */
 };
 
+static void vlc_LogRingPush(vlc_log_ring_t *, int, const vlc_log_t *,
+                            const char *, va_list);
+
+static void vlc_vaLogDeliver(vlc_logger_t *logger, int type,
+                             const vlc_log_t *item, const char *format,
+                             va_list ap)
+{
+    int canc = vlc_savecancel();
+    vlc_rwlock_rdlock(&logger->lock);
+    logger->log(logger->sys, type, item, format, ap);
+    vlc_rwlock_unlock(&logger->lock);
+    vlc_restorecancel(canc);
+}
+
+static void vlc_LogDeliver(vlc_logger_t *logger, int type,
+                           const vlc_log_t *item, const char *format, ...)
+{
+    va_list ap;
+
+    va_start(ap, format);
+    vlc_vaLogDeliver(logger, type, item, format, ap);
+    va_end(ap);
+}
+
 static void vlc_vaLogCallback(libvlc_int_t *vlc, int type,
                               const vlc_log_t *item, const char *format,
                               va_list ap)
 {
     vlc_logger_t *logger = libvlc_priv(vlc)->logger;
-    int canc;
 
     assert(logger != NULL);
-    canc = vlc_savecancel();
-    vlc_rwlock_rdlock(&logger->lock);
-    logger->log(logger->sys, type, item, format, ap);
-    vlc_rwlock_unlock(&logger->lock);
-    vlc_restorecancel(canc);
+
+    /* Being counted as a user keeps the ring alive while pushing into it */
+    atomic_fetch_add(&logger->ring_users, 1);
+    vlc_log_ring_t *ring = (vlc_log_ring_t *)atomic_load(&logger->ring);
+    if (ring != NULL)
+        vlc_LogRingPush(ring, type, item, format, ap);
+    atomic_fetch_sub(&logger->ring_users, 1);
+
+    if (ring == NULL)
+        vlc_vaLogDeliver(logger, type, item, format, ap);
 }
 
 static void vlc_LogCallback(libvlc_int_t *vlc, int type, const vlc_log_t *item,
@@ -286,6 +319,215 @@ static void vlc_LogEarlyClose(vlc_logger_t *logger, void *d)
     free(sys);
 }
 
+/*
+ * Asynchronous delivery: the messages are formatted by the emitting thread
+ * into a bounded ring of preallocated slots, without locking nor allocating
+ * (unless the message is too long for its slot), and a low priority thread
+ * passes them to the logger. If the ring is full, the message is dropped and
+ * counted, rather than blocking the emitting thread.
+ *
+ * The ring is a multiple producers, single consumer array where the sequence
+ * number of each slot tells whether it is free or filled.
+ */
+#define LOG_RING_SIZE 1024 /* slots, a power of two */
+#define LOG_TEXT_SIZE 256  /* message bytes stored in a slot */
+
+typedef struct
+{
+    atomic_size_t seq;
+    int type;
+    vlc_log_t meta;
+    char module[32];
+    char header[64];
+    char *heap; /* message too long for the text, or NULL */
+    char text[LOG_TEXT_SIZE];
+} vlc_log_slot_t;
+
+struct vlc_log_ring_t
+{
+    vlc_logger_t *logger;
+    vlc_thread_t thread;
+    vlc_sem_t wait;
+    atomic_bool quit;
+
+    atomic_size_t head; /* next slot to fill */
+    size_t tail; /* next slot to deliver, owned by the thread */
+
+    atomic_ulong dropped; /* since the last report */
+    atomic_ulong dropped_total;
+    atomic_ulong overflows; /* messages longer than a slot */
+
+    vlc_log_slot_t slots[LOG_RING_SIZE];
+};
+
+static void vlc_LogRingPush(vlc_log_ring_t *ring, int type,
+                            const vlc_log_t *item, const char *format,
+                            va_list ap)
+{
+    size_t pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    vlc_log_slot_t *slot;
+
+    for (;;)
+    {
+        slot = &ring->slots[pos % LOG_RING_SIZE];
+
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+        if (diff == 0)
+        {
+            if (atomic_compare_exchange_weak_explicit(&ring->head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+        {   /* Full: the messages are emitted faster than delivered */
+            atomic_fetch_add_explicit(&ring->dropped, 1,
+                                      memory_order_relaxed);
+            atomic_fetch_add_explicit(&ring->dropped_total, 1,
+                                      memory_order_relaxed);
+            return;
+        }
+        else
+            pos = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    }
+
+    slot->type = type;
+    slot->meta = *item;
+    /* The module name and header may not outlive the call */
+    strlcpy(slot->module, item->psz_module, sizeof (slot->module));
+    slot->meta.psz_module = slot->module;
+    if (item->psz_header != NULL)
+    {
+        strlcpy(slot->header, item->psz_header, sizeof (slot->header));
+        slot->meta.psz_header = slot->header;
+    }
+
+    va_list aq;
+    va_copy(aq, ap);
+    int len = vsnprintf(slot->text, sizeof (slot->text), format, aq);
+    va_end(aq);
+
+    slot->heap = NULL;
+    if (len >= (int)sizeof (slot->text))
+    {
+        atomic_fetch_add_explicit(&ring->overflows, 1, memory_order_relaxed);
+        if (vasprintf(&slot->heap, format, ap) == -1)
+            slot->heap = NULL;
+    }
+
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    vlc_sem_post(&ring->wait);
+}
+
+static void vlc_LogRingDrain(vlc_log_ring_t *ring)
+{
+    for (;;)
+    {
+        vlc_log_slot_t *slot = &ring->slots[ring->tail % LOG_RING_SIZE];
+
+        if (atomic_load_explicit(&slot->seq, memory_order_acquire)
+             != ring->tail + 1)
+            break; /* empty, or the next message is being formatted */
+
+        vlc_LogDeliver(ring->logger, slot->type, &slot->meta, "%s",
+                       (slot->heap != NULL) ? slot->heap : slot->text);
+        free(slot->heap);
+
+        atomic_store_explicit(&slot->seq, ring->tail + LOG_RING_SIZE,
+                              memory_order_release);
+        ring->tail++;
+    }
+
+    unsigned long dropped = atomic_exchange_explicit(&ring->dropped, 0,
+                                                     memory_order_relaxed);
+    if (dropped > 0)
+    {
+        const vlc_log_t meta = {
+            .i_object_id = (uintptr_t)ring->logger,
+            .psz_object_type = "logger",
+            .psz_module = "core",
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .tid = vlc_thread_id(),
+        };
+        vlc_LogDeliver(ring->logger, VLC_MSG_WARN, &meta,
+                       "%lu log messages dropped", dropped);
+    }
+}
+
+static void *vlc_LogRingThread(void *data)
+{
+    vlc_log_ring_t *ring = data;
+
+    do
+    {
+        vlc_sem_wait(&ring->wait);
+        vlc_LogRingDrain(ring);
+    }
+    while (!atomic_load(&ring->quit));
+
+    return NULL;
+}
+
+static vlc_log_ring_t *vlc_LogRingStart(vlc_logger_t *logger)
+{
+    vlc_log_ring_t *ring = malloc(sizeof (*ring));
+    if (unlikely(ring == NULL))
+        return NULL;
+
+    ring->logger = logger;
+    vlc_sem_init(&ring->wait, 0);
+    atomic_init(&ring->quit, false);
+    atomic_init(&ring->head, 0);
+    ring->tail = 0;
+    atomic_init(&ring->dropped, 0);
+    atomic_init(&ring->dropped_total, 0);
+    atomic_init(&ring->overflows, 0);
+    for (size_t i = 0; i < LOG_RING_SIZE; i++)
+        atomic_init(&ring->slots[i].seq, i);
+
+    if (vlc_clone(&ring->thread, vlc_LogRingThread, ring,
+                  VLC_THREAD_PRIORITY_LOW))
+    {
+        vlc_sem_destroy(&ring->wait);
+        free(ring);
+        return NULL;
+    }
+    return ring;
+}
+
+static void vlc_LogRingStop(vlc_log_ring_t *ring)
+{
+    atomic_store(&ring->quit, true);
+    vlc_sem_post(&ring->wait);
+    vlc_join(ring->thread, NULL);
+
+    /* Deliver what was emitted while the thread was exiting */
+    vlc_LogRingDrain(ring);
+
+    const vlc_log_t meta = {
+        .i_object_id = (uintptr_t)ring->logger,
+        .psz_object_type = "logger",
+        .psz_module = "core",
+        .file = __FILE__,
+        .line = __LINE__,
+        .func = __func__,
+        .tid = vlc_thread_id(),
+    };
+    vlc_LogDeliver(ring->logger, VLC_MSG_DBG, &meta,
+                   "%zu log messages delivered asynchronously, %lu dropped, "
+                   "%lu too long for the ring", ring->tail,
+                   atomic_load(&ring->dropped_total),
+                   atomic_load(&ring->overflows));
+
+    vlc_sem_destroy(&ring->wait);
+    free(ring);
+}
+
 static void vlc_vaLogDiscard(void *d, int type, const vlc_log_t *item,
                              const char *format, va_list ap)
 {
@@ -330,6 +572,8 @@ int vlc_LogPreinit(libvlc_int_t *vlc)
         return -1;
 
     vlc_rwlock_init(&logger->lock);
+    atomic_init(&logger->ring, (uintptr_t)NULL);
+    atomic_init(&logger->ring_users, 0);
 
     if (vlc_LogEarlyOpen(logger))
     {
@@ -379,6 +623,14 @@ int vlc_LogInit(libvlc_int_t *vlc)
     if (early_sys != NULL)
         vlc_LogEarlyClose(logger, early_sys);
 
+    /* From now on, the emitting threads do not wait for the logger */
+    if (var_InheritBool(vlc, "log-async"))
+    {
+        vlc_log_ring_t *ring = vlc_LogRingStart(logger);
+
+        atomic_store(&logger->ring, (uintptr_t)ring);
+    }
+
     return 0;
 }
 
@@ -426,6 +678,16 @@ void vlc_LogDeinit(libvlc_int_t *vlc)
     if (unlikely(logger == NULL))
         return;
 
+    /* Retire the ring once no emitting thread can still push into it */
+    vlc_log_ring_t *ring =
+        (vlc_log_ring_t *)atomic_exchange(&logger->ring, (uintptr_t)NULL);
+    if (ring != NULL)
+    {
+        while (atomic_load(&logger->ring_users) > 0)
+            msleep(VLC_HARD_MIN_SLEEP);
+        vlc_LogRingStop(ring);
+    }
+
     if (logger->module != NULL)
         vlc_module_unload(logger->module, vlc_logger_unload, logger->sys);
     else
@@ -212,6 +212,7 @@ playlist_t *playlist_Create( vlc_object_t *p_parent )
 
     p->input_tree = NULL;
     p->id_tree = NULL;
+    p->search = playlist_SearchIndexNew();
 
     TAB_INIT( pl_priv(p_playlist)->i_sds, pl_priv(p_playlist)->pp_sds );
 
@@ -336,6 +337,8 @@ void playlist_Destroy( playlist_t *p_playlist )
     playlist_NodeDelete( p_playlist, p_playlist->p_root, true );
     PL_UNLOCK;
 
+    playlist_SearchIndexDelete( p_sys->search );
+
     vlc_cond_destroy( &p_sys->signal );
     vlc_mutex_destroy( &p_sys->lock );
 
@@ -44,8 +44,7 @@ static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item );
 
 static int RecursiveAddIntoParent (
                 playlist_t *p_playlist, playlist_item_t *p_parent,
-                input_item_node_t *p_node, int i_pos, bool b_flat,
-                playlist_item_t **pp_first_leaf );
+                input_item_node_t *p_node, int i_pos, bool b_flat );
 static int RecursiveInsertCopy (
                 playlist_t *p_playlist, playlist_item_t *p_item,
                 playlist_item_t *p_parent, int i_pos, bool b_flat );
@@ -212,6 +211,11 @@ static void input_item_changed( const vlc_event_t * p_event,
 {
     playlist_t *p_playlist = user_data;
 
+    if( p_event->type == vlc_InputItemMetaChanged
+     || p_event->type == vlc_InputItemNameChanged )
+        playlist_SearchIndexChanged( pl_priv(p_playlist)->search,
+                                     p_event->p_obj );
+
     var_SetAddress( p_playlist, "item-change", p_event->p_obj );
 }
 
@@ -288,6 +292,7 @@ playlist_item_t *playlist_ItemNewFromInput( playlist_t *p_playlist,
 
     p->i_last_playlist_id = p_item->i_id;
     vlc_gc_incref( p_item->p_input );
+    playlist_SearchIndexAdd( p->search, p_input );
 
     vlc_event_manager_t *p_em = &p_item->p_input->event_manager;
 
@@ -341,6 +346,7 @@ void playlist_ItemRelease( playlist_t *p_playlist, playlist_item_t *p_item )
     vlc_event_detach( p_em, vlc_InputItemErrorWhenReadingChanged,
                       input_item_changed, p_playlist );
 
+    playlist_SearchIndexRemove( p->search, p_item->p_input );
     vlc_gc_decref( p_item->p_input );
 
     tdelete( p_item, &p->input_tree, playlist_ItemCmpInput );
@@ -415,8 +421,8 @@ void playlist_Clear( playlist_t * p_playlist, bool b_locked )
 
     PL_LOCK_IF( !b_locked );
 
-    for( int i = p_root->i_children - 1; i >= 0 ;i-- )
-        playlist_NodeDelete( p_playlist, p_root->pp_children[i], false );
+    playlist_NodesDelete( p_playlist, p_root->pp_children, p_root->i_children,
+                          false );
 
     PL_UNLOCK_IF( !b_locked );
 }
@@ -583,8 +589,7 @@ int playlist_InsertInputItemTree (
     playlist_t *p_playlist, playlist_item_t *p_parent,
     input_item_node_t *p_node, int i_pos, bool b_flat )
 {
-    playlist_item_t *p_first_leaf = NULL;
-    return RecursiveAddIntoParent ( p_playlist, p_parent, p_node, i_pos, b_flat, &p_first_leaf );
+    return RecursiveAddIntoParent ( p_playlist, p_parent, p_node, i_pos, b_flat );
 }
 
 
@@ -662,6 +667,7 @@ int playlist_TreeMove( playlist_t * p_playlist, playlist_item_t *p_item,
 
     INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
     p_item->p_parent = p_node;
+    playlist_SearchIndexTreeChanged( pl_priv(p_playlist)->search );
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
@@ -687,21 +693,18 @@ int playlist_TreeMoveMany( playlist_t *p_playlist,
     PL_ASSERT_LOCKED;
 
     if ( p_node->i_children == -1 ) return VLC_EGENERIC;
+    if ( i_items <= 0 ) return VLC_SUCCESS;
 
-    for( int i = 0; i < i_items; i++ )
-    {
-        playlist_item_t *p_item = pp_items[i];
-        int i_index = ItemIndex( p_item );
-        playlist_item_t *p_parent = p_item->p_parent;
-        REMOVE_ELEM( p_parent->pp_children, p_parent->i_children, i_index );
-        if ( p_parent == p_node && i_index < i_newpos ) i_newpos--;
-    }
-    for( int i = i_items - 1; i >= 0; i-- )
-    {
-        playlist_item_t *p_item = pp_items[i];
-        INSERT_ELEM( p_node->pp_children, p_node->i_children, i_newpos, p_item );
-        p_item->p_parent = p_node;
-    }
+    playlist_item_t **pp_sorted = malloc( i_items * sizeof(*pp_sorted) );
+    if( unlikely(pp_sorted == NULL) )
+        return VLC_ENOMEM;
+    memcpy( pp_sorted, pp_items, i_items * sizeof(*pp_sorted) );
+    qsort( pp_sorted, i_items, sizeof(*pp_sorted), playlist_ItemCmpPtr );
+
+    playlist_ItemsDetach( pp_sorted, i_items, p_node, &i_newpos );
+    free( pp_sorted );
+
+    playlist_NodeAttachMany( p_playlist, pp_items, i_items, p_node, i_newpos );
 
     pl_priv( p_playlist )->b_reset_currently_playing = true;
     vlc_cond_signal( &pl_priv( p_playlist )->signal );
@@ -813,53 +816,94 @@ static void ChangeToNode( playlist_t *p_playlist, playlist_item_t *p_item )
         ARRAY_REMOVE( p_playlist->items, i );
 }
 
-static int RecursiveAddIntoParent (
-    playlist_t *p_playlist, playlist_item_t *p_parent,
-    input_item_node_t *p_node, int i_pos, bool b_flat,
-    playlist_item_t **pp_first_leaf )
+/* Create the playlist items of the children of an input item node, and of
+ * their own children, without inserting nor announcing them yet */
+static void RecursiveCreateItems( playlist_t *p_playlist,
+                                  input_item_node_t *p_node, bool b_flat,
+                                  uint8_t i_flags,
+                                  playlist_item_array_t *p_items )
 {
-    *pp_first_leaf = NULL;
-
-    if( p_parent->i_children == -1 ) ChangeToNode( p_playlist, p_parent );
-
-    if( i_pos == PLAYLIST_END ) i_pos = p_parent->i_children;
-
     for( int i = 0; i < p_node->i_children; i++ )
     {
         input_item_node_t *p_child_node = p_node->pp_children[i];
-
-        playlist_item_t *p_new_item = NULL;
         bool b_children = p_child_node->i_children > 0;
 
-        //Create the playlist item represented by input node, if allowed.
-        if( !(b_flat && b_children) )
+        //If flat, put the children in place of the node
+        if( b_flat && b_children )
         {
-            p_new_item = playlist_NodeAddInput( p_playlist,
-                                                p_child_node->p_item,
-                                                p_parent, 0, i_pos );
-            if( !p_new_item ) return i_pos;
-
-            i_pos++;
+            RecursiveCreateItems( p_playlist, p_child_node, true, i_flags,
+                                  p_items );
+            continue;
         }
-        //Recurse if any children
-        if( b_children )
+
+        playlist_item_t *p_new_item =
+            playlist_ItemNewFromInput( p_playlist, p_child_node->p_item );
+        if( !p_new_item ) return;
+
+        p_new_item->i_flags |= i_flags;
+        ARRAY_APPEND( (*p_items), p_new_item );
+
+        if( !b_children )
         {
-            //Substitute p_new_item for first child leaf
-            //(If flat, continue counting from current position)
-            int i_last_pos = RecursiveAddIntoParent(
-                    p_playlist,
-                    p_new_item ? p_new_item : p_parent,
-                    p_child_node,
-                    ( b_flat ? i_pos : 0 ),
-                    b_flat,
-                    &p_new_item );
-            //If flat, take position after recursion as current position
-            if( b_flat ) i_pos = i_last_pos;
+            ARRAY_APPEND( p_playlist->items, p_new_item );
+            continue;
         }
 
-        assert( p_new_item != NULL );
-        if( i == 0 ) *pp_first_leaf = p_new_item;
+        input_item_t *p_input = p_new_item->p_input;
+        vlc_mutex_lock( &p_input->lock );
+        p_input->i_type = ITEM_TYPE_NODE;
+        vlc_mutex_unlock( &p_input->lock );
+
+        playlist_item_array_t children;
+        ARRAY_INIT( children );
+        RecursiveCreateItems( p_playlist, p_child_node, false,
+                              p_new_item->i_flags & (PLAYLIST_RO_FLAG | PLAYLIST_SKIP_FLAG),
+                              &children );
+
+        p_new_item->i_children = 0;
+        playlist_NodeInsertMany( p_playlist, children.p_elems, children.i_size,
+                                 p_new_item, 0 );
+        ARRAY_RESET( children );
     }
+}
+
+/* Announce a new item and its children */
+static void RecursiveNotify( playlist_t *p_playlist, playlist_item_t *p_item )
+{
+    playlist_SendAddNotify( p_playlist, p_item );
+    GoAndPreparse( p_playlist, 0, p_item );
+
+    /* The item was turned into a node, see ChangeToNode() */
+    if( p_item->i_children >= 0 )
+        var_SetAddress( p_playlist, "item-change", p_item->p_input );
+
+    for( int i = 0; i < p_item->i_children; i++ )
+        RecursiveNotify( p_playlist, p_item->pp_children[i] );
+}
+
+static int RecursiveAddIntoParent (
+    playlist_t *p_playlist, playlist_item_t *p_parent,
+    input_item_node_t *p_node, int i_pos, bool b_flat )
+{
+    if( p_parent->i_children == -1 ) ChangeToNode( p_playlist, p_parent );
+
+    if( i_pos == PLAYLIST_END ) i_pos = p_parent->i_children;
+
+    /* Build the whole tree first, so that it is inserted at once */
+    playlist_item_array_t items;
+    ARRAY_INIT( items );
+    RecursiveCreateItems( p_playlist, p_node, b_flat,
+                          ( p_parent->i_flags & PLAYLIST_NO_INHERIT_FLAG ) ? 0 :
+                          p_parent->i_flags & (PLAYLIST_RO_FLAG | PLAYLIST_SKIP_FLAG),
+                          &items );
+
+    playlist_NodeInsertMany( p_playlist, items.p_elems, items.i_size,
+                             p_parent, i_pos );
+    for( int i = 0; i < items.i_size; i++ )
+        RecursiveNotify( p_playlist, items.p_elems[i] );
+
+    i_pos += items.i_size;
+    ARRAY_RESET( items );
     return i_pos;
 }
 
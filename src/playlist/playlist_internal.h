@@ -41,6 +41,7 @@
 #include "preparser.h"
 
 typedef struct vlc_sd_internal_t vlc_sd_internal_t;
+typedef struct playlist_search_t playlist_search_t;
 
 void playlist_ServicesDiscoveryKillAll( playlist_t *p_playlist );
 
@@ -52,6 +53,7 @@ typedef struct playlist_private_t
     void *input_tree; /**< Search tree for input item
                            to playlist item mapping */
     void *id_tree; /**< Search tree for item ID to item mapping */
+    playlist_search_t *search; /**< Live search index */
 
     vlc_sd_internal_t   **pp_sds;
     int                   i_sds;   /**< Number of service discovery modules */
@@ -126,12 +128,27 @@ int playlist_InsertInputItemTree ( playlist_t *,
 /* Tree walking */
 int playlist_NodeInsert(playlist_t *, playlist_item_t*, playlist_item_t *,
                         int);
+int playlist_NodeInsertMany(playlist_t *, playlist_item_t *const *, int,
+                            playlist_item_t *, int);
+void playlist_NodeAttachMany(playlist_t *, playlist_item_t *const *, int,
+                             playlist_item_t *, int);
+int playlist_ItemCmpPtr(const void *, const void *);
+void playlist_ItemsDetach(playlist_item_t *const *, size_t,
+                          playlist_item_t *, int *);
 
 playlist_item_t *playlist_ItemFindFromInputAndRoot( playlist_t *p_playlist,
                               input_item_t *p_input, playlist_item_t *p_root );
 
 void playlist_ItemRelease( playlist_t *, playlist_item_t * );
 
+/* Live search index */
+playlist_search_t *playlist_SearchIndexNew( void );
+void playlist_SearchIndexDelete( playlist_search_t * );
+void playlist_SearchIndexAdd( playlist_search_t *, input_item_t * );
+void playlist_SearchIndexRemove( playlist_search_t *, input_item_t * );
+void playlist_SearchIndexChanged( playlist_search_t *, input_item_t * );
+void playlist_SearchIndexTreeChanged( playlist_search_t * );
+
 void ResetCurrentlyPlaying( playlist_t *p_playlist, playlist_item_t *p_cur );
 void ResyncCurrentIndex( playlist_t *p_playlist, playlist_item_t *p_cur );
 
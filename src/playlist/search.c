@@ -24,6 +24,8 @@
 # include "config.h"
 #endif
 #include <assert.h>
+#include <search.h>
+#include <wctype.h>
 
 #include <vlc_common.h>
 #include <vlc_playlist.h>
@@ -34,6 +36,510 @@
  * Item search functions
  ***************************************************************************/
 
+/*
+ * The search index maps every trigram of lower case code points found in
+ * the title, album and artist of the items to the input items having it.
+ * A search only checks the items having the rarest trigram of the string.
+ *
+ * Entries are never removed from the trigram lists: the items removed or
+ * changed since they were indexed are filtered out when checking the
+ * candidates, and the lists are rebuilt once they hold too many of them.
+ *
+ * The ids of the items enabled by the last indexed search are kept, so that
+ * the next search of the same root only flags the items whose state changed.
+ * They are dropped when items are inserted or moved in the tree.
+ *
+ * The hash table of the trigram lists grows with their number.
+ */
+#define SEARCH_MIN_BUCKETS 256
+#define SEARCH_MIN_REBUILD 4096
+
+typedef struct search_key_t search_key_t;
+struct search_key_t
+{
+    input_item_t *p_input;
+    unsigned      i_refs;     /* playlist items of the input */
+    search_key_t *p_prev, *p_next;
+    uint32_t     *p_text;     /* lower case fields separated by 0 */
+    size_t        i_text;
+    size_t        i_trigrams; /* distinct trigrams */
+    unsigned      i_mark;     /* last search that matched it */
+    bool          b_dirty;    /* meta changed since indexed */
+};
+
+typedef struct search_list_t search_list_t;
+struct search_list_t
+{
+    search_list_t *p_next;
+    uint64_t       i_trigram;
+    size_t         i_count, i_size;
+    input_item_t **pp_inputs;
+};
+
+struct playlist_search_t
+{
+    vlc_mutex_t    lock; /* against input item events */
+    void          *key_tree; /* input item to search_key_t */
+    search_key_t  *p_first;
+    search_key_t **pp_dirty;
+    size_t         i_dirty, i_dirty_size;
+
+    search_list_t **pp_buckets;
+    size_t         i_buckets;
+    size_t         i_lists;
+    size_t         i_entries; /* in all the lists */
+    size_t         i_stale; /* entries of removed or changed keys */
+    bool           b_failed; /* an entry could not be stored */
+    bool           b_lost; /* a change could not be recorded */
+    unsigned       i_mark;
+
+    /* Items enabled by the last indexed live search, by increasing id */
+    int           *pi_enabled;
+    size_t         i_enabled;
+    int            i_enabled_root; /* -1 if the ids are not valid */
+    bool           b_enabled_recursive;
+};
+
+static int SearchKeyCmp( const void *a, const void *b )
+{
+    const search_key_t *ka = a, *kb = b;
+
+    if( ka->p_input == kb->p_input )
+        return 0;
+    return ((uintptr_t)ka->p_input > (uintptr_t)kb->p_input) ? +1 : -1;
+}
+
+static search_key_t *SearchKeyGet( playlist_search_t *p_search,
+                                   input_item_t *p_input )
+{
+    search_key_t key = { .p_input = p_input };
+    search_key_t **pp = tfind( &key, &p_search->key_tree, SearchKeyCmp );
+    return pp != NULL ? *pp : NULL;
+}
+
+/**
+ * Appends the lower case code points of a string, as compared by
+ * vlc_strcasestr(), and a 0 separator.
+ */
+static int SearchFold( uint32_t **pp_text, size_t *pi_text, size_t *pi_size,
+                       const char *psz )
+{
+    for( ;; )
+    {
+        uint32_t cp = 0;
+        size_t n = psz != NULL ? vlc_towc( psz, &cp ) : 0;
+
+        if( n == (size_t)-1 )
+            cp = 0; /* vlc_strcasestr() stops there too */
+
+        if( *pi_text == *pi_size )
+        {
+            size_t i_size = *pi_size ? *pi_size * 2 : 64;
+            uint32_t *p_text = realloc( *pp_text, i_size * sizeof(*p_text) );
+            if( unlikely(p_text == NULL) )
+                return VLC_ENOMEM;
+            *pp_text = p_text;
+            *pi_size = i_size;
+        }
+        (*pp_text)[(*pi_text)++] = towlower( cp );
+
+        if( cp == 0 )
+            return VLC_SUCCESS;
+        psz += n;
+    }
+}
+
+static uint64_t SearchTrigram( const uint32_t *p )
+{
+    /* Code points fit in 21 bits */
+    return ((uint64_t)p[0] << 42) | ((uint64_t)p[1] << 21) | p[2];
+}
+
+static bool SearchTrigramValid( const uint32_t *p )
+{
+    return p[0] != 0 && p[1] != 0 && p[2] != 0;
+}
+
+static size_t SearchBucket( uint64_t i_trigram, size_t i_buckets )
+{
+    return (i_trigram ^ (i_trigram >> 21) ^ (i_trigram >> 37)) % i_buckets;
+}
+
+/**
+ * Doubles the number of buckets, keeping the current ones on failure.
+ */
+static void SearchBucketsGrow( playlist_search_t *p_search )
+{
+    size_t i_buckets = p_search->i_buckets ? p_search->i_buckets * 2
+                                           : SEARCH_MIN_BUCKETS;
+    search_list_t **pp_buckets = calloc( i_buckets, sizeof(*pp_buckets) );
+    if( unlikely(pp_buckets == NULL) )
+        return;
+
+    for( size_t i = 0; i < p_search->i_buckets; i++ )
+    {
+        search_list_t *p_list = p_search->pp_buckets[i];
+        while( p_list != NULL )
+        {
+            search_list_t *p_next = p_list->p_next;
+            search_list_t **pp =
+                &pp_buckets[SearchBucket( p_list->i_trigram, i_buckets )];
+            p_list->p_next = *pp;
+            *pp = p_list;
+            p_list = p_next;
+        }
+    }
+    free( p_search->pp_buckets );
+    p_search->pp_buckets = pp_buckets;
+    p_search->i_buckets = i_buckets;
+}
+
+static search_list_t *SearchListGet( playlist_search_t *p_search,
+                                     uint64_t i_trigram, bool b_create )
+{
+    if( b_create && p_search->i_lists >= p_search->i_buckets )
+        SearchBucketsGrow( p_search );
+    if( p_search->i_buckets == 0 )
+        return NULL;
+
+    search_list_t **pp = &p_search->pp_buckets[
+        SearchBucket( i_trigram, p_search->i_buckets )];
+
+    for( search_list_t *p_list = *pp; p_list != NULL; p_list = p_list->p_next )
+        if( p_list->i_trigram == i_trigram )
+            return p_list;
+
+    if( !b_create )
+        return NULL;
+
+    search_list_t *p_list = calloc( 1, sizeof(*p_list) );
+    if( unlikely(p_list == NULL) )
+        return NULL;
+    p_list->i_trigram = i_trigram;
+    p_list->p_next = *pp;
+    *pp = p_list;
+    p_search->i_lists++;
+    return p_list;
+}
+
+static int SearchTrigramCmp( const void *a, const void *b )
+{
+    const uint64_t ta = *(const uint64_t *)a, tb = *(const uint64_t *)b;
+    return (ta > tb) - (ta < tb);
+}
+
+/**
+ * Adds the item of a key to the lists of its distinct trigrams.
+ */
+static void SearchKeyIndex( playlist_search_t *p_search, search_key_t *p_key )
+{
+    size_t i_count = 0;
+    uint64_t *p_trigrams = p_key->i_text >= 3 ?
+        malloc( (p_key->i_text - 2) * sizeof(*p_trigrams) ) : NULL;
+
+    p_key->i_trigrams = 0;
+    if( p_trigrams == NULL )
+    {
+        if( p_key->i_text >= 3 )
+            p_search->b_failed = true;
+        return;
+    }
+
+    for( size_t i = 0; i + 2 < p_key->i_text; i++ )
+        if( SearchTrigramValid( &p_key->p_text[i] ) )
+            p_trigrams[i_count++] = SearchTrigram( &p_key->p_text[i] );
+    qsort( p_trigrams, i_count, sizeof(*p_trigrams), SearchTrigramCmp );
+
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        if( i > 0 && p_trigrams[i] == p_trigrams[i - 1] )
+            continue;
+
+        search_list_t *p_list = SearchListGet( p_search, p_trigrams[i], true );
+        if( unlikely(p_list == NULL) )
+        {
+            p_search->b_failed = true;
+            break;
+        }
+        if( p_list->i_count == p_list->i_size )
+        {
+            size_t i_size = p_list->i_size ? p_list->i_size * 2 : 4;
+            input_item_t **pp = realloc( p_list->pp_inputs,
+                                         i_size * sizeof(*pp) );
+            if( unlikely(pp == NULL) )
+            {
+                p_search->b_failed = true;
+                break;
+            }
+            p_list->pp_inputs = pp;
+            p_list->i_size = i_size;
+        }
+        p_list->pp_inputs[p_list->i_count++] = p_key->p_input;
+        p_key->i_trigrams++;
+        p_search->i_entries++;
+    }
+    free( p_trigrams );
+}
+
+/**
+ * Reads the searched meta of the item of a key.
+ */
+static void SearchKeyFill( search_key_t *p_key )
+{
+    input_item_t *p_input = p_key->p_input;
+    size_t i_size = 0;
+    int i_ret;
+
+    free( p_key->p_text );
+    p_key->p_text = NULL;
+    p_key->i_text = 0;
+
+    vlc_mutex_lock( &p_input->lock );
+    if( p_input->p_meta )
+    {
+        // Use Title or fall back to psz_name
+        const char *psz_title = vlc_meta_Get( p_input->p_meta, vlc_meta_Title );
+        if( !psz_title )
+            psz_title = p_input->psz_name;
+        i_ret = SearchFold( &p_key->p_text, &p_key->i_text, &i_size, psz_title );
+        if( i_ret == VLC_SUCCESS )
+            i_ret = SearchFold( &p_key->p_text, &p_key->i_text, &i_size,
+                        vlc_meta_Get( p_input->p_meta, vlc_meta_Album ) );
+        if( i_ret == VLC_SUCCESS )
+            i_ret = SearchFold( &p_key->p_text, &p_key->i_text, &i_size,
+                        vlc_meta_Get( p_input->p_meta, vlc_meta_Artist ) );
+    }
+    else
+        i_ret = SearchFold( &p_key->p_text, &p_key->i_text, &i_size,
+                            p_input->psz_name );
+    vlc_mutex_unlock( &p_input->lock );
+
+    if( i_ret != VLC_SUCCESS )
+        p_key->i_text = 0;
+}
+
+static void SearchListsClear( playlist_search_t *p_search )
+{
+    for( size_t i = 0; i < p_search->i_buckets; i++ )
+    {
+        search_list_t *p_list = p_search->pp_buckets[i];
+        while( p_list != NULL )
+        {
+            search_list_t *p_next = p_list->p_next;
+            free( p_list->pp_inputs );
+            free( p_list );
+            p_list = p_next;
+        }
+    }
+    free( p_search->pp_buckets );
+    p_search->pp_buckets = NULL;
+    p_search->i_buckets = 0;
+    p_search->i_lists = 0;
+    p_search->i_entries = 0;
+    p_search->i_stale = 0;
+    p_search->b_failed = false;
+}
+
+playlist_search_t *playlist_SearchIndexNew( void )
+{
+    playlist_search_t *p_search = calloc( 1, sizeof(*p_search) );
+    if( unlikely(p_search == NULL) )
+        return NULL;
+    vlc_mutex_init( &p_search->lock );
+    p_search->i_enabled_root = -1;
+    return p_search;
+}
+
+void playlist_SearchIndexDelete( playlist_search_t *p_search )
+{
+    if( p_search == NULL )
+        return;
+
+    while( p_search->p_first != NULL )
+    {
+        search_key_t *p_key = p_search->p_first;
+        p_search->p_first = p_key->p_next;
+        tdelete( p_key, &p_search->key_tree, SearchKeyCmp );
+        free( p_key->p_text );
+        free( p_key );
+    }
+    SearchListsClear( p_search );
+    free( p_search->pp_dirty );
+    free( p_search->pi_enabled );
+    vlc_mutex_destroy( &p_search->lock );
+    free( p_search );
+}
+
+void playlist_SearchIndexAdd( playlist_search_t *p_search, input_item_t *p_input )
+{
+    if( p_search == NULL )
+        return;
+
+    /* Several playlist items can share the input, and its key */
+    vlc_mutex_lock( &p_search->lock );
+    search_key_t *p_key = SearchKeyGet( p_search, p_input );
+    if( p_key != NULL )
+        p_key->i_refs++;
+    vlc_mutex_unlock( &p_search->lock );
+    if( p_key != NULL )
+        return;
+
+    p_key = calloc( 1, sizeof(*p_key) );
+    if( unlikely(p_key == NULL) )
+        return;
+    p_key->p_input = p_input;
+    p_key->i_refs = 1;
+    SearchKeyFill( p_key );
+
+    vlc_mutex_lock( &p_search->lock );
+    search_key_t **pp = tsearch( p_key, &p_search->key_tree, SearchKeyCmp );
+    if( unlikely(pp == NULL || *pp != p_key) )
+    {
+        vlc_mutex_unlock( &p_search->lock );
+        free( p_key->p_text );
+        free( p_key );
+        return;
+    }
+    p_key->p_next = p_search->p_first;
+    if( p_key->p_next != NULL )
+        p_key->p_next->p_prev = p_key;
+    p_search->p_first = p_key;
+    vlc_mutex_unlock( &p_search->lock );
+
+    SearchKeyIndex( p_search, p_key );
+}
+
+void playlist_SearchIndexRemove( playlist_search_t *p_search,
+                                 input_item_t *p_input )
+{
+    if( p_search == NULL )
+        return;
+
+    vlc_mutex_lock( &p_search->lock );
+    search_key_t *p_key = SearchKeyGet( p_search, p_input );
+    if( p_key == NULL || --p_key->i_refs > 0 )
+    {
+        vlc_mutex_unlock( &p_search->lock );
+        return;
+    }
+    tdelete( p_key, &p_search->key_tree, SearchKeyCmp );
+    if( p_key->b_dirty )
+    {
+        for( size_t i = 0; i < p_search->i_dirty; i++ )
+            if( p_search->pp_dirty[i] == p_key )
+            {
+                p_search->pp_dirty[i] = p_search->pp_dirty[--p_search->i_dirty];
+                break;
+            }
+    }
+    vlc_mutex_unlock( &p_search->lock );
+
+    if( p_key->p_prev != NULL )
+        p_key->p_prev->p_next = p_key->p_next;
+    else
+        p_search->p_first = p_key->p_next;
+    if( p_key->p_next != NULL )
+        p_key->p_next->p_prev = p_key->p_prev;
+
+    p_search->i_stale += p_key->i_trigrams;
+    free( p_key->p_text );
+    free( p_key );
+}
+
+/**
+ * Forgets the items enabled by the last live search, as items were inserted
+ * in the tree with their flags unset. This is called with the playlist lock.
+ */
+void playlist_SearchIndexTreeChanged( playlist_search_t *p_search )
+{
+    if( p_search != NULL )
+        p_search->i_enabled_root = -1;
+}
+
+/**
+ * Marks the item of an input as to be indexed again. This is called from
+ * input item events, without the playlist lock.
+ */
+void playlist_SearchIndexChanged( playlist_search_t *p_search,
+                                  input_item_t *p_input )
+{
+    if( p_search == NULL )
+        return;
+
+    vlc_mutex_lock( &p_search->lock );
+    search_key_t *p_key = SearchKeyGet( p_search, p_input );
+    if( p_key != NULL && !p_key->b_dirty )
+    {
+        if( p_search->i_dirty == p_search->i_dirty_size )
+        {
+            size_t i_size = p_search->i_dirty_size ?
+                            p_search->i_dirty_size * 2 : 16;
+            search_key_t **pp = realloc( p_search->pp_dirty,
+                                         i_size * sizeof(*pp) );
+            if( unlikely(pp == NULL) )
+            {
+                p_search->b_lost = true;
+                goto out;
+            }
+            p_search->pp_dirty = pp;
+            p_search->i_dirty_size = i_size;
+        }
+        p_search->pp_dirty[p_search->i_dirty++] = p_key;
+        p_key->b_dirty = true;
+    }
+out:
+    vlc_mutex_unlock( &p_search->lock );
+}
+
+/**
+ * Brings the index up to date before a search.
+ */
+static void SearchIndexUpdate( playlist_search_t *p_search )
+{
+    vlc_mutex_lock( &p_search->lock );
+    while( p_search->i_dirty > 0 )
+    {
+        search_key_t *p_key = p_search->pp_dirty[--p_search->i_dirty];
+        p_key->b_dirty = false;
+        vlc_mutex_unlock( &p_search->lock );
+
+        /* Entries of the previous meta are left stale */
+        p_search->i_stale += p_key->i_trigrams;
+        SearchKeyFill( p_key );
+        SearchKeyIndex( p_search, p_key );
+
+        vlc_mutex_lock( &p_search->lock );
+    }
+    bool b_failed = p_search->b_failed || p_search->b_lost;
+    p_search->b_lost = false;
+    vlc_mutex_unlock( &p_search->lock );
+
+    if( b_failed || ( p_search->i_stale > SEARCH_MIN_REBUILD &&
+                      p_search->i_stale > p_search->i_entries / 2 ) )
+    {
+        SearchListsClear( p_search );
+        for( search_key_t *p_key = p_search->p_first; p_key != NULL;
+             p_key = p_key->p_next )
+        {
+            if( b_failed )
+                SearchKeyFill( p_key );
+            SearchKeyIndex( p_search, p_key );
+        }
+    }
+}
+
+static bool SearchKeyMatch( const search_key_t *p_key,
+                            const uint32_t *p_string, size_t i_string )
+{
+    if( p_key->i_text < i_string )
+        return false;
+    for( size_t i = 0; i + i_string <= p_key->i_text; i++ )
+        if( !memcmp( &p_key->p_text[i], p_string,
+                     i_string * sizeof(*p_string) ) )
+            return true;
+    return false;
+}
+
 /***************************************************************************
  * Live search handling
  ***************************************************************************/
@@ -53,6 +559,21 @@ static void playlist_LiveSearchClean( playlist_item_t *p_root )
     }
 }
 
+/**
+ * Disable all items in the playlist
+ * @param p_root: the current root item
+ */
+static void playlist_LiveSearchDisable( playlist_item_t *p_root )
+{
+    for( int i = 0; i < p_root->i_children; i++ )
+    {
+        playlist_item_t *p_item = p_root->pp_children[i];
+        if( p_item->i_children >= 0 )
+            playlist_LiveSearchDisable( p_item );
+        p_item->i_flags |= PLAYLIST_DBL_FLAG;
+    }
+}
+
 
 /**
  * Enable/Disable items in the playlist according to the search argument
@@ -109,6 +630,184 @@ static bool playlist_LiveSearchUpdateInternal( playlist_item_t *p_root,
 
 
 
+static int SearchItemCmpId( const void *a, const void *b )
+{
+    const playlist_item_t *ia = *(playlist_item_t *const *)a;
+    const playlist_item_t *ib = *(playlist_item_t *const *)b;
+
+    return (ia->i_id > ib->i_id) - (ia->i_id < ib->i_id);
+}
+
+static int SearchEnabledAppend( playlist_item_t ***ppp_items, size_t *pi_items,
+                                size_t *pi_size, playlist_item_t *p_item )
+{
+    if( *pi_items == *pi_size )
+    {
+        size_t i_size = *pi_size ? *pi_size * 2 : 64;
+        playlist_item_t **pp = realloc( *ppp_items, i_size * sizeof(*pp) );
+        if( unlikely(pp == NULL) )
+            return VLC_ENOMEM;
+        *ppp_items = pp;
+        *pi_size = i_size;
+    }
+    (*ppp_items)[(*pi_items)++] = p_item;
+    return VLC_SUCCESS;
+}
+
+/**
+ * Enables the items matching the search string with the index, and the nodes
+ * between them and the root, then disables the others
+ * @return false if the index cannot be used for that string
+ */
+static bool playlist_LiveSearchIndexed( playlist_t *p_playlist,
+                                        playlist_item_t *p_root,
+                                        const char *psz_string, bool b_recursive )
+{
+    playlist_search_t *p_search = pl_priv(p_playlist)->search;
+    uint32_t *p_string = NULL;
+    size_t i_string = 0, i_size = 0;
+
+    /* vlc_strcasestr() never matches an invalid string */
+    if( p_search == NULL || !IsUTF8( psz_string ) )
+        return false;
+    if( SearchFold( &p_string, &i_string, &i_size, psz_string ) )
+        return false;
+    i_string--; /* separator */
+    if( i_string < 3 )
+    {
+        free( p_string );
+        return false;
+    }
+
+    SearchIndexUpdate( p_search );
+    if( p_search->b_failed )
+    {
+        free( p_string );
+        return false;
+    }
+
+    /* Only the items having the rarest trigram can match */
+    search_list_t *p_rarest = NULL;
+    for( size_t i = 0; i + 2 < i_string; i++ )
+    {
+        search_list_t *p_list =
+            SearchListGet( p_search, SearchTrigram( &p_string[i] ), false );
+        if( p_list == NULL )
+        {
+            p_rarest = NULL;
+            break;
+        }
+        if( p_rarest == NULL || p_list->i_count < p_rarest->i_count )
+            p_rarest = p_list;
+    }
+
+    /* Collect the matching items, and the nodes up to the root */
+    playlist_item_t **pp_enabled = NULL;
+    size_t i_enabled = 0, i_enabled_size = 0;
+
+    const unsigned i_mark = ++p_search->i_mark;
+    for( size_t i = 0; p_rarest != NULL && i < p_rarest->i_count; i++ )
+    {
+        search_key_t *p_key = SearchKeyGet( p_search, p_rarest->pp_inputs[i] );
+        if( p_key == NULL || p_key->i_mark == i_mark ||
+            !SearchKeyMatch( p_key, p_string, i_string ) )
+            continue;
+        p_key->i_mark = i_mark;
+
+        playlist_item_t *p_item =
+            playlist_ItemGetByInput( p_playlist, p_key->p_input );
+        if( p_item == NULL )
+            continue;
+
+        if( !b_recursive )
+        {
+            if( p_item->p_parent == p_root &&
+                SearchEnabledAppend( &pp_enabled, &i_enabled, &i_enabled_size,
+                                     p_item ) )
+                goto error;
+            continue;
+        }
+
+        /* Enable the item and its parents if it is below the root */
+        playlist_item_t *p_parent = p_item->p_parent;
+        while( p_parent != NULL && p_parent != p_root )
+            p_parent = p_parent->p_parent;
+        if( p_parent == NULL )
+            continue;
+        for( ; p_item != p_root; p_item = p_item->p_parent )
+            if( SearchEnabledAppend( &pp_enabled, &i_enabled, &i_enabled_size,
+                                     p_item ) )
+                goto error;
+    }
+
+    qsort( pp_enabled, i_enabled, sizeof(*pp_enabled), SearchItemCmpId );
+    size_t i_unique = 0;
+    for( size_t i = 0; i < i_enabled; i++ )
+        if( i_unique == 0 || pp_enabled[i_unique - 1] != pp_enabled[i] )
+            pp_enabled[i_unique++] = pp_enabled[i];
+    i_enabled = i_unique;
+
+    int *pi_enabled = malloc( ( i_enabled ? i_enabled : 1 ) * sizeof(int) );
+    if( unlikely(pi_enabled == NULL) )
+        goto error;
+    for( size_t i = 0; i < i_enabled; i++ )
+        pi_enabled[i] = pp_enabled[i]->i_id;
+
+    if( p_search->i_enabled_root == p_root->i_id &&
+        p_search->b_enabled_recursive == b_recursive )
+    {
+        /* Only flag the items whose state changed since the last search */
+        size_t i_old = 0, i_new = 0;
+        while( i_old < p_search->i_enabled || i_new < i_enabled )
+        {
+            if( i_new == i_enabled ||
+                ( i_old < p_search->i_enabled &&
+                  p_search->pi_enabled[i_old] < pi_enabled[i_new] ) )
+            {
+                playlist_item_t *p_item = playlist_ItemGetById( p_playlist,
+                                            p_search->pi_enabled[i_old] );
+                if( p_item != NULL )
+                    p_item->i_flags |= PLAYLIST_DBL_FLAG;
+                i_old++;
+            }
+            else if( i_old == p_search->i_enabled ||
+                     pi_enabled[i_new] < p_search->pi_enabled[i_old] )
+                pp_enabled[i_new++]->i_flags &= ~PLAYLIST_DBL_FLAG;
+            else
+            {
+                i_old++;
+                i_new++;
+            }
+        }
+    }
+    else
+    {
+        if( b_recursive )
+            playlist_LiveSearchDisable( p_root );
+        else
+            for( int i = 0; i < p_root->i_children; i++ )
+                p_root->pp_children[i]->i_flags |= PLAYLIST_DBL_FLAG;
+        for( size_t i = 0; i < i_enabled; i++ )
+            pp_enabled[i]->i_flags &= ~PLAYLIST_DBL_FLAG;
+    }
+
+    free( p_search->pi_enabled );
+    p_search->pi_enabled = pi_enabled;
+    p_search->i_enabled = i_enabled;
+    p_search->i_enabled_root = p_root->i_id;
+    p_search->b_enabled_recursive = b_recursive;
+
+    free( pp_enabled );
+    free( p_string );
+    return true;
+
+error:
+    free( pp_enabled );
+    free( p_string );
+    p_search->i_enabled_root = -1;
+    return false;
+}
+
 /**
  * Launch the recursive search in the playlist
  * @param p_playlist: the playlist
@@ -122,9 +821,19 @@ int playlist_LiveSearchUpdate( playlist_t *p_playlist, playlist_item_t *p_root,
     PL_ASSERT_LOCKED;
     pl_priv(p_playlist)->b_reset_currently_playing = true;
     if( *psz_string )
-        playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
+    {
+        if( !playlist_LiveSearchIndexed( p_playlist, p_root, psz_string,
+                                         b_recursive ) )
+        {
+            playlist_SearchIndexTreeChanged( pl_priv(p_playlist)->search );
+            playlist_LiveSearchUpdateInternal( p_root, psz_string, b_recursive );
+        }
+    }
     else
+    {
+        playlist_SearchIndexTreeChanged( pl_priv(p_playlist)->search );
         playlist_LiveSearchClean( p_root );
+    }
     vlc_cond_signal( &pl_priv(p_playlist)->signal );
     return VLC_SUCCESS;
 }
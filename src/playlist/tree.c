@@ -86,35 +86,146 @@ playlist_item_t * playlist_NodeCreate( playlist_t *p_playlist,
 }
 
 /**
- * Remove all the children of a node and removes the node
+ * Compare pointers to playlist items, to sort and search sets of items
+ */
+int playlist_ItemCmpPtr( const void *a, const void *b )
+{
+    uintptr_t pa = (uintptr_t)*(playlist_item_t *const *)a;
+    uintptr_t pb = (uintptr_t)*(playlist_item_t *const *)b;
+
+    return (pa > pb) - (pa < pb);
+}
+
+static bool playlist_ItemInSet( playlist_item_t *p_item,
+                                playlist_item_t *const *pp_set, size_t i_set )
+{
+    return bsearch( &p_item, pp_set, i_set, sizeof(*pp_set),
+                    playlist_ItemCmpPtr ) != NULL;
+}
+
+/**
+ * Remove the children belonging to a set from a node, in a single pass
  *
- * \param p_playlist the playlist
- * \param p_root the node
+ * \param p_node the node
+ * \param pp_set the items to remove, sorted by address
+ * \param i_set the number of items to remove
+ * \param pi_pos a position in the node to keep pointing to the same child,
+ *        or NULL
  */
-void playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
-                          bool b_force )
+static void playlist_NodeRemoveSet( playlist_item_t *p_node,
+                                    playlist_item_t *const *pp_set,
+                                    size_t i_set, int *pi_pos )
 {
-    PL_ASSERT_LOCKED;
+    int i_kept = 0, i_pos = pi_pos != NULL ? *pi_pos : 0;
 
-    /* Delete the children */
-    for( int i = p_root->i_children - 1 ; i >= 0; i-- )
-        playlist_NodeDelete( p_playlist, p_root->pp_children[i], b_force );
+    for( int i = 0; i < p_node->i_children; i++ )
+    {
+        playlist_item_t *p_child = p_node->pp_children[i];
+        if( !playlist_ItemInSet( p_child, pp_set, i_set ) )
+            p_node->pp_children[i_kept++] = p_child;
+        else if( pi_pos != NULL && i < *pi_pos )
+            i_pos--;
+    }
+
+    p_node->i_children = i_kept;
+    if( i_kept == 0 )
+    {
+        free( p_node->pp_children );
+        p_node->pp_children = NULL;
+    }
+    if( pi_pos != NULL )
+        *pi_pos = i_pos;
+}
+
+/**
+ * Detach a set of items from their parents
+ *
+ * Each parent is only walked once, however many of its children are removed.
+ *
+ * \param pp_set the items to detach, sorted by address
+ * \param i_set the number of items
+ * \param p_node a node to adjust a position into, or NULL
+ * \param pi_pos the position in p_node, see playlist_NodeRemoveSet()
+ */
+void playlist_ItemsDetach( playlist_item_t *const *pp_set, size_t i_set,
+                           playlist_item_t *p_node, int *pi_pos )
+{
+    playlist_item_t **pp_parents = malloc( i_set * sizeof(*pp_parents) );
+    size_t i_parents = 0;
+
+    if( unlikely(pp_parents == NULL) )
+    {
+        /* Detach one by one */
+        for( size_t i = 0; i < i_set; i++ )
+        {
+            playlist_item_t *p_parent = pp_set[i]->p_parent;
+            if( p_parent != NULL )
+                playlist_NodeRemoveSet( p_parent, &pp_set[i], 1,
+                                        p_parent == p_node ? pi_pos : NULL );
+        }
+        return;
+    }
+
+    for( size_t i = 0; i < i_set; i++ )
+        if( pp_set[i]->p_parent != NULL )
+            pp_parents[i_parents++] = pp_set[i]->p_parent;
+    qsort( pp_parents, i_parents, sizeof(*pp_parents), playlist_ItemCmpPtr );
+
+    for( size_t i = 0; i < i_parents; i++ )
+    {
+        if( i > 0 && pp_parents[i] == pp_parents[i - 1] )
+            continue;
+        playlist_NodeRemoveSet( pp_parents[i], pp_set, i_set,
+                                pp_parents[i] == p_node ? pi_pos : NULL );
+    }
+    free( pp_parents );
+}
+
+/**
+ * Delete the children of a node, then the node itself
+ *
+ * The deleted items are announced and collected for release, but are
+ * neither removed from the playlist arrays nor from the children of the
+ * parent of p_root, so that this can be done once for all of them.
+ *
+ * \return true if p_root was deleted
+ */
+static bool playlist_NodeDeleteInternal( playlist_t *p_playlist,
+                                         playlist_item_t *p_root, bool b_force,
+                                         playlist_item_array_t *p_deleted )
+{
+    /* Delete the children, keeping the undeletable ones at the end */
+    if( p_root->i_children > 0 )
+    {
+        int i_kept = p_root->i_children;
+
+        for( int i = p_root->i_children - 1 ; i >= 0; i-- )
+        {
+            playlist_item_t *p_child = p_root->pp_children[i];
+            if( !playlist_NodeDeleteInternal( p_playlist, p_child, b_force,
+                                              p_deleted ) )
+                p_root->pp_children[--i_kept] = p_child;
+        }
+
+        p_root->i_children -= i_kept;
+        if( p_root->i_children > 0 )
+            memmove( p_root->pp_children, p_root->pp_children + i_kept,
+                     p_root->i_children * sizeof(*p_root->pp_children) );
+        else
+        {
+            free( p_root->pp_children );
+            p_root->pp_children = NULL;
+        }
+    }
 
     /* Delete the node */
     if( p_root->i_flags & PLAYLIST_RO_FLAG && !b_force )
-        return;
+        return false;
 
     pl_priv(p_playlist)->b_reset_currently_playing = true;
 
-    int i;
     var_SetAddress( p_playlist, "playlist-item-deleted", p_root );
 
-    if( p_root->i_children == -1 ) {
-        ARRAY_BSEARCH( p_playlist->items,->i_id, int, p_root->i_id, i );
-        if( i != -1 )
-            ARRAY_REMOVE( p_playlist->items, i );
-    }
-
     /* Check if it is the current item */
     if( get_current_status_item( p_playlist ) == p_root )
     {
@@ -125,51 +236,207 @@ void playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
         set_current_status_item( p_playlist, NULL );
     }
 
-    for( i = 0; i < p_playlist->current.i_size; i++ )
-        if( p_playlist->current.p_elems[i] == p_root )
-            ARRAY_REMOVE( p_playlist->current, i );
-    for( i = 0; i < p_playlist->current.i_size; i++ )
-        assert( p_playlist->current.p_elems[i] != p_root );
-
     PL_DEBUG( "deleting item `%s'", p_root->p_input->psz_name );
 
-    /* Remove the item from its parent */
-    playlist_item_t *p_parent = p_root->p_parent;
-    if( p_parent != NULL )
+    ARRAY_APPEND( (*p_deleted), p_root );
+    return true;
+}
+
+/**
+ * Remove the items of a set from a playlist array, keeping the order
+ */
+static void playlist_ArrayRemoveSet( playlist_item_array_t *p_array,
+                                     playlist_item_t *const *pp_set,
+                                     size_t i_set )
+{
+    int i_kept = 0;
+
+    for( int i = 0; i < p_array->i_size; i++ )
     {
-        for( int i = 0; i < p_parent->i_children ; i++ )
+        playlist_item_t *p_item = p_array->p_elems[i];
+        if( !playlist_ItemInSet( p_item, pp_set, i_set ) )
+            p_array->p_elems[i_kept++] = p_item;
+    }
+    p_array->i_size = i_kept;
+}
+
+/**
+ * Remove several items and their children
+ *
+ * The playlist arrays and the children of each parent are updated once for
+ * the whole batch, so that this is linear in the size of the playlist,
+ * whatever the number of removed items. Items below another listed item
+ * and duplicates are ignored.
+ *
+ * \param p_playlist the playlist
+ * \param pp_items the items or nodes to remove
+ * \param i_items the number of items
+ * \param b_force also remove read-only items
+ */
+void playlist_NodesDelete( playlist_t *p_playlist,
+                           playlist_item_t *const *pp_items, size_t i_items,
+                           bool b_force )
+{
+    PL_ASSERT_LOCKED;
+
+    if( i_items == 0 )
+        return;
+
+    /* The listed items, sorted to look them up, and what became of them */
+    enum { ITEM_PENDING, ITEM_SKIPPED, ITEM_DELETED };
+    playlist_item_t *p_one, **pp_sorted = &p_one;
+    uint8_t i_one = ITEM_PENDING, *pi_state = &i_one;
+    if( i_items > 1 )
+    {
+        pp_sorted = malloc( i_items * sizeof(*pp_sorted) );
+        pi_state = calloc( i_items, sizeof(*pi_state) );
+        if( unlikely(pp_sorted == NULL || pi_state == NULL) )
         {
-            if( p_parent->pp_children[i] == p_root )
-            {
-                REMOVE_ELEM( p_parent->pp_children, p_parent->i_children, i );
-                assert( p_root->p_parent == p_parent );
-            }
+            free( pp_sorted );
+            free( pi_state );
+            for( size_t i = i_items; i > 0; i-- )
+                playlist_NodesDelete( p_playlist, &pp_items[i - 1], 1,
+                                      b_force );
+            return;
         }
     }
+    memcpy( pp_sorted, pp_items, i_items * sizeof(*pp_sorted) );
+    qsort( pp_sorted, i_items, sizeof(*pp_sorted), playlist_ItemCmpPtr );
 
-    playlist_ItemRelease( p_playlist, p_root );
+    playlist_item_array_t deleted;
+    ARRAY_INIT( deleted );
+
+    for( size_t i = i_items; i > 0; i-- )
+    {
+        playlist_item_t *p_item = pp_items[i - 1];
+        playlist_item_t **pp = bsearch( &p_item, pp_sorted, i_items,
+                                        sizeof(*pp_sorted),
+                                        playlist_ItemCmpPtr );
+        uint8_t *p_state = &pi_state[pp - pp_sorted];
+        if( *p_state != ITEM_PENDING )
+            continue;
+        *p_state = ITEM_SKIPPED;
+
+        bool b_nested = false;
+        for( playlist_item_t *p_up = p_item->p_parent; p_up != NULL && !b_nested;
+             p_up = p_up->p_parent )
+            b_nested = playlist_ItemInSet( p_up, pp_sorted, i_items );
+        if( b_nested )
+            continue;
+
+        if( playlist_NodeDeleteInternal( p_playlist, p_item, b_force,
+                                         &deleted ) )
+            *p_state = ITEM_DELETED;
+    }
+
+    /* Remove the listed deleted items from their parents */
+    size_t i_top = 0;
+    for( size_t i = 0; i < i_items; i++ )
+        if( pi_state[i] == ITEM_DELETED )
+            pp_sorted[i_top++] = pp_sorted[i];
+    playlist_ItemsDetach( pp_sorted, i_top, NULL, NULL );
+    if( i_items > 1 )
+    {
+        free( pp_sorted );
+        free( pi_state );
+    }
+
+    if( deleted.i_size > 0 )
+    {
+        qsort( deleted.p_elems, deleted.i_size, sizeof(*deleted.p_elems),
+               playlist_ItemCmpPtr );
+        playlist_ArrayRemoveSet( &p_playlist->items,
+                                 deleted.p_elems, deleted.i_size );
+        playlist_ArrayRemoveSet( &p_playlist->current,
+                                 deleted.p_elems, deleted.i_size );
+
+        for( int i = 0; i < deleted.i_size; i++ )
+            playlist_ItemRelease( p_playlist, deleted.p_elems[i] );
+    }
+    ARRAY_RESET( deleted );
+}
+
+/**
+ * Remove all the children of a node and removes the node
+ *
+ * \param p_playlist the playlist
+ * \param p_root the node
+ */
+void playlist_NodeDelete( playlist_t *p_playlist, playlist_item_t *p_root,
+                          bool b_force )
+{
+    playlist_NodesDelete( p_playlist, &p_root, 1, b_force );
 }
 
 int playlist_NodeInsert( playlist_t *p_playlist,
                          playlist_item_t *p_item,
                          playlist_item_t *p_parent,
                          int i_position )
+{
+    return playlist_NodeInsertMany( p_playlist, &p_item, 1, p_parent,
+                                    i_position );
+}
+
+/**
+ * Insert several items at once in a node, keeping their flags
+ *
+ * \param pp_items the items to insert, in order
+ * \param i_items the number of items
+ * \param p_parent the node
+ * \param i_position the position of the first item, -1 to append
+ */
+void playlist_NodeAttachMany( playlist_t *p_playlist,
+                              playlist_item_t *const *pp_items, int i_items,
+                              playlist_item_t *p_parent, int i_position )
 {
     PL_ASSERT_LOCKED;
-    (void)p_playlist;
     assert( p_parent && p_parent->i_children != -1 );
     if( i_position == -1 ) i_position = p_parent->i_children ;
     assert( i_position <= p_parent->i_children);
 
-    INSERT_ELEM( p_parent->pp_children,
-                 p_parent->i_children,
-                 i_position,
-                 p_item );
-    p_item->p_parent = p_parent;
+    if( i_items <= 0 )
+        return;
+
+    playlist_SearchIndexTreeChanged( pl_priv(p_playlist)->search );
+
+    playlist_item_t **pp_children =
+        realloc( p_parent->pp_children,
+                 (p_parent->i_children + i_items) * sizeof(*pp_children) );
+    if( unlikely(pp_children == NULL) )
+        abort(); /* like INSERT_ELEM() */
+
+    memmove( pp_children + i_position + i_items, pp_children + i_position,
+             (p_parent->i_children - i_position) * sizeof(*pp_children) );
+    memcpy( pp_children + i_position, pp_items,
+            i_items * sizeof(*pp_children) );
+    p_parent->pp_children = pp_children;
+    p_parent->i_children += i_items;
+
+    for( int i = 0; i < i_items; i++ )
+        pp_items[i]->p_parent = p_parent;
+}
+
+/**
+ * Insert several items at once in a node
+ *
+ * The items inherit the special flags of the node.
+ *
+ * \param pp_items the items to insert, in order
+ * \param i_items the number of items
+ * \param p_parent the node
+ * \param i_position the position of the first item, -1 to append
+ */
+int playlist_NodeInsertMany( playlist_t *p_playlist,
+                             playlist_item_t *const *pp_items, int i_items,
+                             playlist_item_t *p_parent, int i_position )
+{
+    playlist_NodeAttachMany( p_playlist, pp_items, i_items, p_parent,
+                             i_position );
 
     /* Inherit special flags from parent (sd cases) */
     if( ( p_parent->i_flags & PLAYLIST_NO_INHERIT_FLAG ) == 0 )
-        p_item->i_flags |= (p_parent->i_flags & (PLAYLIST_RO_FLAG | PLAYLIST_SKIP_FLAG));
+        for( int i = 0; i < i_items; i++ )
+            pp_items[i]->i_flags |= (p_parent->i_flags & (PLAYLIST_RO_FLAG | PLAYLIST_SKIP_FLAG));
 
     return VLC_SUCCESS;
 }
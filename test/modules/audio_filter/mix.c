@@ -0,0 +1,118 @@
+/*****************************************************************************
+ * mix.c: test the matrix mixing of audio channels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+#include "../modules/audio_filter/channel_mixer/mix.c"
+
+#define MAX_FRAMES 37
+
+static float Random( void )
+{
+    return rand() / (float)RAND_MAX * 2.f - 1.f;
+}
+
+/* Checks a mixing function against the scalar definition, out of place, and
+ * in place when the output frames are not larger than the input ones */
+static void test_mix( const char *psz_name, mix_fn_t pf_mix, const mix_t *p_ref,
+                      const float *p_src, size_t i_frames )
+{
+    const unsigned i_in = p_ref->i_in, i_out = p_ref->i_out;
+    float expected[MAX_FRAMES * AOUT_CHAN_MAX];
+    float dst[MAX_FRAMES * AOUT_CHAN_MAX + 1];
+
+    for( size_t f = 0; f < i_frames; f++ )
+        for( unsigned o = 0; o < i_out; o++ )
+        {
+            double sum = 0.;
+            for( unsigned i = 0; i < i_in; i++ )
+                sum += (double)p_src[f * i_in + i] * p_ref->p_coefs[o * i_in + i];
+            expected[f * i_out + o] = sum;
+        }
+
+    for( int b_in_place = 0; b_in_place < 2; b_in_place++ )
+    {
+        if( b_in_place && i_out > i_in )
+            break;
+
+        /* canary after the output frames */
+        dst[i_frames * i_out] = 42.f;
+        if( b_in_place )
+        {
+            memcpy( dst, p_src, i_frames * i_in * sizeof (float) );
+            pf_mix( p_ref, dst, dst, i_frames );
+        }
+        else
+            pf_mix( p_ref, p_src, dst, i_frames );
+
+        if( !b_in_place )
+            assert( dst[i_frames * i_out] == 42.f );
+        for( size_t j = 0; j < i_frames * i_out; j++ )
+            if( fabsf( dst[j] - expected[j] ) > 1e-5f )
+            {
+                fprintf( stderr, "%s: %u to %u channels, %zu frames%s: "
+                         "sample %zu is %f instead of %f\n", psz_name, i_in,
+                         i_out, i_frames, b_in_place ? " in place" : "",
+                         j, dst[j], expected[j] );
+                abort();
+            }
+    }
+}
+
+int main( void )
+{
+    float coefs[AOUT_CHAN_MAX * AOUT_CHAN_MAX];
+    float src[MAX_FRAMES * AOUT_CHAN_MAX];
+    mix_t mix;
+
+    srand( 0 );
+    for( size_t j = 0; j < ARRAY_SIZE(src); j++ )
+        src[j] = Random();
+
+    for( unsigned i_in = 1; i_in <= AOUT_CHAN_MAX; i_in++ )
+        for( unsigned i_out = 1; i_out <= AOUT_CHAN_MAX; i_out++ )
+        {
+            for( unsigned j = 0; j < i_in * i_out; j++ )
+                coefs[j] = (rand() % 4) ? Random() : 0.f;
+            MixInit( &mix, coefs, i_in, i_out );
+
+            for( size_t i_frames = 0; i_frames <= MAX_FRAMES; i_frames++ )
+            {
+                test_mix( "C", MixC, &mix, src, i_frames );
+#ifdef CAN_COMPILE_SSE_MIX
+                if( vlc_CPU_SSE() )
+                    test_mix( "SSE", MixSSE, &mix, src, i_frames );
+#endif
+#ifdef CAN_COMPILE_AVX2_MIX
+                if( vlc_CPU_AVX2() )
+                    test_mix( "AVX2", MixAVX2, &mix, src, i_frames );
+#endif
+                test_mix( "default", mix.pf_mix, &mix, src, i_frames );
+            }
+        }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+/*****************************************************************************
+ * thumbnail.c: thumbnail extraction unit test
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#undef NDEBUG
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_thumbnail.h>
+#include <vlc_url.h>
+#include "../../../lib/libvlc_internal.h"
+#include "../../libvlc/test.h"
+
+#include <vlc/vlc.h>
+
+static const uint8_t png_signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+static void check_images(const vlc_thumbnail_job_t *job, size_t expected)
+{
+    size_t count = 0;
+
+    assert(job->i_images == expected);
+    assert(job->pp_images != NULL || job->i_times == 0);
+    for (size_t i = 0; i < job->i_times; i++)
+    {
+        const block_t *image = job->pp_images[i];
+
+        if (image == NULL)
+            continue;
+        assert(image->i_buffer > sizeof (png_signature));
+        assert(!memcmp(image->p_buffer, png_signature,
+                       sizeof (png_signature)));
+        count++;
+    }
+    assert(count == expected);
+}
+
+static void clean_images(vlc_thumbnail_job_t *job)
+{
+    for (size_t i = 0; i < job->i_times && job->pp_images != NULL; i++)
+        if (job->pp_images[i] != NULL)
+            block_Release(job->pp_images[i]);
+    free(job->pp_images);
+}
+
+int main(void)
+{
+    test_init();
+
+    libvlc_instance_t *vlc = libvlc_new(test_defaults_nargs,
+                                        test_defaults_args);
+    assert(vlc != NULL);
+    vlc_object_t *obj = VLC_OBJECT(vlc->p_libvlc_int);
+
+    if (!module_exists("jpeg") || !module_exists("png"))
+    {
+        libvlc_release(vlc);
+        return 77;
+    }
+
+    char *url = vlc_path2uri(test_default_video, NULL);
+    assert(url != NULL);
+
+    video_format_t fmt;
+    video_format_Init(&fmt, VLC_CODEC_PNG);
+    fmt.i_width = 32;
+
+    const mtime_t times[] = { 0, 0 };
+
+    /* One media */
+    vlc_thumbnail_job_t job = {
+        .psz_url = url, .pi_times = times, .i_times = ARRAY_SIZE(times),
+    };
+    int val = vlc_thumbnail_Extract(obj, &job, &fmt);
+    assert(val == VLC_SUCCESS);
+    /* The encoding depends on the available scalers and converters */
+    assert(job.i_images <= job.i_times);
+    check_images(&job, job.i_images);
+    size_t expected = job.i_images;
+    clean_images(&job);
+
+    /* A media that cannot be opened */
+    vlc_thumbnail_job_t missing = {
+        .psz_url = "file:///nonexistent/thumbnail.jpg",
+        .pi_times = times, .i_times = ARRAY_SIZE(times),
+    };
+    val = vlc_thumbnail_Extract(obj, &missing, &fmt);
+    assert(val != VLC_SUCCESS);
+    check_images(&missing, 0);
+    clean_images(&missing);
+
+    /* Several media, on several threads */
+    vlc_thumbnail_job_t jobs[4];
+    for (size_t i = 0; i < ARRAY_SIZE(jobs); i++)
+        jobs[i] = (i == 1) ? missing : job;
+    vlc_thumbnail_ExtractMany(obj, jobs, ARRAY_SIZE(jobs), &fmt, 2);
+    for (size_t i = 0; i < ARRAY_SIZE(jobs); i++)
+    {
+        check_images(&jobs[i], (i == 1) ? 0 : expected);
+        clean_images(&jobs[i]);
+    }
+
+    free(url);
+    libvlc_release(vlc);
+    return 0;
+}